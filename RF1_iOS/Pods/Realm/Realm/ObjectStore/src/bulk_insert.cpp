@@ -0,0 +1,237 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "bulk_insert.hpp"
+
+#include "object_schema.hpp"
+#include "object_store.hpp"
+#include "schema.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/table.hpp>
+
+#if REALM_ENABLE_SYNC
+#include <realm/sync/object.hpp>
+#endif // REALM_ENABLE_SYNC
+
+#include <unordered_set>
+
+using namespace realm;
+
+BulkInserter::BulkInserter(std::shared_ptr<Realm> realm, StringData object_type,
+                           std::vector<std::string> properties)
+: m_realm(std::move(realm))
+, m_object_type(object_type)
+, m_property_names(std::move(properties))
+{
+    resolve();
+}
+
+void BulkInserter::resolve()
+{
+    auto& schema = m_realm->schema();
+    auto it = schema.find(m_object_type);
+    if (it == schema.end())
+        throw std::logic_error(util::format("Object type '%1' not found in schema.", m_object_type));
+    auto& object_schema = *it;
+
+    m_table = ObjectStore::table_for_object_type(m_realm->read_group(), m_object_type);
+    m_properties.clear();
+    m_properties.reserve(m_property_names.size());
+    m_primary_key = npos;
+    for (auto& name : m_property_names) {
+        auto prop = object_schema.property_for_name(name);
+        if (!prop)
+            throw std::logic_error(util::format("Property '%1.%2' does not exist", m_object_type, name));
+        if (is_array(prop->type) || prop->type == PropertyType::Object || prop->type == PropertyType::LinkingObjects
+            || (prop->type & ~PropertyType::Flags) == PropertyType::Any)
+            throw std::logic_error(util::format("Property '%1.%2' of type '%3' cannot be bulk inserted",
+                                                m_object_type, name, string_for_property_type(prop->type)));
+        if (prop->is_primary)
+            m_primary_key = m_properties.size();
+        m_properties.push_back(*prop);
+    }
+
+    if (m_primary_key == npos && object_schema.primary_key_property())
+        throw std::logic_error(util::format("Bulk inserts of '%1' must include its primary key '%2'",
+                                            m_object_type, object_schema.primary_key));
+    m_schema_generation = m_realm->schema_generation();
+}
+
+void BulkInserter::validate(size_t count, std::vector<BulkColumn> const& columns) const
+{
+    if (columns.size() != m_properties.size())
+        throw std::invalid_argument(util::format("Expected %1 columns for bulk insert, got %2",
+                                                 m_properties.size(), columns.size()));
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+        auto& prop = m_properties[i];
+        auto& column = columns[i];
+        if (column.m_type != (prop.type & ~PropertyType::Flags))
+            throw std::invalid_argument(util::format("Bulk insert column for '%1.%2' has type '%3' but the property has type '%4'",
+                                                     m_object_type, prop.name,
+                                                     string_for_property_type(column.m_type),
+                                                     string_for_property_type(prop.type)));
+        if (is_nullable(prop.type))
+            continue;
+
+        for (size_t row = 0; row < count; ++row) {
+            bool null = column.is_null(row);
+            switch (column.m_type) {
+                case PropertyType::String: null = null || column.get<StringData>(row).is_null(); break;
+                case PropertyType::Data:   null = null || column.get<BinaryData>(row).is_null(); break;
+                case PropertyType::Date:   null = null || column.get<Timestamp>(row).is_null(); break;
+                default: break;
+            }
+            if (null)
+                throw std::invalid_argument(util::format("Bulk insert of '%1' has a null value for the non-optional property '%2'",
+                                                         m_object_type, prop.name));
+        }
+    }
+
+    if (m_primary_key == npos)
+        return;
+
+    // Check up front so that a duplicate doesn't leave a partial insert behind
+    auto& prop = m_properties[m_primary_key];
+    auto& column = columns[m_primary_key];
+    auto duplicate = [&](auto&& value) {
+        throw std::logic_error(util::format("Attempting to create an object of type '%1' with an existing primary key value '%2'.",
+                                            m_object_type, value));
+    };
+    if (column.m_type == PropertyType::Int) {
+        std::unordered_set<int64_t> seen;
+        bool seen_null = false;
+        for (size_t row = 0; row < count; ++row) {
+            if (column.is_null(row)) {
+                if (seen_null || m_table->find_first_null(prop.table_column) != npos)
+                    duplicate("null");
+                seen_null = true;
+                continue;
+            }
+            int64_t value = column.get<int64_t>(row);
+            if (!seen.insert(value).second || m_table->find_first_int(prop.table_column, value) != npos)
+                duplicate(value);
+        }
+    }
+    else {
+        std::unordered_set<std::string> seen;
+        bool seen_null = false;
+        for (size_t row = 0; row < count; ++row) {
+            StringData value = column.is_null(row) ? StringData() : column.get<StringData>(row);
+            if (value.is_null()) {
+                if (seen_null || m_table->find_first_null(prop.table_column) != npos)
+                    duplicate("null");
+                seen_null = true;
+                continue;
+            }
+            if (!seen.insert(std::string(value)).second || m_table->find_first_string(prop.table_column, value) != npos)
+                duplicate(value);
+        }
+    }
+}
+
+size_t BulkInserter::create_rows(size_t count, std::vector<BulkColumn> const& columns)
+{
+    size_t first = m_table->size();
+    if (m_primary_key == npos) {
+#if REALM_ENABLE_SYNC
+        sync::TableInfoCache table_info(m_realm->read_group());
+        for (size_t i = 0; i < count; ++i)
+            sync::create_object(table_info, *m_table);
+#else
+        m_table->add_empty_row(count);
+#endif // REALM_ENABLE_SYNC
+        return first;
+    }
+
+    // Rows with a primary key are created one at a time so that no two rows
+    // ever share the default value while their keys are being set
+    auto& column = columns[m_primary_key];
+#if REALM_ENABLE_SYNC
+    sync::TableInfoCache table_info(m_realm->read_group());
+#else
+    size_t col = m_properties[m_primary_key].table_column;
+#endif // REALM_ENABLE_SYNC
+    for (size_t i = 0; i < count; ++i) {
+        if (column.m_type == PropertyType::Int) {
+#if REALM_ENABLE_SYNC
+            util::Optional<int64_t> value;
+            if (!column.is_null(i))
+                value = column.get<int64_t>(i);
+            sync::create_object_with_primary_key(table_info, *m_table, value);
+#else
+            size_t row = m_table->add_empty_row();
+            if (column.is_null(i))
+                m_table->set_null_unique(col, row);
+            else
+                m_table->set_unique(col, row, column.get<int64_t>(i));
+#endif // REALM_ENABLE_SYNC
+        }
+        else {
+            StringData value = column.is_null(i) ? StringData() : column.get<StringData>(i);
+#if REALM_ENABLE_SYNC
+            sync::create_object_with_primary_key(table_info, *m_table, value);
+#else
+            size_t row = m_table->add_empty_row();
+            m_table->set_unique(col, row, value);
+#endif // REALM_ENABLE_SYNC
+        }
+    }
+    return first;
+}
+
+void BulkInserter::set_column(Property const& prop, BulkColumn const& column, size_t first_row, size_t count)
+{
+    auto& table = *m_table;
+    size_t col = prop.table_column;
+    for (size_t i = 0; i < count; ++i) {
+        size_t row = first_row + i;
+        if (column.is_null(i)) {
+            table.set_null(col, row);
+            continue;
+        }
+        switch (column.m_type) {
+            case PropertyType::Int:    table.set_int(col, row, column.get<int64_t>(i)); break;
+            case PropertyType::Bool:   table.set_bool(col, row, column.get<bool>(i)); break;
+            case PropertyType::Float:  table.set_float(col, row, column.get<float>(i)); break;
+            case PropertyType::Double: table.set_double(col, row, column.get<double>(i)); break;
+            case PropertyType::String: table.set_string(col, row, column.get<StringData>(i)); break;
+            case PropertyType::Data:   table.set_binary(col, row, column.get<BinaryData>(i)); break;
+            case PropertyType::Date:   table.set_timestamp(col, row, column.get<Timestamp>(i)); break;
+            default: REALM_UNREACHABLE();
+        }
+    }
+}
+
+void BulkInserter::insert(size_t count, std::vector<BulkColumn> const& columns)
+{
+    m_realm->verify_in_write();
+    if (m_realm->schema_generation() != m_schema_generation)
+        resolve();
+    validate(count, columns);
+    if (count == 0)
+        return;
+
+    size_t first_row = create_rows(count, columns);
+    // Column-at-a-time so that each loop only touches one column's arrays
+    for (size_t i = 0; i < m_properties.size(); ++i) {
+        if (i != m_primary_key)
+            set_column(m_properties[i], columns[i], first_row, count);
+    }
+}
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/async_write_queue.hpp"
+
+#include <algorithm>
+
+using namespace realm;
+using namespace realm::_impl;
+
+// How long the writer thread keeps its Realm open after running out of writes
+static const auto s_idle_timeout = std::chrono::seconds(1);
+
+AsyncWriteQueue::AsyncWriteQueue(Realm::Config config)
+: m_state(std::make_shared<State>())
+{
+    // The writer thread needs a Realm instance of its own
+    config.execution_context = util::none;
+    config.cache = true;
+    m_state->config = std::move(config);
+}
+
+AsyncWriteQueue::~AsyncWriteQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->stop = true;
+    }
+    m_state->cv.notify_all();
+
+    if (!m_thread.joinable())
+        return;
+    // The writer thread closing its Realm can release the last reference to
+    // the coordinator which owns this queue, in which case it'll exit on its
+    // own once it sees that it's been stopped
+    if (m_thread.get_id() == std::this_thread::get_id())
+        m_thread.detach();
+    else
+        m_thread.join();
+}
+
+void AsyncWriteQueue::push(Realm::AsyncWriteFunction write, Realm::AsyncWriteCompletion completion)
+{
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    m_state->writes.push_back({std::move(write), std::move(completion), std::chrono::steady_clock::now()});
+
+    if (m_state->thread_running) {
+        lock.unlock();
+        m_state->cv.notify_all();
+        return;
+    }
+
+    // The previous writer thread (if any) has exited or is about to
+    if (m_thread.joinable())
+        m_thread.join();
+    m_state->thread_running = true;
+    m_thread = std::thread(&AsyncWriteQueue::run, m_state);
+}
+
+void AsyncWriteQueue::run(std::shared_ptr<State> state)
+{
+    auto max_latency = state->config.async_write_max_latency;
+    auto batch_size = std::max<size_t>(state->config.async_write_batch_size, 1);
+    SharedRealm realm;
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true) {
+        if (state->writes.empty()) {
+            if (realm && !state->stop) {
+                state->cv.wait_for(lock, s_idle_timeout, [&] {
+                    return !state->writes.empty() || state->stop;
+                });
+            }
+            if (state->writes.empty()) {
+                if (!realm) {
+                    state->thread_running = false;
+                    return;
+                }
+                // Closing the Realm may destroy the AsyncWriteQueue, so only
+                // `state` can be used after this
+                lock.unlock();
+                realm->close();
+                realm.reset();
+                lock.lock();
+                continue;
+            }
+        }
+
+        // Give writes which are arriving in quick succession a chance to join
+        // this batch, for as long as the oldest one is allowed to wait
+        state->cv.wait_until(lock, state->writes.front().queued_at + max_latency, [&] {
+            return state->writes.size() >= batch_size || state->stop;
+        });
+
+        auto batch_end = state->writes.begin() + std::min(batch_size, state->writes.size());
+        std::vector<Write> batch(std::make_move_iterator(state->writes.begin()),
+                                 std::make_move_iterator(batch_end));
+        state->writes.erase(state->writes.begin(), batch_end);
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            if (!realm)
+                realm = Realm::get_shared_realm(state->config);
+            commit_batch(*realm, batch);
+        }
+        catch (...) {
+            error = std::current_exception();
+            if (realm && realm->is_in_transaction())
+                realm->cancel_transaction();
+        }
+        for (auto& write : batch) {
+            if (write.completion)
+                write.completion(error);
+        }
+
+        lock.lock();
+    }
+}
+
+void AsyncWriteQueue::commit_batch(Realm& realm, std::vector<Write>& batch)
+{
+    while (!batch.empty()) {
+        realm.begin_transaction();
+
+        auto failed = batch.end();
+        std::exception_ptr error;
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            try {
+                it->write(realm);
+            }
+            catch (...) {
+                error = std::current_exception();
+                failed = it;
+                break;
+            }
+        }
+
+        if (failed == batch.end()) {
+            realm.commit_transaction();
+            break;
+        }
+
+        // A single write can't be rolled back on its own, so discard the whole
+        // transaction and run the rest of the batch again without it
+        if (realm.is_in_transaction())
+            realm.cancel_transaction();
+        auto completion = std::move(failed->completion);
+        batch.erase(failed);
+        if (completion)
+            completion(error);
+    }
+}
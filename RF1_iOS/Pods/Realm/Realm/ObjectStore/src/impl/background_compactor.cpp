@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/background_compactor.hpp"
+
+#include "impl/realm_coordinator.hpp"
+
+#include <realm/util/file.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+BackgroundCompactor::BackgroundCompactor(Realm::Config config)
+: m_state(std::make_shared<State>())
+{
+    m_state->config = std::move(config);
+}
+
+BackgroundCompactor::~BackgroundCompactor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->stop = true;
+    }
+    m_state->cv.notify_all();
+
+    if (!m_thread.joinable())
+        return;
+    // The compactor thread releasing its reference to the coordinator which
+    // owns this compactor destroys it, in which case the thread is already
+    // on its way out
+    if (m_thread.get_id() == std::this_thread::get_id())
+        m_thread.detach();
+    else
+        m_thread.join();
+}
+
+void BackgroundCompactor::request(std::shared_ptr<RealmCoordinator> coordinator)
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    if (m_state->thread_running || m_state->stop)
+        return;
+
+    // The previous compactor thread (if any) has exited or is about to
+    if (m_thread.joinable())
+        m_thread.join();
+    m_state->thread_running = true;
+    m_state->retry = false;
+    m_thread = std::thread(&BackgroundCompactor::run, m_state, std::move(coordinator));
+}
+
+void BackgroundCompactor::retry()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->retry = true;
+    }
+    m_state->cv.notify_all();
+}
+
+void BackgroundCompactor::run(std::shared_ptr<State> state, std::shared_ptr<RealmCoordinator> coordinator)
+{
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->stop) {
+        lock.unlock();
+        bool released = coordinator->release_for_compaction();
+        lock.lock();
+        if (released)
+            break;
+
+        state->cv.wait(lock, [&] { return state->retry || state->stop; });
+        state->retry = false;
+    }
+    bool stopped = state->stop;
+    lock.unlock();
+
+    if (!stopped)
+        compact(state->config);
+
+    lock.lock();
+    state->thread_running = false;
+    lock.unlock();
+
+    // This may destroy the coordinator and with it the BackgroundCompactor,
+    // so only `state` can be used after this
+    coordinator.reset();
+}
+
+void BackgroundCompactor::compact(Realm::Config const& config)
+{
+    using Event = Realm::BackgroundCompactionEvent;
+    auto report = [&](Event::Kind kind, uint64_t file_size, uint64_t bytes_reclaimed, std::exception_ptr error) {
+        if (config.background_compaction_function)
+            config.background_compaction_function({kind, config.path, file_size, bytes_reclaimed, error});
+    };
+
+    try {
+        uint64_t size_before = util::File::exists(config.path) ? util::File(config.path).get_size() : 0;
+        report(Event::Kind::Started, size_before, 0, nullptr);
+
+        switch (Realm::compact_if_needed(config)) {
+            case Realm::CompactionResult::Compacted: {
+                uint64_t size_after = util::File(config.path).get_size();
+                report(Event::Kind::Finished, size_after, size_before > size_after ? size_before - size_after : 0, nullptr);
+                break;
+            }
+            case Realm::CompactionResult::NotNeeded:
+            case Realm::CompactionResult::FileInUse:
+                report(Event::Kind::Skipped, size_before, 0, nullptr);
+                break;
+        }
+    }
+    catch (...) {
+        report(Event::Kind::Failed, 0, 0, std::current_exception());
+    }
+}
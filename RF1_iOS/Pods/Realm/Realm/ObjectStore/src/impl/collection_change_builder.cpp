@@ -580,125 +580,129 @@ public:
         size_t j;
         // The length of this match
         size_t size;
-        // The number of rows in this block which were modified
-        size_t modified;
     };
     std::vector<Match> m_longest_matches;
 
     LongestCommonSubsequenceCalculator(std::vector<Row>& a, std::vector<Row>& b,
                                        size_t start_index,
-                                       IndexSet const& modifications)
-    : m_modified(modifications)
+                                       std::vector<bool> const& modified)
+    : m_modified(modified)
     , a(a), b(b)
     {
-        find_longest_matches(start_index, a.size(),
-                             start_index, b.size());
+        find_longest_matches(start_index);
         m_longest_matches.push_back({a.size(), b.size(), 0});
     }
 
 private:
-    IndexSet const& m_modified;
+    // Whether the row at each index in the new results was modified
+    std::vector<bool> const& m_modified;
 
     // The two arrays of rows being diffed
     // a is sorted by tv_index, b is sorted by row_index
     std::vector<Row> &a, &b;
 
-    // Find the longest matching range in (a + begin1, a + end1) and (b + begin2, b + end2)
-    // "Matching" is defined as "has the same row index"; the TV index is just
-    // there to let us turn an index in a/b into an index which can be reported
-    // in the output changeset.
+    // One element of a common subsequence: a[i] and b's row at index j have
+    // the same row index, and `prev` is the index of the preceding element
+    struct Link {
+        size_t i, j;
+        size_t prev;
+    };
+
+    // Best subsequences ending at or before each `j`, indexed from 1 so that
+    // a prefix maximum can be found in O(log N)
+    struct Best {
+        uint64_t score;
+        size_t link;
+    };
+
+    // Iterate over each `j` which has the same row index as a[i] and is at
+    // least begin, in descending order
+    template<typename Func>
+    void for_each_b_match(size_t i, size_t begin2, Func&& f)
+    {
+        size_t ai = a[i].row_index;
+        // Find the TV indicies at which this row appears in the new results
+        // There should always be at least one (or it would have been
+        // filtered out earlier), but there can be multiple if there are dupes
+        auto first = lower_bound(begin(b), end(b), ai,
+                                 [](auto lft, auto rgt) { return lft.row_index < rgt; });
+        REALM_ASSERT(first != end(b) && first->row_index == ai);
+        auto last = first;
+        while (last != end(b) && last->row_index == ai)
+            ++last;
+        while (last != first) {
+            size_t j = (--last)->tv_index;
+            if (j < begin2)
+                break; // b is sorted by tv_index within a row index
+            f(j);
+        }
+    }
+
+    // Find the longest common subsequence of the row indices in a and b from
+    // `begin` onwards, preferring the one which keeps the fewest modified rows
+    // in place when there are several of the same length.
     //
-    // This is done with the O(N) space variant of the dynamic programming
-    // algorithm for longest common subsequence, where N is the maximum number
-    // of the most common row index (which for everything but linkview-derived
-    // TVs will be 1).
-    Match find_longest_match(size_t begin1, size_t end1, size_t begin2, size_t end2)
+    // This is the Hunt-Szymanski reduction to finding the longest increasing
+    // sequence of `j` when iterating over the matching (i, j) pairs in order
+    // of `i`. With a Fenwick tree over `j` holding the best sequence ending at
+    // each `j`, it takes O((N + R) log N) time for R matching pairs, which for
+    // everything but linkview-derived TVs with duplicate rows is N.
+    void find_longest_matches(size_t begin)
     {
-        struct Length {
-            size_t j, len;
-        };
-        // The length of the matching block for each `j` for the previously checked row
-        std::vector<Length> prev;
-        // The length of the matching block for each `j` for the row currently being checked
-        std::vector<Length> cur;
-
-        // Calculate the length of the matching block *ending* at b[j], which
-        // is 1 if b[j - 1] did not match, and b[j - 1] + 1 otherwise.
-        auto length = [&](size_t j) -> size_t {
-            for (auto const& pair : prev) {
-                if (pair.j + 1 == j)
-                    return pair.len + 1;
+        if (begin >= a.size())
+            return;
+
+        size_t n = b.size() - begin;
+        std::vector<Best> tree(n + 1, Best{0, IndexSet::npos});
+        std::vector<Link> links;
+        links.reserve(a.size() - begin);
+
+        auto query = [&](size_t pos) { // best ending before pos
+            Best best{0, IndexSet::npos};
+            for (; pos > 0; pos -= pos & (0 - pos)) {
+                if (tree[pos].score > best.score)
+                    best = tree[pos];
             }
-            return 1;
+            return best;
         };
-
-        // Iterate over each `j` which has the same row index as a[i] and falls
-        // within the range begin2 <= j < end2
-        auto for_each_b_match = [&](size_t i, auto&& f) {
-            size_t ai = a[i].row_index;
-            // Find the TV indicies at which this row appears in the new results
-            // There should always be at least one (or it would have been
-            // filtered out earlier), but there can be multiple if there are dupes
-            auto it = lower_bound(begin(b), end(b), ai,
-                                  [](auto lft, auto rgt) { return lft.row_index < rgt; });
-            REALM_ASSERT(it != end(b) && it->row_index == ai);
-            for (; it != end(b) && it->row_index == ai; ++it) {
-                size_t j = it->tv_index;
-                if (j < begin2)
-                    continue;
-                if (j >= end2)
-                    break; // b is sorted by tv_index so this can't transition from false to true
-                f(j);
+        auto update = [&](size_t pos, Best value) { // pos is 0-based
+            for (++pos; pos <= n; pos += pos & (0 - pos)) {
+                if (value.score > tree[pos].score)
+                    tree[pos] = value;
             }
         };
 
-        Match best = {begin1, begin2, 0, 0};
-        for (size_t i = begin1; i < end1; ++i) {
-            // prev = std::move(cur), but avoids discarding prev's heap allocation
-            cur.swap(prev);
-            cur.clear();
-
-            for_each_b_match(i, [&](size_t j) {
-                size_t size = length(j);
-
-                cur.push_back({j, size});
-
-                // If the matching block ending at a[i] and b[j] is longer than
-                // the previous one, select it as the best
-                if (size > best.size)
-                    best = {i - size + 1, j - size + 1, size, IndexSet::npos};
-                // Given two equal-length matches, prefer the one with fewer modified rows
-                else if (size == best.size) {
-                    if (best.modified == IndexSet::npos)
-                        best.modified = m_modified.count(best.j - size + 1, best.j + 1);
-                    auto count = m_modified.count(j - size + 1, j + 1);
-                    if (count < best.modified)
-                        best = {i - size + 1, j - size + 1, size, count};
-                }
-
-                // The best block should always fall within the range being searched
-                REALM_ASSERT(best.i >= begin1 && best.i + best.size <= end1);
-                REALM_ASSERT(best.j >= begin2 && best.j + best.size <= end2);
+        // Length always dominates, and then each unmodified row adds one
+        const uint64_t length_weight = n + 1;
+
+        Best best{0, IndexSet::npos};
+        for (size_t i = begin; i < a.size(); ++i) {
+            // Descending `j` means the pairs for this `i` can't extend each other
+            for_each_b_match(i, begin, [&](size_t j) {
+                auto prev = query(j - begin);
+                Best cur{prev.score + length_weight + !m_modified[j], links.size()};
+                links.push_back({i, j, prev.link});
+                update(j - begin, cur);
+                if (cur.score > best.score)
+                    best = cur;
             });
         }
-        return best;
-    }
 
-    void find_longest_matches(size_t begin1, size_t end1, size_t begin2, size_t end2)
-    {
-        // FIXME: recursion could get too deep here
-        // recursion depth worst case is currently O(N) and each recursion uses 320 bytes of stack
-        // could reduce worst case to O(sqrt(N)) (and typical case to O(log N))
-        // biasing equal selections towards the middle, but that's still
-        // insufficient for Android's 8 KB stacks
-        auto m = find_longest_match(begin1, end1, begin2, end2);
-        if (!m.size)
-            return;
-        if (m.i > begin1 && m.j > begin2)
-            find_longest_matches(begin1, m.i, begin2, m.j);
-        m_longest_matches.push_back(m);
-        if (m.i + m.size < end2 && m.j + m.size < end2)
-            find_longest_matches(m.i + m.size, end1, m.j + m.size, end2);
+        // Walk the chain back from the end and group it into runs which are
+        // contiguous in both a and b
+        std::vector<Match> matches;
+        for (size_t link = best.link; link != IndexSet::npos; link = links[link].prev) {
+            auto& l = links[link];
+            if (!matches.empty() && matches.back().i == l.i + 1 && matches.back().j == l.j + 1) {
+                --matches.back().i;
+                --matches.back().j;
+                ++matches.back().size;
+            }
+            else {
+                matches.push_back({l.i, l.j, 1});
+            }
+        }
+        m_longest_matches.assign(matches.rbegin(), matches.rend());
     }
 };
 
@@ -737,9 +741,13 @@ void calculate_moves_sorted(std::vector<RowInfo>& rows, CollectionChangeSet& cha
         return std::tie(lft.row_index, lft.tv_index) < std::tie(rgt.row_index, rgt.tv_index);
     });
 
+    std::vector<bool> modified(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        modified[i] = changeset.modifications.contains(rows[i].tv_index);
+
     // Calculate the LCS of the two sequences
     auto matches = LongestCommonSubsequenceCalculator(a, b, first_difference,
-                                                      changeset.modifications).m_longest_matches;
+                                                      modified).m_longest_matches;
 
     // And then insert and delete rows as needed to align them
     size_t i = first_difference, j = first_difference;
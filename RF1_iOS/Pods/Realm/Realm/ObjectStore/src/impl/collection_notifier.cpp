@@ -19,6 +19,7 @@
 #include "impl/collection_notifier.hpp"
 
 #include "impl/realm_coordinator.hpp"
+#include "object_store.hpp"
 #include "shared_realm.hpp"
 
 #include <realm/group_shared.hpp>
@@ -27,6 +28,67 @@
 using namespace realm;
 using namespace realm::_impl;
 
+namespace {
+// Checks if any of the columns along a set of key paths were modified for a
+// row, following links to check the columns of the linked rows. Unlike
+// DeepChangeChecker this only looks at the observed columns, so it never
+// walks links which aren't part of a key path.
+class KeyPathChecker {
+public:
+    KeyPathChecker(TransactionChangeInfo const& info, Table const& root_table,
+                   KeyPathArray const& key_paths)
+    : m_info(info), m_root_table(root_table), m_key_paths(key_paths) { }
+
+    bool operator()(size_t row_ndx) const
+    {
+        return std::any_of(begin(m_key_paths), end(m_key_paths), [&](auto& key_path) {
+            return !key_path.empty() && this->check(m_root_table, row_ndx, key_path, 0);
+        });
+    }
+
+private:
+    TransactionChangeInfo const& m_info;
+    Table const& m_root_table;
+    KeyPathArray const& m_key_paths;
+
+    bool column_modified(size_t table_ndx, size_t col_ndx, size_t row_ndx) const
+    {
+        if (table_ndx >= m_info.tables.size())
+            return false;
+        auto& columns = m_info.tables[table_ndx].columns;
+        return col_ndx < columns.size() && columns[col_ndx].contains(row_ndx);
+    }
+
+    bool check(Table const& table, size_t row_ndx, KeyPath const& key_path, size_t depth) const
+    {
+        size_t table_ndx = key_path[depth].first;
+        size_t col_ndx = key_path[depth].second;
+        if (table.get_index_in_group() != table_ndx || col_ndx >= table.get_column_count())
+            return false;
+        if (column_modified(table_ndx, col_ndx, row_ndx))
+            return true;
+        if (depth + 1 == key_path.size())
+            return false;
+
+        auto type = table.get_column_type(col_ndx);
+        if (type == type_Link) {
+            if (table.is_null_link(col_ndx, row_ndx))
+                return false;
+            return check(*table.get_link_target(col_ndx), table.get_link(col_ndx, row_ndx), key_path, depth + 1);
+        }
+        if (type == type_LinkList) {
+            auto& target = *table.get_link_target(col_ndx);
+            auto lvr = table.get_linklist(col_ndx, row_ndx);
+            for (size_t i = 0, size = lvr->size(); i < size; ++i) {
+                if (check(target, lvr->get(i).get_index(), key_path, depth + 1))
+                    return true;
+            }
+        }
+        return false;
+    }
+};
+} // anonymous namespace
+
 std::function<bool (size_t)>
 CollectionNotifier::get_modification_checker(TransactionChangeInfo const& info,
                                              Table const& root_table)
@@ -34,6 +96,9 @@ CollectionNotifier::get_modification_checker(TransactionChangeInfo const& info,
     if (info.schema_changed)
         set_table(root_table);
 
+    if (!m_key_paths.empty())
+        return KeyPathChecker(info, root_table, m_key_paths);
+
     // First check if any of the tables accessible from the root table were
     // actually modified. This can be false if there were only insertions, or
     // deletions which were not linked to by any row in the linking table
@@ -41,11 +106,12 @@ CollectionNotifier::get_modification_checker(TransactionChangeInfo const& info,
         return tbl.table_ndx < info.tables.size()
             && !info.tables[tbl.table_ndx].modifications.empty();
     };
-    if (!any_of(begin(m_related_tables), end(m_related_tables), table_modified)) {
+    auto& related_tables = m_related_tables->tables;
+    if (!any_of(begin(related_tables), end(related_tables), table_modified)) {
         return [](size_t) { return false; };
     }
-    if (m_related_tables.size() == 1) {
-        auto& modifications = info.tables[m_related_tables[0].table_ndx].modifications;
+    if (related_tables.size() == 1) {
+        auto& modifications = info.tables[related_tables[0].table_ndx].modifications;
         return [&](size_t row) { return modifications.contains(row); };
     }
 
@@ -76,25 +142,46 @@ void DeepChangeChecker::find_related_tables(std::vector<RelatedTable>& out, Tabl
     }
 }
 
+std::shared_ptr<const DeepChangeChecker::RelatedTables>
+DeepChangeChecker::RelatedTables::make(Table const& root_table)
+{
+    auto related = std::make_shared<RelatedTables>();
+    find_related_tables(related->tables, root_table);
+
+    for (size_t i = 0; i < related->tables.size(); ++i) {
+        size_t table_ndx = related->tables[i].table_ndx;
+        if (table_ndx >= related->positions.size())
+            related->positions.resize(table_ndx + 1, npos);
+        related->positions[table_ndx] = i;
+    }
+    return related;
+}
+
+DeepChangeChecker::RelatedTable const*
+DeepChangeChecker::RelatedTables::find(size_t table_ndx) const noexcept
+{
+    if (table_ndx >= positions.size() || positions[table_ndx] == npos)
+        return nullptr;
+    return &tables[positions[table_ndx]];
+}
+
 DeepChangeChecker::DeepChangeChecker(TransactionChangeInfo const& info,
                                      Table const& root_table,
-                                     std::vector<RelatedTable> const& related_tables)
+                                     std::shared_ptr<const RelatedTables> related_tables)
 : m_info(info)
 , m_root_table(root_table)
 , m_root_table_ndx(root_table.get_index_in_group())
 , m_root_modifications(m_root_table_ndx < info.tables.size() ? &info.tables[m_root_table_ndx].modifications : nullptr)
-, m_related_tables(related_tables)
+, m_related_tables(std::move(related_tables))
+, m_not_modified(m_related_tables->tables.size())
 {
 }
 
-bool DeepChangeChecker::check_outgoing_links(size_t table_ndx,
+bool DeepChangeChecker::check_outgoing_links(RelatedTable const& related,
                                              Table const& table,
                                              size_t row_ndx, size_t depth)
 {
-    auto it = find_if(begin(m_related_tables), end(m_related_tables),
-                      [&](auto&& tbl) { return tbl.table_ndx == table_ndx; });
-    if (it == m_related_tables.end())
-        return false;
+    size_t table_ndx = related.table_ndx;
 
     // Check if we're already checking if the destination of the link is
     // modified, and if not add it to the stack
@@ -131,7 +218,7 @@ bool DeepChangeChecker::check_outgoing_links(size_t table_ndx,
         return false;
     };
 
-    return std::any_of(begin(it->links), end(it->links), linked_object_changed);
+    return std::any_of(begin(related.links), end(related.links), linked_object_changed);
 }
 
 bool DeepChangeChecker::check_row(Table const& table, size_t idx, size_t depth)
@@ -149,14 +236,19 @@ bool DeepChangeChecker::check_row(Table const& table, size_t idx, size_t depth)
     if (depth > 0 && table_ndx < m_info.tables.size() && m_info.tables[table_ndx].modifications.contains(idx))
         return true;
 
-    if (m_not_modified.size() <= table_ndx)
-        m_not_modified.resize(table_ndx + 1);
-    if (m_not_modified[table_ndx].contains(idx))
+    auto related = m_related_tables->find(table_ndx);
+    if (!related)
+        return false;
+
+    auto& not_modified = m_not_modified[related - m_related_tables->tables.data()];
+    if (not_modified.empty())
+        not_modified.resize(table.size());
+    if (idx < not_modified.size() && not_modified[idx])
         return false;
 
-    bool ret = check_outgoing_links(table_ndx, table, idx, depth);
-    if (!ret && (depth == 0 || !m_current_path[depth - 1].depth_exceeded))
-        m_not_modified[table_ndx].add(idx);
+    bool ret = check_outgoing_links(*related, table, idx, depth);
+    if (!ret && (depth == 0 || !m_current_path[depth - 1].depth_exceeded) && idx < not_modified.size())
+        not_modified[idx] = true;
     return ret;
 }
 
@@ -170,6 +262,7 @@ bool DeepChangeChecker::operator()(size_t ndx)
 CollectionNotifier::CollectionNotifier(std::shared_ptr<Realm> realm)
 : m_realm(std::move(realm))
 , m_sg_version(Realm::Internal::get_shared_group(*m_realm)->get_version_of_current_transaction())
+, m_coordinator(Realm::Internal::get_coordinator(*m_realm).shared_from_this())
 {
 }
 
@@ -180,13 +273,47 @@ CollectionNotifier::~CollectionNotifier()
     unregister();
 }
 
-uint64_t CollectionNotifier::add_callback(CollectionChangeCallback callback)
+void CollectionNotifier::validate_key_paths(Table const& root_table, KeyPathArray const& key_paths)
+{
+    auto object_type = [](Table const& table) {
+        return std::string(ObjectStore::object_type_for_table_name(table.get_name()));
+    };
+
+    for (auto& key_path : key_paths) {
+        if (key_path.empty())
+            throw InvalidKeyPathException("Key paths must not be empty");
+
+        // Walk the links the key path describes, checking each step against
+        // the current tables so that KeyPathChecker can trust the path
+        ConstTableRef table(&root_table);
+        for (size_t i = 0; i < key_path.size(); ++i) {
+            if (table->get_index_in_group() == npos || key_path[i].first != table->get_index_in_group())
+                throw InvalidKeyPathException(util::format("Key path element %1 does not refer to '%2'",
+                                                           i, object_type(*table)));
+
+            size_t col_ndx = key_path[i].second;
+            if (col_ndx >= table->get_column_count())
+                throw InvalidKeyPathException(util::format("Key path element %1 refers to column %2, but '%3' has only %4 properties",
+                                                           i, col_ndx, object_type(*table), table->get_column_count()));
+            if (i + 1 == key_path.size())
+                break;
+
+            auto type = table->get_column_type(col_ndx);
+            if (type != type_Link && type != type_LinkList)
+                throw InvalidKeyPathException(util::format("Property '%1.%2' in a key path is not a link",
+                                                           object_type(*table), table->get_column_name(col_ndx)));
+            table = table->get_link_target(col_ndx);
+        }
+    }
+}
+
+uint64_t CollectionNotifier::add_callback(CollectionChangeCallback callback, KeyPathArray key_paths)
 {
     m_realm->verify_thread();
 
     std::lock_guard<std::mutex> lock(m_callback_mutex);
     auto token = m_next_token++;
-    m_callbacks.push_back({std::move(callback), {}, {}, token, false, false});
+    m_callbacks.push_back({std::move(callback), {}, {}, token, false, false, std::move(key_paths)});
     if (m_callback_index == npos) { // Don't need to wake up if we're already sending notifications
         Realm::Internal::get_coordinator(*m_realm).wake_up_notifier_worker();
         m_have_callbacks = true;
@@ -266,22 +393,52 @@ std::unique_lock<std::mutex> CollectionNotifier::lock_target()
 
 void CollectionNotifier::set_table(Table const& table)
 {
-    m_related_tables.clear();
-    DeepChangeChecker::find_related_tables(m_related_tables, table);
+    // The coordinator shares the link graph between all of the notifiers for
+    // a table for as long as the schema doesn't change
+    auto version = m_sg ? m_sg->get_version_of_current_transaction().version : m_sg_version.version;
+    if (auto coordinator = m_coordinator.lock())
+        m_related_tables = coordinator->get_related_tables(table, version);
+    else
+        m_related_tables = DeepChangeChecker::RelatedTables::make(table);
+}
+
+void CollectionNotifier::update_key_paths()
+{
+    std::lock_guard<std::mutex> lock(m_callback_mutex);
+    m_key_paths.clear();
+    for (auto& callback : m_callbacks) {
+        if (callback.key_paths.empty()) {
+            m_key_paths.clear();
+            return;
+        }
+        m_key_paths.insert(m_key_paths.end(), callback.key_paths.begin(), callback.key_paths.end());
+    }
 }
 
 void CollectionNotifier::add_required_change_info(TransactionChangeInfo& info)
 {
-    if (!do_add_required_change_info(info) || m_related_tables.empty()) {
+    update_key_paths();
+    if (!do_add_required_change_info(info) || m_related_tables->tables.empty()) {
         return;
     }
 
-    auto max = max_element(begin(m_related_tables), end(m_related_tables),
-                           [](auto&& a, auto&& b) { return a.table_ndx < b.table_ndx; });
+    if (!m_key_paths.empty()) {
+        // Only the tables along the observed key paths need to be tracked
+        for (auto& key_path : m_key_paths) {
+            for (auto& link : key_path) {
+                if (link.first >= info.table_modifications_needed.size())
+                    info.table_modifications_needed.resize(link.first + 1, false);
+                info.table_modifications_needed[link.first] = true;
+            }
+        }
+        return;
+    }
 
-    if (max->table_ndx >= info.table_modifications_needed.size())
-        info.table_modifications_needed.resize(max->table_ndx + 1, false);
-    for (auto& tbl : m_related_tables) {
+    // positions is sized to one past the highest related table index
+    auto max_table_ndx = m_related_tables->positions.size() - 1;
+    if (max_table_ndx >= info.table_modifications_needed.size())
+        info.table_modifications_needed.resize(max_table_ndx + 1, false);
+    for (auto& tbl : m_related_tables->tables) {
         info.table_modifications_needed[tbl.table_ndx] = true;
     }
 }
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/external_commit_helper.hpp"
+
+#include "impl/realm_coordinator.hpp"
+
+#include <realm/util/thread.hpp>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sstream>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+// Write a byte to a pipe to notify anyone waiting for data on the pipe
+void notify_fd(int fd)
+{
+    while (true) {
+        char c = 0;
+        ssize_t ret = write(fd, &c, 1);
+        if (ret == 1) {
+            break;
+        }
+
+        // If the pipe's buffer is full, we need to read some of the old data in
+        // it to make space. We don't just read in the code waiting for
+        // notifications so that we can notify multiple waiters with a single
+        // write.
+        assert(ret == -1 && errno == EAGAIN);
+        char buff[1024];
+        read(fd, buff, sizeof buff);
+    }
+}
+} // anonymous namespace
+
+void ExternalCommitHelper::FdHolder::close()
+{
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+    m_fd = -1;
+}
+
+// This uses the same named pipe next to the Realm file as the Apple
+// implementation, so see there for why no one ever reads from it. Each process
+// waits on the pipe with a single edge-triggered epoll thread per Realm file.
+// Edge triggering means every commit which happens while the thread is busy in
+// on_change() collapses into one more wakeup, which is all that is needed as
+// on_change() always advances to the latest version.
+//
+// An eventfd rather than a second pipe is used to shut the thread down, as it
+// only ever needs to carry a single wakeup within this process.
+ExternalCommitHelper::ExternalCommitHelper(RealmCoordinator& parent)
+: m_parent(parent)
+{
+    m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epfd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    auto path = parent.get_path() + ".note";
+
+    // Create and open the named pipe
+    int ret = mkfifo(path.c_str(), 0600);
+    if (ret == -1) {
+        int err = errno;
+        if (err == ENOTSUP || err == EPERM || err == EACCES) {
+            // Filesystem doesn't support named pipes, so try putting it in tmp instead
+            // Hash collisions are okay here because they just result in doing
+            // extra work, as opposed to correctness problems
+            const char* tmp_dir = getenv("TMPDIR");
+            std::ostringstream ss;
+            ss << (tmp_dir ? tmp_dir : "/tmp") << "/";
+            ss << "realm_" << std::hash<std::string>()(path) << ".note";
+            path = ss.str();
+            ret = mkfifo(path.c_str(), 0600);
+            err = errno;
+        }
+        // the fifo already existing isn't an error
+        if (ret == -1 && err != EEXIST) {
+            throw std::system_error(err, std::system_category());
+        }
+    }
+
+    // Opening read-write means the open never blocks waiting for the other
+    // end, and writes never fail because there are no readers.
+    // Non-blocking makes writing return -1 when the pipe's buffer is full
+    // rather than blocking until there's space available
+    m_notify_fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_notify_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    m_shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_shutdown_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    // EPOLLET makes it wait for new data to be written rather than just
+    // returning when there is any data to read
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = m_notify_fd;
+    ret = epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_notify_fd, &event);
+    if (ret == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = m_shutdown_fd;
+    ret = epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_shutdown_fd, &event);
+    if (ret == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    m_thread = std::thread([=] {
+        try {
+            listen();
+        }
+        catch (std::exception const& e) {
+            fprintf(stderr, "uncaught exception in notifier thread: %s: %s\n", typeid(e).name(), e.what());
+            throw;
+        }
+        catch (...) {
+            fprintf(stderr, "uncaught exception in notifier thread\n");
+            throw;
+        }
+    });
+}
+
+ExternalCommitHelper::~ExternalCommitHelper()
+{
+    uint64_t value = 1;
+    ssize_t ret = write(m_shutdown_fd, &value, sizeof value);
+    assert(ret == sizeof value);
+    static_cast<void>(ret);
+    m_thread.join(); // Wait for the thread to exit
+}
+
+void ExternalCommitHelper::listen()
+{
+    util::Thread::set_name("Realm notification listener");
+
+    while (true) {
+        struct epoll_event events[2];
+        int ret = epoll_wait(m_epfd, events, 2, -1);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                // Interrupted by a signal; just wait again
+                continue;
+            }
+            throw std::system_error(errno, std::system_category());
+        }
+
+        // Both fds can be ready at once; shutting down takes priority over
+        // delivering a change no one may be left to observe
+        bool changed = false;
+        for (int i = 0; i < ret; ++i) {
+            if (events[i].data.fd == m_shutdown_fd) {
+                return;
+            }
+            assert(events[i].data.fd == m_notify_fd);
+            changed = true;
+        }
+
+        if (changed) {
+            m_parent.on_change();
+        }
+    }
+}
+
+void ExternalCommitHelper::notify_others()
+{
+    notify_fd(m_notify_fd);
+}
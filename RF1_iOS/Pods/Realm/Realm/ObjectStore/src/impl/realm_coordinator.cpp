@@ -18,13 +18,18 @@
 
 #include "impl/realm_coordinator.hpp"
 
+#include "impl/async_write_queue.hpp"
+#include "impl/background_compactor.hpp"
 #include "impl/collection_notifier.hpp"
 #include "impl/external_commit_helper.hpp"
+#include "impl/retention_engine.hpp"
 #include "impl/transact_log_handler.hpp"
 #include "impl/weak_realm_notifier.hpp"
+#include "impl/write_behind_flusher.hpp"
 #include "binding_context.hpp"
 #include "object_schema.hpp"
 #include "object_store.hpp"
+#include "rollup.hpp"
 #include "schema.hpp"
 
 #if REALM_ENABLE_SYNC
@@ -39,6 +44,8 @@
 #include <realm/string_data.hpp>
 
 #include <algorithm>
+#include <functional>
+#include <thread>
 #include <unordered_map>
 
 using namespace realm;
@@ -47,6 +54,98 @@ using namespace realm::_impl;
 static auto& s_coordinator_mutex = *new std::mutex;
 static auto& s_coordinators_per_path = *new std::unordered_map<std::string, std::weak_ptr<RealmCoordinator>>;
 
+// Another notifier SharedGroup is only opened once every existing one has this
+// many notifiers, as opening one is expensive and running a few cheap
+// notifiers concurrently gains nothing
+static const size_t s_min_notifiers_per_shard = 4;
+
+static size_t max_notifier_shards()
+{
+    static const size_t max_shards = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), 4));
+    return max_shards;
+}
+
+namespace realm {
+namespace _impl {
+// Runs one notifier shard at a time on a thread of its own. The thread is
+// started along with the shard rather than for each run, so that a commit
+// doesn't pay for spinning up a thread per shard
+class NotifierShardWorker {
+public:
+    NotifierShardWorker()
+    : m_thread([this] { run(); })
+    {
+    }
+
+    ~NotifierShardWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+
+    void start(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            REALM_ASSERT(m_done);
+            m_task = std::move(task);
+            m_done = false;
+        }
+        m_cv.notify_all();
+    }
+
+    // Wait for the task passed to start() to finish, rethrowing anything it threw
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return m_done; });
+        if (auto error = std::move(m_error)) {
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::function<void()> m_task;
+    std::exception_ptr m_error;
+    bool m_done = true;
+    bool m_stopping = false;
+    std::thread m_thread;
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cv.wait(lock, [&] { return m_task || m_stopping; });
+            if (m_stopping)
+                return;
+
+            auto task = std::move(m_task);
+            m_task = nullptr;
+            lock.unlock();
+            try {
+                task();
+            }
+            catch (...) {
+                lock.lock();
+                m_error = std::current_exception();
+                lock.unlock();
+            }
+            lock.lock();
+            m_done = true;
+            m_cv.notify_all();
+        }
+    }
+};
+} // namespace _impl
+} // namespace realm
+
 std::shared_ptr<RealmCoordinator> RealmCoordinator::get_coordinator(StringData path)
 {
     std::lock_guard<std::mutex> lock(s_coordinator_mutex);
@@ -133,6 +232,36 @@ void RealmCoordinator::set_config(const Realm::Config& config)
         throw std::logic_error("Specifying both memory buffer and path is invalid");
     if (!config.realm_data.is_null() && !config.encryption_key.empty())
         throw std::logic_error("Memory buffers do not support encryption");
+    if (config.in_memory && config.durability == Durability::Async)
+        throw std::logic_error("In-memory realms cannot use async durability");
+#ifndef REALM_ASYNC_DAEMON
+    if (config.effective_durability() == Durability::Async)
+        throw std::logic_error("Async durability is not supported on this platform");
+#endif
+    if (!config.write_behind_path.empty()) {
+        if (config.effective_durability() != Durability::MemOnly)
+            throw std::logic_error("Write-behind is only supported for in-memory realms");
+        if (config.sync_config)
+            throw std::logic_error("Write-behind is not supported for synchronized realms");
+        if (config.write_behind_path == config.path)
+            throw std::logic_error("The write-behind path must be different from the path of the in-memory realm");
+        if (config.write_behind_interval.count() <= 0)
+            throw std::logic_error("The write-behind interval must be positive");
+    }
+    if (!config.retention_policies.empty() && config.retention_interval.count() <= 0)
+        throw std::logic_error("The retention interval must be positive");
+    for (auto& policy : config.retention_policies) {
+        if (policy.object_type.empty() || policy.time_property.empty())
+            throw std::logic_error("Retention policies must specify an object type and a time property");
+        if (policy.max_age < 0)
+            throw std::logic_error(util::format("The retention policy for '%1' has a negative maximum age", policy.object_type));
+    }
+    if (config.background_compaction) {
+        if (config.immutable() || config.effective_durability() == Durability::MemOnly)
+            throw std::logic_error("Background compaction is only supported for writable on-disk realms");
+        if (config.compaction_free_ratio < 0 || config.compaction_free_ratio >= 1)
+            throw std::logic_error("The compaction free ratio must be at least 0 and less than 1");
+    }
     // ResetFile also won't use the migration function, but specifying one is
     // allowed to simplify temporarily switching modes during development
 
@@ -145,9 +274,15 @@ void RealmCoordinator::set_config(const Realm::Config& config)
         if (m_config.immutable() != config.immutable()) {
             throw MismatchedConfigException("Realm at path '%1' already opened with different read permissions.", config.path);
         }
-        if (m_config.in_memory != config.in_memory) {
+        if ((m_config.effective_durability() == Durability::MemOnly) != (config.effective_durability() == Durability::MemOnly)) {
             throw MismatchedConfigException("Realm at path '%1' already opened with different inMemory settings.", config.path);
         }
+        if (m_config.effective_durability() != config.effective_durability()) {
+            throw MismatchedConfigException("Realm at path '%1' already opened with different durability settings.", config.path);
+        }
+        if (m_config.write_behind_path != config.write_behind_path) {
+            throw MismatchedConfigException("Realm at path '%1' already opened with a different write-behind path.", config.path);
+        }
         if (m_config.encryption_key != config.encryption_key) {
             throw MismatchedConfigException("Realm at path '%1' already opened with a different encryption key.", config.path);
         }
@@ -223,6 +358,14 @@ std::shared_ptr<Realm> RealmCoordinator::get_realm(Realm::Config config)
     }
 
     if (!realm) {
+        // The flusher loads the persistent copy, so it has to be created
+        // before the Realm reads the schema from the in-memory file
+        if (!m_write_behind_flusher && !m_config.write_behind_path.empty())
+            m_write_behind_flusher = std::make_unique<WriteBehindFlusher>(m_config);
+
+        if (!m_compactor && m_config.background_compaction)
+            m_compactor = std::make_unique<BackgroundCompactor>(m_config);
+
         bool should_initialize_notifier = !config.immutable() && config.automatic_change_notifications;
         realm = Realm::make_shared_realm(std::move(config), shared_from_this());
         if (!m_notifier && should_initialize_notifier) {
@@ -234,6 +377,9 @@ std::shared_ptr<Realm> RealmCoordinator::get_realm(Realm::Config config)
             }
         }
         m_weak_realm_notifiers.emplace_back(realm, realm->config().cache);
+
+        if (!m_retention_engine && !m_config.retention_policies.empty() && !m_config.immutable())
+            m_retention_engine = std::make_unique<RetentionEngine>(m_config);
     }
 
     if (realm->config().sync_config)
@@ -278,6 +424,7 @@ void RealmCoordinator::cache_schema(Schema const& new_schema, uint64_t new_schem
     m_schema_version = new_schema_version;
     m_schema_transaction_version_min = transaction_version;
     m_schema_transaction_version_max = transaction_version;
+    m_related_tables_cache.clear();
 }
 
 void RealmCoordinator::clear_schema_cache_and_set_schema_version(uint64_t new_schema_version)
@@ -285,6 +432,36 @@ void RealmCoordinator::clear_schema_cache_and_set_schema_version(uint64_t new_sc
     std::lock_guard<std::mutex> lock(m_schema_cache_mutex);
     m_cached_schema = util::none;
     m_schema_version = new_schema_version;
+    m_related_tables_cache.clear();
+}
+
+std::shared_ptr<const DeepChangeChecker::RelatedTables>
+RealmCoordinator::get_related_tables(Table const& table, uint64_t transaction_version)
+{
+    // The link graph depends only on the schema, so a cached graph can be used
+    // at any transaction version which the cached schema is known to be valid for
+    auto table_ndx = table.get_index_in_group();
+    auto cache_is_valid = [&] {
+        return m_cached_schema && table_ndx != npos
+            && transaction_version >= m_schema_transaction_version_min
+            && transaction_version <= m_schema_transaction_version_max;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(m_schema_cache_mutex);
+        if (cache_is_valid()) {
+            auto it = m_related_tables_cache.find(table_ndx);
+            if (it != m_related_tables_cache.end())
+                return it->second;
+        }
+    }
+
+    auto related_tables = DeepChangeChecker::RelatedTables::make(table);
+
+    std::lock_guard<std::mutex> lock(m_schema_cache_mutex);
+    if (cache_is_valid())
+        m_related_tables_cache[table_ndx] = related_tables;
+    return related_tables;
 }
 
 void RealmCoordinator::advance_schema_cache(uint64_t previous, uint64_t next)
@@ -308,6 +485,10 @@ RealmCoordinator::RealmCoordinator()
 
 RealmCoordinator::~RealmCoordinator()
 {
+    // Don't make the notifier thread finish waiting out the interval before
+    // it can be shut down
+    skip_notification_interval();
+
     std::lock_guard<std::mutex> coordinator_lock(s_coordinator_mutex);
     for (auto it = s_coordinators_per_path.begin(); it != s_coordinators_per_path.end(); ) {
         if (it->second.expired()) {
@@ -327,6 +508,47 @@ void RealmCoordinator::unregister_realm(Realm* realm)
     m_weak_realm_notifiers.erase(new_end, end(m_weak_realm_notifiers));
 }
 
+void RealmCoordinator::did_close_realm()
+{
+    if (m_compactor)
+        m_compactor->retry();
+}
+
+bool RealmCoordinator::release_for_compaction()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_realm_mutex);
+        bool have_realms = std::any_of(begin(m_weak_realm_notifiers), end(m_weak_realm_notifiers),
+                                       [](auto& notifier) { return !notifier.expired(); });
+        if (have_realms)
+            return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_notifier_mutex);
+    if (m_running_notifiers)
+        return false;
+    clean_up_dead_notifiers();
+    if (!m_notifiers.empty() || !m_new_notifiers.empty())
+        return false;
+
+    // Reopened by the notifier thread as needed if a Realm is opened again
+    m_notifier_shards.clear();
+    m_advancer_sg = nullptr;
+    m_advancer_history = nullptr;
+    m_async_error = nullptr;
+    return true;
+}
+
+void RealmCoordinator::check_compaction_thresholds(SharedGroup& sg)
+{
+    // The stats are from the commit which was just made with this SharedGroup
+    size_t free_space, used_space;
+    sg.get_stats(free_space, used_space);
+    uint64_t file_size = free_space + used_space;
+    if (file_size >= m_config.compaction_min_size && free_space >= m_config.compaction_free_ratio * file_size)
+        m_compactor->request(shared_from_this());
+}
+
 void RealmCoordinator::clear_cache()
 {
     std::vector<WeakRealm> realms_to_close;
@@ -399,6 +621,10 @@ void RealmCoordinator::commit_write(Realm& realm)
     REALM_ASSERT(!m_config.immutable());
     REALM_ASSERT(realm.is_in_transaction());
 
+    // Rollups are written as part of the transaction they summarize
+    if (!m_config.rollups.empty() && realm.history())
+        Rollup::update(realm.read_group(), *realm.history(), m_config.rollups);
+
     {
         // Need to acquire this lock before committing or another process could
         // perform a write and notify us before we get the chance to set the
@@ -415,6 +641,9 @@ void RealmCoordinator::commit_write(Realm& realm)
         }
     }
 
+    if (m_compactor)
+        check_compaction_thresholds(*Realm::Internal::get_shared_group(realm));
+
 #if REALM_ENABLE_SYNC
     // Realm could be closed in did_change. So send sync notification first before did_change.
     if (m_sync_session) {
@@ -500,14 +729,21 @@ void RealmCoordinator::clean_up_dead_notifiers()
         return did_remove;
     };
 
-    if (swap_remove(m_notifiers)) {
+    if (swap_remove(m_notifiers) && m_notifiers.empty()) {
+        m_notifier_skip_version = {0, 0};
+
+        // A compaction may be waiting for the last notifier to go away
+        if (m_compactor)
+            m_compactor->retry();
+    }
+    for (auto& shard : m_notifier_shards) {
+        swap_remove(shard.notifiers);
+
         // Make sure we aren't holding on to read versions needlessly if there
         // are no notifiers left, but don't close them entirely as opening shared
         // groups is expensive
-        if (m_notifiers.empty() && m_notifier_sg) {
-            REALM_ASSERT_3(m_notifier_sg->get_transact_stage(), ==, SharedGroup::transact_Reading);
-            m_notifier_sg->end_read();
-            m_notifier_skip_version = {0, 0};
+        if (shard.notifiers.empty() && shard.sg && shard.sg->get_transact_stage() == SharedGroup::transact_Reading) {
+            shard.sg->end_read();
         }
     }
     if (swap_remove(m_new_notifiers) && m_advancer_sg) {
@@ -518,9 +754,79 @@ void RealmCoordinator::clean_up_dead_notifiers()
     }
 }
 
+AsyncWriteQueue& RealmCoordinator::async_write_queue()
+{
+    std::lock_guard<std::mutex> lock(m_async_write_mutex);
+    if (!m_async_write_queue)
+        m_async_write_queue = std::make_unique<AsyncWriteQueue>(m_config);
+    return *m_async_write_queue;
+}
+
+void RealmCoordinator::flush_write_behind()
+{
+    WriteBehindFlusher* flusher;
+    {
+        // The flusher is never destroyed before the coordinator, so it only
+        // needs to be guarded against concurrent creation
+        std::lock_guard<std::mutex> lock(m_realm_mutex);
+        flusher = m_write_behind_flusher.get();
+    }
+    if (flusher)
+        flusher->flush();
+}
+
+bool RealmCoordinator::wait_for_notification_interval()
+{
+    auto interval = m_config.notification_interval;
+    std::unique_lock<std::mutex> lock(m_throttle_mutex);
+    auto deadline = m_last_delivery + interval;
+    bool waited = false;
+    while (interval.count() > 0 && !m_skip_throttle && std::chrono::steady_clock::now() < deadline) {
+        waited = true;
+        m_throttle_cv.wait_until(lock, deadline, [&] { return m_skip_throttle || m_catch_up_requested; });
+        if (m_catch_up_requested) {
+            // Someone is blocked until the notifiers reach a newer version.
+            // Run them for that, but keep holding back the delivery to the
+            // other threads until the interval is over.
+            m_catch_up_requested = false;
+            lock.unlock();
+            run_async_notifiers();
+            lock.lock();
+        }
+    }
+    m_last_delivery = std::chrono::steady_clock::now();
+    return waited;
+}
+
+void RealmCoordinator::request_notifier_catch_up()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_throttle_mutex);
+        m_catch_up_requested = true;
+    }
+    m_throttle_cv.notify_all();
+}
+
+void RealmCoordinator::skip_notification_interval()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_throttle_mutex);
+        m_skip_throttle = true;
+    }
+    m_throttle_cv.notify_all();
+}
+
 void RealmCoordinator::on_change()
 {
+    // The notifiers always run right away, so that threads which have to
+    // wait for them to catch up aren't held up by the notification interval.
+    // Only waking up the other threads to deliver the changes is throttled.
     run_async_notifiers();
+    if (wait_for_notification_interval()) {
+        // Pick up any commits made while waiting, which would otherwise only
+        // be delivered after the next interval
+        run_async_notifiers();
+    }
 
     std::lock_guard<std::mutex> lock(m_realm_mutex);
     for (auto& realm : m_weak_realm_notifiers) {
@@ -606,13 +912,23 @@ public:
         }
 
         // Copy the list change info if there are multiple LinkViews for the same LinkList
-        auto id = [](auto const& list) { return std::tie(list.table_ndx, list.col_ndx, list.row_ndx); };
-        for (size_t i = 1; i < m_current->lists.size(); ++i) {
-            for (size_t j = i; j > 0; --j) {
-                if (id(m_current->lists[i]) == id(m_current->lists[j - 1])) {
-                    m_current->lists[j - 1].changes->merge(CollectionChangeBuilder{*m_current->lists[i].changes});
-                }
-            }
+        auto& lists = m_current->lists;
+        if (lists.size() < 2)
+            return;
+
+        std::unordered_map<ListKey, std::vector<size_t>, ListKey::Hash> duplicates;
+        duplicates.reserve(lists.size());
+        for (size_t i = 0; i < lists.size(); ++i)
+            duplicates[lists[i].key()].push_back(i);
+
+        // Each entry needs the changes from every later entry for the same
+        // list. Walking each group backwards, the next entry already holds
+        // the changes from all of the ones after it, so one merge per entry
+        // is enough
+        for (auto& group : duplicates) {
+            auto& indices = group.second;
+            for (size_t i = indices.size() - 1; i > 0; --i)
+                lists[indices[i - 1]].changes->merge(CollectionChangeBuilder{*lists[indices[i]].changes});
         }
     }
 
@@ -643,6 +959,43 @@ void RealmCoordinator::run_async_notifiers()
         return;
     }
 
+    // Opening a SharedGroup is slow, so any extra shards which the new
+    // notifiers call for are opened without holding the lock. The shard list
+    // is only ever changed on this thread, so nothing can race with adding them
+    size_t shards_needed = notifier_shards_needed();
+    if (shards_needed > m_notifier_shards.size()) {
+        size_t to_open = shards_needed - m_notifier_shards.size();
+        m_running_notifiers = true;
+        lock.unlock();
+        auto new_shards = open_notifier_shards(to_open);
+        lock.lock();
+        m_running_notifiers = false;
+        std::move(new_shards.begin(), new_shards.end(), std::back_inserter(m_notifier_shards));
+
+        // Notifiers may have been added or removed while the lock was released
+        clean_up_dead_notifiers();
+        if (m_notifiers.empty() && m_new_notifiers.empty()) {
+            return;
+        }
+    }
+
+    // Pick the shard for each new notifier now, as every shard which is going
+    // to run has to be in a read transaction before the target version is picked
+    std::vector<size_t> shard_sizes;
+    for (auto& shard : m_notifier_shards) {
+        shard_sizes.push_back(shard.notifiers.size());
+    }
+    std::unordered_map<CollectionNotifier*, size_t> new_notifier_shards;
+    for (auto& notifier : m_new_notifiers) {
+        new_notifier_shards[notifier.get()] = shard_for_new_notifier(shard_sizes);
+    }
+    for (size_t i = 0; i < m_notifier_shards.size(); ++i) {
+        auto& sg = *m_notifier_shards[i].sg;
+        if (shard_sizes[i] && sg.get_transact_stage() == SharedGroup::transact_Ready) {
+            sg.begin_read();
+        }
+    }
+
     VersionID version;
 
     // Advance all of the new notifiers to the most recent version, if any
@@ -698,16 +1051,68 @@ void RealmCoordinator::run_async_notifiers()
     auto skip_version = m_notifier_skip_version;
     m_notifier_skip_version = {0, 0};
 
-    // Make a copy of the notifiers vector and then release the lock to avoid
+    // Make a copy of each shard's notifiers and then release the lock to avoid
     // blocking other threads trying to register or unregister notifiers while we run them
-    auto notifiers = m_notifiers;
+    using NotifierList = std::vector<std::shared_ptr<_impl::CollectionNotifier>>;
+    std::vector<NotifierList> notifiers, shard_new_notifiers(m_notifier_shards.size());
+    for (auto& shard : m_notifier_shards) {
+        notifiers.push_back(shard.notifiers);
+    }
+    for (auto& notifier : new_notifiers) {
+        size_t shard = new_notifier_shards[notifier.get()];
+        shard_new_notifiers[shard].push_back(notifier);
+        m_notifier_shards[shard].notifiers.push_back(notifier);
+    }
     m_notifiers.insert(m_notifiers.end(), new_notifiers.begin(), new_notifiers.end());
+    m_running_notifiers = true;
     lock.unlock();
 
-    if (skip_version.version) {
-        REALM_ASSERT(!notifiers.empty());
+    // Each shard has its own SharedGroup, so they can all run at once. The
+    // first one runs on this thread and the others on their worker threads.
+    // Shards with no notifiers have no read transaction to advance
+    auto run_shard = [&](size_t i) {
+        run_notifier_shard(m_notifier_shards[i], std::move(notifiers[i]), std::move(shard_new_notifiers[i]),
+                           version, skip_version);
+    };
+    std::vector<NotifierShardWorker*> running;
+    for (size_t i = 1; i < m_notifier_shards.size(); ++i) {
+        if (notifiers[i].empty() && shard_new_notifiers[i].empty())
+            continue;
+        auto& worker = *m_notifier_shards[i].worker;
+        worker.start([&run_shard, i] { run_shard(i); });
+        running.push_back(&worker);
+    }
+    if (!m_notifier_shards.empty() && (!notifiers[0].empty() || !shard_new_notifiers[0].empty())) {
+        run_shard(0);
+    }
+    for (auto worker : running) {
+        worker->wait();
+    }
+
+    // Reacquire the lock while updating the fields that are actually read on
+    // other threads
+    lock.lock();
+    m_running_notifiers = false;
+    for (auto& shard : m_notifier_shards) {
+        for (auto& notifier : shard.notifiers) {
+            notifier->prepare_handover();
+        }
+    }
+    clean_up_dead_notifiers();
+    m_notifier_cv.notify_all();
+}
+
+void RealmCoordinator::run_notifier_shard(NotifierShard& shard, std::vector<std::shared_ptr<_impl::CollectionNotifier>> notifiers,
+                                          std::vector<std::shared_ptr<_impl::CollectionNotifier>> new_notifiers,
+                                          VersionID version, VersionID skip_version)
+{
+    auto& sg = *shard.sg;
+
+    // A shard with only new notifiers began reading after the skipped
+    // version, so there is nothing for it to skip
+    if (skip_version.version && !notifiers.empty()) {
         REALM_ASSERT(version >= skip_version);
-        IncrementalChangeInfo change_info(*m_notifier_sg, notifiers);
+        IncrementalChangeInfo change_info(sg, notifiers);
         for (auto& notifier : notifiers)
             notifier->add_required_change_info(change_info.current());
         change_info.advance_to_final(skip_version);
@@ -715,23 +1120,22 @@ void RealmCoordinator::run_async_notifiers()
         for (auto& notifier : notifiers)
             notifier->run();
 
-        lock.lock();
+        std::lock_guard<std::mutex> lock(m_notifier_mutex);
         for (auto& notifier : notifiers)
             notifier->prepare_handover();
-        lock.unlock();
     }
 
     // Advance the non-new notifiers to the same version as we advanced the new
     // ones to (or the latest if there were no new ones)
-    IncrementalChangeInfo change_info(*m_notifier_sg, notifiers);
+    IncrementalChangeInfo change_info(sg, notifiers);
     for (auto& notifier : notifiers) {
         notifier->add_required_change_info(change_info.current());
     }
     change_info.advance_to_final(version);
 
-    // Attach the new notifiers to the main SG and move them to the main list
+    // Attach the new notifiers to the shard's SG
     for (auto& notifier : new_notifiers) {
-        notifier->attach_to(*m_notifier_sg);
+        notifier->attach_to(sg);
         notifier->run();
     }
 
@@ -740,39 +1144,75 @@ void RealmCoordinator::run_async_notifiers()
     for (auto& notifier : notifiers) {
         notifier->run();
     }
-
-    // Reacquire the lock while updating the fields that are actually read on
-    // other threads
-    lock.lock();
-    for (auto& notifier : new_notifiers) {
-        notifier->prepare_handover();
-    }
-    for (auto& notifier : notifiers) {
-        notifier->prepare_handover();
-    }
-    clean_up_dead_notifiers();
-    m_notifier_cv.notify_all();
 }
 
 void RealmCoordinator::open_helper_shared_group()
 {
-    if (!m_notifier_sg) {
+    if (m_notifier_shards.empty()) {
+        m_notifier_shards.emplace_back();
+    }
+
+    auto& shard = m_notifier_shards.front();
+    if (!shard.sg) {
         try {
             std::unique_ptr<Group> read_only_group;
-            Realm::open_with_config(m_config, m_notifier_history, m_notifier_sg, read_only_group, nullptr);
+            Realm::open_with_config(m_config, shard.history, shard.sg, read_only_group, nullptr);
             REALM_ASSERT(!read_only_group);
-            m_notifier_sg->begin_read();
         }
         catch (...) {
             // Store the error to be passed to the async notifiers
             m_async_error = std::current_exception();
-            m_notifier_sg = nullptr;
-            m_notifier_history = nullptr;
+            shard.sg = nullptr;
+            shard.history = nullptr;
         }
     }
-    else if (m_notifiers.empty()) {
-        m_notifier_sg->begin_read();
+}
+
+size_t RealmCoordinator::notifier_shards_needed() const
+{
+    // Play out shard_for_new_notifier() for each new notifier, opening
+    // another shard whenever every existing one is full enough
+    std::vector<size_t> shard_sizes;
+    for (auto& shard : m_notifier_shards) {
+        shard_sizes.push_back(shard.notifiers.size());
+    }
+    for (size_t i = 0; i < m_new_notifiers.size(); ++i) {
+        auto smallest = std::min_element(shard_sizes.begin(), shard_sizes.end());
+        if (*smallest >= s_min_notifiers_per_shard && shard_sizes.size() < max_notifier_shards())
+            shard_sizes.push_back(1);
+        else
+            ++*smallest;
+    }
+    return shard_sizes.size();
+}
+
+std::vector<RealmCoordinator::NotifierShard> RealmCoordinator::open_notifier_shards(size_t count)
+{
+    std::vector<NotifierShard> shards;
+    for (size_t i = 0; i < count; ++i) {
+        NotifierShard shard;
+        try {
+            std::unique_ptr<Group> read_only_group;
+            Realm::open_with_config(m_config, shard.history, shard.sg, read_only_group, nullptr);
+            REALM_ASSERT(!read_only_group);
+        }
+        catch (...) {
+            // Not fatal as the notifiers can share the existing SharedGroups
+            break;
+        }
+        shard.worker = std::make_unique<NotifierShardWorker>();
+        shards.push_back(std::move(shard));
     }
+    return shards;
+}
+
+size_t RealmCoordinator::shard_for_new_notifier(std::vector<size_t>& shard_sizes)
+{
+    // Any shard opened for the new notifiers starts out empty, so it is
+    // picked before the existing ones get any fuller
+    size_t shard = std::min_element(shard_sizes.begin(), shard_sizes.end()) - shard_sizes.begin();
+    ++shard_sizes[shard];
+    return shard;
 }
 
 void RealmCoordinator::advance_to_ready(Realm& realm)
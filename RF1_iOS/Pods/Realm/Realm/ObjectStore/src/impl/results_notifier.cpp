@@ -20,9 +20,30 @@
 
 #include "shared_realm.hpp"
 
+#include <realm/group_shared.hpp>
+
 using namespace realm;
 using namespace realm::_impl;
 
+namespace {
+bool has_links(Group const& group, Table const& table)
+{
+    // Links into the table are found by looking for link columns which target
+    // it, as its backlink columns aren't public
+    for (size_t i = 0; i < group.size(); ++i) {
+        auto other = group.get_table(i);
+        for (size_t col = 0; col < other->get_column_count(); ++col) {
+            auto type = other->get_column_type(col);
+            if (type != type_Link && type != type_LinkList)
+                continue;
+            if (other.get() == &table || other->get_link_target(col).get() == &table)
+                return true;
+        }
+    }
+    return false;
+}
+} // anonymous namespace
+
 ResultsNotifier::ResultsNotifier(Results& target)
 : CollectionNotifier(target.get_realm())
 , m_target_results(&target)
@@ -45,6 +66,7 @@ void ResultsNotifier::target_results_moved(Results& old_target, Results& new_tar
 void ResultsNotifier::release_data() noexcept
 {
     m_query = nullptr;
+    m_previous_tv = nullptr;
 }
 
 // Most of the inter-thread synchronization for run(), prepare_handover(),
@@ -88,6 +110,14 @@ bool ResultsNotifier::do_add_required_change_info(TransactionChangeInfo& info)
         if (info.table_moves_needed.size() <= table_ndx)
             info.table_moves_needed.resize(table_ndx + 1);
         info.table_moves_needed[table_ndx] = true;
+
+        // Modifications are needed to know that the existing rows still match,
+        // but only when there's a previous run to append to
+        if (m_appends_only_insert && has_run() && m_previous_tv) {
+            if (info.table_modifications_needed.size() <= table_ndx)
+                info.table_modifications_needed.resize(table_ndx + 1);
+            info.table_modifications_needed[table_ndx] = true;
+        }
     }
 
     return has_run() && have_callbacks();
@@ -114,6 +144,57 @@ bool ResultsNotifier::need_to_run()
     return true;
 }
 
+bool ResultsNotifier::only_rows_appended()
+{
+    if (!m_appends_only_insert || !has_run() || !m_previous_tv || m_info->schema_changed)
+        return false;
+
+    auto& table = *m_query->get_table();
+    if (table.size() < m_last_table_size)
+        return false;
+
+    size_t table_ndx = table.get_index_in_group();
+    size_t appended = table.size() - m_last_table_size;
+    if (table_ndx >= m_info->tables.size())
+        return appended == 0;
+
+    auto const& changes = m_info->tables[table_ndx];
+    return changes.deletions.empty() && changes.moves.empty() && changes.modifications.empty()
+        && changes.insertions.count() == appended && changes.insertions.count(m_last_table_size) == appended;
+}
+
+void ResultsNotifier::append_rows()
+{
+    // The previous TableView was in sync when it was exported, so it's
+    // imported as in sync with the current version. The rows which matched
+    // before are still right, so only the new rows need to be queried.
+    m_previous_tv->version = m_sg->get_version_of_current_transaction();
+    m_tv = std::move(*m_sg->import_from_handover(std::move(m_previous_tv)));
+
+    auto appended = m_query->find_all(m_last_table_size);
+    for (size_t i = 0; i < appended.size(); ++i)
+        m_tv.m_row_indexes.add(appended.get_source_ndx(i));
+}
+
+void ResultsNotifier::append_changes()
+{
+    // The existing rows can't have stopped or started matching and the
+    // results are in table order, so the rows which matched before are still
+    // the first ones and anything new is at the end. That's the whole diff, so
+    // skip comparing the old and new row lists.
+    size_t previous_size = m_previous_rows.size();
+    REALM_ASSERT_DEBUG(m_tv.size() >= previous_size);
+
+    m_changes = {};
+    if (have_callbacks() && m_tv.size() > previous_size)
+        m_changes.insert(previous_size, m_tv.size() - previous_size);
+    m_previous_rows.reserve(m_tv.size());
+    for (size_t i = previous_size; i < m_tv.size(); ++i) {
+        REALM_ASSERT_DEBUG(m_tv[i].get_index() >= m_last_table_size);
+        m_previous_rows.push_back(m_tv[i].get_index());
+    }
+}
+
 void ResultsNotifier::calculate_changes()
 {
     size_t table_ndx = m_query->get_table()->get_index_in_group();
@@ -166,6 +247,7 @@ void ResultsNotifier::run()
         m_changes = {};
         m_changes.deletions.set(m_previous_rows.size());
         m_previous_rows.clear();
+        m_previous_tv = nullptr;
         return;
     }
 
@@ -173,11 +255,18 @@ void ResultsNotifier::run()
         return;
 
     m_query->sync_view_if_needed();
-    m_tv = m_query->find_all();
-    m_tv.apply_descriptor_ordering(m_descriptor_ordering);
-    m_last_seen_version = m_tv.sync_if_needed();
-
-    calculate_changes();
+    if (only_rows_appended()) {
+        append_rows();
+        m_last_seen_version = m_tv.sync_if_needed();
+        append_changes();
+    }
+    else {
+        m_tv = m_query->find_all();
+        m_tv.apply_descriptor_ordering(m_descriptor_ordering);
+        m_last_seen_version = m_tv.sync_if_needed();
+        calculate_changes();
+    }
+    m_last_table_size = m_query->get_table()->size();
 }
 
 void ResultsNotifier::do_prepare_handover(SharedGroup& sg)
@@ -196,6 +285,9 @@ void ResultsNotifier::do_prepare_handover(SharedGroup& sg)
 
     REALM_ASSERT(m_tv.is_in_sync());
 
+    // Keep a copy of the rows to append to if the next commit only adds rows
+    if (m_appends_only_insert)
+        m_previous_tv = sg.export_for_handover(m_tv, ConstSourcePayload::Copy);
     m_tv_handover = sg.export_for_handover(m_tv, MutableSourcePayload::Move);
 
     add_changes(std::move(m_changes));
@@ -239,6 +331,12 @@ void ResultsNotifier::do_attach_to(SharedGroup& sg)
     REALM_ASSERT(m_query_handover);
     m_query = sg.import_from_handover(std::move(m_query_handover));
     m_descriptor_ordering = DescriptorOrdering::create_from_and_consume_patch(m_ordering_handover, *m_query->get_table());
+
+    auto& table = *m_query->get_table();
+    m_appends_only_insert = m_descriptor_ordering.is_empty() && m_query->produces_results_in_table_order()
+                         && table.is_attached() && table.get_index_in_group() != npos
+                         && !has_links(SharedGroupFriend::get_group(sg), table);
+    m_sg = &sg;
 }
 
 void ResultsNotifier::do_detach_from(SharedGroup& sg)
@@ -249,4 +347,6 @@ void ResultsNotifier::do_detach_from(SharedGroup& sg)
     DescriptorOrdering::generate_patch(m_descriptor_ordering, m_ordering_handover);
     m_query_handover = sg.export_for_handover(*m_query, MutableSourcePayload::Move);
     m_query = nullptr;
+    m_previous_tv = nullptr;
+    m_sg = nullptr;
 }
@@ -0,0 +1,195 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/retention_engine.hpp"
+
+#include "impl/realm_coordinator.hpp"
+#include "object_store.hpp"
+
+#include <realm/table.hpp>
+#include <realm/table_view.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+size_t time_column(Table& table, RetentionPolicy const& policy)
+{
+    size_t col = table.get_column_index(policy.time_property);
+    if (col == npos || table.get_column_type(col) != type_Int || table.is_nullable(col))
+        throw std::logic_error(util::format("Retention time property '%1.%2' must be a non-optional int",
+                                            policy.object_type, policy.time_property));
+    return col;
+}
+
+// The objects which a policy deletes: those older than `time`, or all of
+// them if `all` is set, as a time can't be found which every object is older
+// than when some have the maximum int64
+struct Cutoff {
+    int64_t time = std::numeric_limits<int64_t>::min();
+    bool all = false;
+
+    bool deletes_anything() const { return all || time != std::numeric_limits<int64_t>::min(); }
+};
+
+// Get the time of the oldest object which `policy` keeps
+Cutoff oldest_kept(Table& table, size_t col, RetentionPolicy const& policy)
+{
+    Cutoff cutoff;
+    size_t size = table.size();
+    if (size == 0)
+        return cutoff;
+
+    if (policy.max_age > 0) {
+        int64_t newest = table.maximum_int(col);
+        if (newest >= cutoff.time + policy.max_age)
+            cutoff.time = newest - policy.max_age;
+    }
+
+    size_t keep = size;
+    if (policy.max_count > 0)
+        keep = std::min(keep, policy.max_count);
+    if (policy.max_bytes > 0) {
+        // Assume the objects are all about the same size
+        uint64_t bytes = table.compute_aggregated_byte_size();
+        if (bytes > policy.max_bytes)
+            keep = std::min(keep, size_t(double(size) * policy.max_bytes / bytes));
+    }
+    if (keep == 0) {
+        cutoff.all = true;
+    }
+    else if (keep < size) {
+        // One sort per pass; the deletions themselves are then simple range
+        // queries on the time property
+        auto sorted = table.get_sorted_view(col);
+        cutoff.time = std::max(cutoff.time, sorted.get_int(col, size - keep));
+    }
+    return cutoff;
+}
+} // anonymous namespace
+
+RetentionEngine::RetentionEngine(Realm::Config config)
+: m_state(std::make_shared<State>())
+{
+    // The background thread needs a Realm instance of its own
+    config.execution_context = util::none;
+    config.cache = true;
+    m_state->config = std::move(config);
+    m_thread = std::thread(&RetentionEngine::run, m_state);
+}
+
+RetentionEngine::~RetentionEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->stop = true;
+    }
+    m_state->cv.notify_all();
+
+    // Closing the background thread's Realm can release the last reference to
+    // the coordinator which owns this engine, in which case the thread exits
+    // on its own once it sees that it's been stopped
+    if (m_thread.get_id() == std::this_thread::get_id())
+        m_thread.detach();
+    else
+        m_thread.join();
+}
+
+void RetentionEngine::run(std::shared_ptr<State> state)
+{
+    auto const& config = state->config;
+    auto batch_size = std::max<size_t>(config.retention_batch_size, 1);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->cv.wait_for(lock, config.retention_interval, [&] { return state->stop; })) {
+        lock.unlock();
+        try {
+            // Don't resurrect a coordinator which is being torn down
+            if (auto coordinator = RealmCoordinator::get_existing_coordinator(config.path)) {
+                auto realm = coordinator->get_realm(config);
+                coordinator.reset();
+
+                enforce(*realm, config.retention_policies, batch_size, [&] {
+                    std::unique_lock<std::mutex> throttle_lock(state->mutex);
+                    return !state->cv.wait_for(throttle_lock, config.retention_throttle, [&] { return state->stop; });
+                });
+                // Closing the Realm may destroy the RetentionEngine, so only
+                // `state` can be used after this
+                realm->close();
+            }
+        }
+        catch (...) {
+            // Retried at the next interval. Realm::enforce_retention() runs
+            // the same pass and reports errors.
+        }
+        lock.lock();
+    }
+}
+
+size_t RetentionEngine::enforce(Realm& realm, std::vector<RetentionPolicy> const& policies, size_t batch_size,
+                                std::function<bool()> const& between_batches)
+{
+    size_t deleted = 0;
+    for (auto& policy : policies) {
+        realm.refresh();
+        auto table = ObjectStore::table_for_object_type(realm.read_group(), policy.object_type);
+        if (!table)
+            continue;
+        auto cutoff = oldest_kept(*table, time_column(*table, policy), policy);
+        if (!cutoff.deletes_anything())
+            continue;
+
+        // Objects added while this runs are newer than the cutoff, so it
+        // doesn't need to be recalculated between batches
+        while (true) {
+            realm.begin_transaction();
+            size_t removed = 0;
+            try {
+                table = ObjectStore::table_for_object_type(realm.read_group(), policy.object_type);
+                if (table) {
+                    auto query = table->where();
+                    if (!cutoff.all)
+                        query.less(time_column(*table, policy), cutoff.time);
+                    auto view = query.find_all(0, size_t(-1), batch_size);
+                    removed = view.size();
+                    view.clear(RemoveMode::unordered);
+                }
+                if (removed == 0) {
+                    realm.cancel_transaction();
+                    break;
+                }
+                realm.commit_transaction();
+            }
+            catch (...) {
+                if (realm.is_in_transaction())
+                    realm.cancel_transaction();
+                throw;
+            }
+
+            deleted += removed;
+            if (removed < batch_size)
+                break;
+            if (between_batches && !between_batches())
+                return deleted;
+        }
+    }
+    return deleted;
+}
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/time_series_codec.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+const size_t s_header_size = 8;
+const uint64_t s_continuation_bits = 0x8080808080808080ULL;
+
+// Deltas are computed with unsigned arithmetic so that they wrap rather than
+// overflow, which round-trips exactly for any pair of int64s
+inline uint64_t zigzag(uint64_t delta) noexcept
+{
+    return (delta << 1) ^ uint64_t(int64_t(delta) >> 63);
+}
+
+inline uint64_t unzigzag(uint64_t encoded) noexcept
+{
+    return (encoded >> 1) ^ (0 - (encoded & 1));
+}
+
+inline void store_le64(char* out, uint64_t value) noexcept
+{
+    for (int i = 0; i < 8; ++i)
+        out[i] = char((value >> (8 * i)) & 0xFF);
+}
+
+inline uint64_t load_le64(const char* in) noexcept
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+        value |= uint64_t(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+} // anonymous namespace
+
+void time_series::init_stream(std::vector<char>& stream)
+{
+    stream.assign(s_header_size, 0);
+}
+
+int64_t time_series::last_value(BinaryData stream) noexcept
+{
+    if (stream.size() < s_header_size)
+        return 0;
+    return int64_t(load_le64(stream.data()));
+}
+
+void time_series::append_values(std::vector<char>& stream, const int64_t* values, size_t count)
+{
+    if (stream.size() < s_header_size)
+        init_stream(stream);
+    if (count == 0)
+        return;
+
+    uint64_t previous = load_le64(stream.data());
+    // Reserve for the worst case of ten bytes per value up front, then trim
+    size_t pos = stream.size();
+    stream.resize(pos + count * 10);
+    auto out = reinterpret_cast<unsigned char*>(stream.data());
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = uint64_t(values[i]);
+        uint64_t encoded = zigzag(value - previous);
+        previous = value;
+        while (encoded >= 0x80) {
+            out[pos++] = static_cast<unsigned char>(encoded | 0x80);
+            encoded >>= 7;
+        }
+        out[pos++] = static_cast<unsigned char>(encoded);
+    }
+    stream.resize(pos);
+    store_le64(stream.data(), previous);
+}
+
+void time_series::decode_values(BinaryData stream, size_t count, int64_t* out)
+{
+    if (count == 0)
+        return;
+    if (stream.size() < s_header_size)
+        throw std::runtime_error("Truncated time series chunk");
+
+    auto p = reinterpret_cast<const unsigned char*>(stream.data()) + s_header_size;
+    auto end = reinterpret_cast<const unsigned char*>(stream.data()) + stream.size();
+    uint64_t value = 0;
+    size_t i = 0;
+    while (i < count) {
+        // Almost all deltas fit in one byte, so check eight bytes at a time for
+        // continuation bits and skip the general varint loop if there are none
+        if (count - i >= 8 && end - p >= 8) {
+            uint64_t word;
+            memcpy(&word, p, 8);
+            if ((word & s_continuation_bits) == 0) {
+                for (int k = 0; k < 8; ++k) {
+                    value += unzigzag(p[k]);
+                    out[i + k] = int64_t(value);
+                }
+                p += 8;
+                i += 8;
+                continue;
+            }
+        }
+
+        uint64_t encoded = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (p == end || shift > 63)
+                throw std::runtime_error("Truncated time series chunk");
+            unsigned char byte = *p++;
+            encoded |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        value += unzigzag(encoded);
+        out[i++] = int64_t(value);
+    }
+}
@@ -25,9 +25,11 @@
 
 #include <realm/group_shared.hpp>
 #include <realm/lang_bind_helper.hpp>
+#include <realm/replication.hpp>
 
 #include <algorithm>
 #include <numeric>
+#include <unordered_map>
 
 using namespace realm;
 
@@ -405,16 +407,29 @@ class TransactLogObserver : public TransactLogValidationMixin, public MarkDirtyM
     bool m_need_move_info = false;
     bool m_is_top_level_table = true;
 
+    // Lookup table for find_list(), rebuilt lazily after any instruction
+    // which changes the position of an observed list
+    std::unordered_map<_impl::ListKey, _impl::CollectionChangeBuilder*, _impl::ListKey::Hash> m_list_index;
+    bool m_list_index_valid = false;
+
     _impl::CollectionChangeBuilder* find_list(size_t tbl, size_t col, size_t row)
     {
-        // When there are multiple source versions there could be multiple
-        // change objects for a single LinkView, in which case we need to use
-        // the last one
-        for (auto it = m_info.lists.rbegin(), end = m_info.lists.rend(); it != end; ++it) {
-            if (it->table_ndx == tbl && it->row_ndx == row && it->col_ndx == col)
-                return it->changes;
+        if (m_info.lists.empty())
+            return nullptr;
+
+        if (!m_list_index_valid) {
+            // When there are multiple source versions there could be multiple
+            // change objects for a single LinkView, in which case we need to use
+            // the last one
+            m_list_index.clear();
+            m_list_index.reserve(m_info.lists.size());
+            for (auto& list : m_info.lists)
+                m_list_index[list.key()] = list.changes;
+            m_list_index_valid = true;
         }
-        return nullptr;
+
+        auto it = m_list_index.find({tbl, col, row});
+        return it == m_list_index.end() ? nullptr : it->second;
     }
 
 public:
@@ -544,8 +559,10 @@ public:
         if (!m_is_top_level_table)
             return true;
         for (auto& list : m_info.lists) {
-            if (list.table_ndx == current_table() && list.row_ndx >= row_ndx)
+            if (list.table_ndx == current_table() && list.row_ndx >= row_ndx) {
                 list.row_ndx += num_rows_to_insert;
+                m_list_index_valid = false;
+            }
         }
         return true;
     }
@@ -577,10 +594,13 @@ public:
                 if (i + 1 < m_info.lists.size())
                     m_info.lists[i] = std::move(m_info.lists.back());
                 m_info.lists.pop_back();
+                m_list_index_valid = false;
                 continue;
             }
-            if (list.row_ndx == last_row)
+            if (list.row_ndx == last_row) {
                 list.row_ndx = row_ndx;
+                m_list_index_valid = false;
+            }
         }
 
         return true;
@@ -605,6 +625,9 @@ public:
                     list.row_ndx = row_ndx_2;
                 else if (list.row_ndx == row_ndx_2)
                     list.row_ndx = row_ndx_1;
+                else
+                    continue;
+                m_list_index_valid = false;
             }
         }
         return true;
@@ -626,8 +649,10 @@ public:
         if (!m_is_top_level_table)
             return true;
         for (auto& list : m_info.lists) {
-            if (list.table_ndx == current_table() && list.row_ndx == from)
+            if (list.table_ndx == current_table() && list.row_ndx == from) {
                 list.row_ndx = to;
+                m_list_index_valid = false;
+            }
         }
         return true;
     }
@@ -641,7 +666,10 @@ public:
             return true;
         auto it = remove_if(begin(m_info.lists), end(m_info.lists),
                             [&](auto const& lv) { return lv.table_ndx == tbl_ndx; });
-        m_info.lists.erase(it, end(m_info.lists));
+        if (it != end(m_info.lists)) {
+            m_info.lists.erase(it, end(m_info.lists));
+            m_list_index_valid = false;
+        }
         return true;
     }
 
@@ -657,6 +685,7 @@ public:
             if (list.table_ndx == current_table() && list.col_ndx >= ndx)
                 ++list.col_ndx;
         }
+        m_list_index_valid = false;
         if (m_info.column_indices.size() <= current_table())
             m_info.column_indices.resize(current_table() + 1);
         auto& indices = m_info.column_indices[current_table()];
@@ -682,6 +711,7 @@ public:
             if (list.table_ndx >= ndx)
                 ++list.table_ndx;
         }
+        m_list_index_valid = false;
         prepare_table_indices();
         adjust_ge(m_info.table_indices, ndx);
         insert_empty_at(m_info.tables, ndx);
@@ -702,6 +732,7 @@ public:
             if (list.table_ndx == current_table())
                 adjust_for_move(list.col_ndx, from, to);
         }
+        m_list_index_valid = false;
         if (m_info.column_indices.size() <= current_table())
             m_info.column_indices.resize(current_table() + 1);
         expand_to(m_info.column_indices[current_table()], std::max(from, to) + 1);
@@ -715,6 +746,7 @@ public:
 
         for (auto& list : m_info.lists)
             adjust_for_move(list.table_ndx, from, to);
+        m_list_index_valid = false;
 
         prepare_table_indices();
         adjust_for_move(m_info.table_indices, from, to);
@@ -870,6 +902,22 @@ void advance(SharedGroup& sg, TransactionChangeInfo& info, VersionID version)
     }
 }
 
+void collect_uncommitted_changes(Replication& history, TransactionChangeInfo& info)
+{
+    auto hist = history.get_history();
+    if (!hist)
+        return;
+    BinaryData changes = hist->get_uncommitted_changes();
+    if (changes.size() == 0)
+        return;
+
+    SimpleInputStream in(changes.data(), changes.size());
+    TransactLogParser parser;
+    TransactLogObserver observer(info);
+    parser.parse(in, observer);
+    observer.parse_complete();
+}
+
 } // namespace transaction
 } // namespace _impl
 } // namespace realm
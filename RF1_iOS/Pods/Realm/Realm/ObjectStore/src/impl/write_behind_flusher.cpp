@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "impl/write_behind_flusher.hpp"
+
+#include <realm/descriptor.hpp>
+#include <realm/group_shared.hpp>
+#include <realm/history.hpp>
+#include <realm/link_view.hpp>
+#include <realm/util/file.hpp>
+#include <realm/util/scope_exit.hpp>
+
+#include <stdexcept>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+void copy_subtable_columns(ConstDescriptorRef const& from, DescriptorRef const& to)
+{
+    for (size_t col = 0; col < from->get_column_count(); ++col) {
+        auto type = from->get_column_type(col);
+        DescriptorRef subdesc;
+        to->add_column(type, from->get_column_name(col), type == type_Table ? &subdesc : nullptr,
+                       from->is_nullable(col));
+        if (type == type_Table)
+            copy_subtable_columns(from->get_subdescriptor(col), subdesc);
+    }
+}
+
+void copy_columns(Table const& from, Table& to, Group& group)
+{
+    for (size_t col = 0; col < from.get_column_count(); ++col) {
+        auto type = from.get_column_type(col);
+        auto name = from.get_column_name(col);
+        if (type == type_Link || type == type_LinkList) {
+            auto& target = *group.get_table(from.get_link_target(col)->get_index_in_group());
+            to.add_column_link(type, name, target, from.get_link_type(col));
+        }
+        else if (type == type_Table) {
+            DescriptorRef subdesc;
+            to.add_column(type, name, from.is_nullable(col), &subdesc);
+            copy_subtable_columns(from.get_subdescriptor(col), subdesc);
+        }
+        else {
+            to.add_column(type, name, from.is_nullable(col));
+        }
+        if (from.has_search_index(col))
+            to.add_search_index(col);
+    }
+}
+
+// Copy every value of `from` into the same row and column of `to`, which must
+// have the same columns and number of rows. Links are copied as row indices,
+// which are valid as every table is copied in full and in order.
+void copy_values(Table const& from, Table& to)
+{
+    for (size_t col = 0; col < from.get_column_count(); ++col) {
+        auto type = from.get_column_type(col);
+        bool nullable = type != type_Link && type != type_LinkList && type != type_Table && from.is_nullable(col);
+        for (size_t row = 0; row < from.size(); ++row) {
+            if (nullable && from.is_null(col, row)) {
+                to.set_null(col, row);
+                continue;
+            }
+            switch (type) {
+                case type_Int:       to.set_int(col, row, from.get_int(col, row)); break;
+                case type_Bool:      to.set_bool(col, row, from.get_bool(col, row)); break;
+                case type_Float:     to.set_float(col, row, from.get_float(col, row)); break;
+                case type_Double:    to.set_double(col, row, from.get_double(col, row)); break;
+                case type_String:    to.set_string(col, row, from.get_string(col, row)); break;
+                case type_Binary:    to.set_binary(col, row, from.get_binary(col, row)); break;
+                case type_Timestamp: to.set_timestamp(col, row, from.get_timestamp(col, row)); break;
+                case type_OldDateTime: to.set_olddatetime(col, row, from.get_olddatetime(col, row)); break;
+                case type_Link:
+                    if (!from.is_null_link(col, row))
+                        to.set_link(col, row, from.get_link(col, row));
+                    break;
+                case type_LinkList: {
+                    auto source = from.get_linklist(col, row);
+                    auto dest = to.get_linklist(col, row);
+                    for (size_t i = 0; i < source->size(); ++i)
+                        dest->add(source->get(i).get_index());
+                    break;
+                }
+                case type_Table: {
+                    auto source = from.get_subtable(col, row);
+                    auto dest = to.get_subtable(col, row);
+                    dest->add_empty_row(source->size());
+                    copy_values(*source, *dest);
+                    break;
+                }
+                default:
+                    throw std::logic_error(util::format("Column '%1.%2' of the write-behind copy has an unsupported type",
+                                                        from.get_name(), from.get_column_name(col)));
+            }
+        }
+    }
+}
+} // anonymous namespace
+
+WriteBehindFlusher::WriteBehindFlusher(Realm::Config const& config)
+: m_path(config.write_behind_path)
+, m_tmp_path(config.write_behind_path + ".flush")
+, m_encryption_key(config.encryption_key)
+, m_interval(config.write_behind_interval)
+{
+    std::unique_ptr<Group> read_only_group;
+    Realm::open_with_config(config, m_history, m_shared_group, read_only_group, nullptr);
+    REALM_ASSERT(!read_only_group);
+
+    // Nothing may be flushed until the persistent copy has been loaded, as
+    // flushing would replace it
+    load();
+
+    m_thread = std::thread([this] { run(); });
+}
+
+WriteBehindFlusher::~WriteBehindFlusher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+
+    try {
+        flush();
+    }
+    catch (...) {
+        // Nowhere to report the error; the persistent copy is left at the
+        // last version which was successfully flushed
+    }
+}
+
+void WriteBehindFlusher::load()
+{
+    std::lock_guard<std::mutex> lock(m_flush_mutex);
+
+    auto& group = m_shared_group->begin_write();
+    auto rollback = util::make_scope_exit([&]() noexcept {
+        if (m_shared_group->get_transact_stage() == SharedGroup::transact_Writing)
+            m_shared_group->rollback();
+    });
+
+    // The in-memory Realm is only empty if this is the first time it has been
+    // opened since it was last closed; otherwise it's already newer than the
+    // persistent copy
+    if (group.size() == 0 && util::File::exists(m_path)) {
+        Group copy(m_path, m_encryption_key.empty() ? nullptr : m_encryption_key.data());
+        for (size_t i = 0; i < copy.size(); ++i)
+            group.add_table(copy.get_table_name(i));
+        for (size_t i = 0; i < copy.size(); ++i) {
+            copy_columns(*copy.get_table(i), *group.get_table(i), group);
+            group.get_table(i)->add_empty_row(copy.get_table(i)->size());
+        }
+        for (size_t i = 0; i < copy.size(); ++i)
+            copy_values(*copy.get_table(i), *group.get_table(i));
+        m_shared_group->commit();
+    }
+    else {
+        m_shared_group->rollback();
+    }
+
+    m_shared_group->begin_read();
+    m_flushed_version = m_shared_group->get_version_of_current_transaction();
+    m_shared_group->end_read();
+}
+
+void WriteBehindFlusher::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cv.wait_for(lock, m_interval, [&] { return m_stop; })) {
+        lock.unlock();
+        try {
+            flush();
+        }
+        catch (...) {
+            // Retried at the next interval, and reported by the next explicit
+            // flush if it's still failing
+        }
+        lock.lock();
+    }
+}
+
+void WriteBehindFlusher::flush()
+{
+    std::lock_guard<std::mutex> lock(m_flush_mutex);
+
+    auto& group = m_shared_group->begin_read();
+    auto end_read = util::make_scope_exit([&]() noexcept { m_shared_group->end_read(); });
+    auto version = m_shared_group->get_version_of_current_transaction();
+    if (version == m_flushed_version)
+        return;
+
+    // Group::write() refuses to overwrite an existing file, and writing to a
+    // temporary file and then renaming it means that a crash mid-flush leaves
+    // the previous copy intact
+    util::File::try_remove(m_tmp_path);
+    group.write(m_tmp_path, m_encryption_key.empty() ? nullptr : m_encryption_key.data());
+    util::File::move(m_tmp_path, m_path);
+    m_flushed_version = version;
+}
@@ -241,7 +241,7 @@ void ChunkedRangeVectorBuilder::push_back(std::pair<size_t, size_t> range)
         chunk.end = chunk.data.back().second;
         ++m_outer_pos;
         if (m_outer_pos >= m_data.size())
-            m_data.push_back({{range}, range.first, 0, 1});
+            m_data.push_back({{range}, range.first, 0, range.second - range.first});
         else {
             auto& chunk = m_data[m_outer_pos];
             chunk.data.push_back(range);
@@ -292,13 +292,18 @@ size_t IndexSet::count(size_t start_index, size_t end_index) const noexcept
         // Start index is in the middle of a chunk, so start by counting the
         // rest of that chunk
         ret = it->second - std::max(it->first, start_index);
-        for (++it; it != end && it->second < end_index && it.offset() != 0; ++it) {
+        for (++it; it != end && it->second <= end_index && it.offset() != 0; ++it) {
             ret += it->second - it->first;
         }
-        if (it != end && it->first < end_index && it.offset() != 0)
-            ret += end_index - it->first;
-        if (it == end || it->second >= end_index)
+        if (it == end)
             return ret;
+        // If we stopped within the chunk then this range crosses end_index;
+        // otherwise we're at the start of a chunk and can count by chunks
+        if (it.offset() != 0) {
+            if (it->first < end_index)
+                ret += end_index - it->first;
+            return ret;
+        }
     }
 
     // Now count all complete chunks that fall within the range
@@ -327,8 +332,10 @@ IndexSet::iterator IndexSet::find(size_t index) noexcept
 
 IndexSet::iterator IndexSet::find(size_t index, iterator begin) noexcept
 {
-    auto it = std::find_if(begin.outer(), m_data.end(),
-                           [&](auto const& lft) { return lft.end > index; });
+    // Chunks are sorted and non-overlapping, so the chunk containing (or
+    // following) index can be found with a binary search on their end points
+    auto it = std::partition_point(begin.outer(), m_data.end(),
+                                   [&](auto const& lft) { return lft.end <= index; });
     if (it == m_data.end())
         return end();
     if (index < it->begin)
@@ -350,10 +357,53 @@ void IndexSet::add(size_t index)
 
 void IndexSet::add(IndexSet const& other)
 {
-    auto it = begin();
-    for (size_t index : other.as_indexes()) {
-        it = do_add(find(index, it), index);
+    if (other.empty())
+        return;
+    if (empty()) {
+        *this = other;
+        return;
+    }
+
+    // Adding a few indices one at a time is O(log n) each, but for anything
+    // bigger it's cheaper to rebuild the set by merging the two lists of ranges
+    size_t indices_to_add = 0, existing_ranges = 0;
+    for (auto const& chunk : other.m_data)
+        indices_to_add += chunk.count;
+    for (auto const& chunk : m_data)
+        existing_ranges += chunk.data.size();
+
+    if (indices_to_add * 8 < existing_ranges) {
+        auto it = begin();
+        for (size_t index : other.as_indexes()) {
+            it = do_add(find(index, it), index);
+        }
+        return;
+    }
+
+    ChunkedRangeVectorBuilder builder(*this);
+    auto begin1 = cbegin(), end1 = cend();
+    auto begin2 = other.cbegin(), end2 = other.cend();
+
+    value_type current = begin1->first < begin2->first ? *begin1++ : *begin2++;
+    while (begin1 != end1 || begin2 != end2) {
+        value_type next;
+        if (begin2 == end2 || (begin1 != end1 && begin1->first < begin2->first))
+            next = *begin1++;
+        else
+            next = *begin2++;
+
+        if (next.first <= current.second) {
+            current.second = std::max(current.second, next.second);
+        }
+        else {
+            builder.push_back(current);
+            current = next;
+        }
     }
+    builder.push_back(current);
+
+    m_data = builder.finalize();
+    verify();
 }
 
 size_t IndexSet::add_shifted(size_t index)
@@ -655,12 +705,15 @@ void IndexSet::remove(realm::IndexSet const& values)
 
 size_t IndexSet::shift(size_t index) const noexcept
 {
-    // FIXME: optimize
-    for (auto range : *this) {
-        if (range.first > index)
-            break;
-        index += range.second - range.first;
-    }
+    auto it = cbegin(), end = cend();
+
+    // Every range in a chunk which ends at or before index is shifted past,
+    // and index only grows while doing so, so whole chunks can be skipped
+    for (; it != end && it.outer()->end <= index; it.next_chunk())
+        index += it.outer()->count;
+
+    for (; it != end && it->first <= index; ++it)
+        index += it->second - it->first;
     return index;
 }
 
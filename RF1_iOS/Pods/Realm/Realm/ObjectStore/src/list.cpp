@@ -413,9 +413,10 @@ bool List::operator==(List const& rgt) const noexcept
     return m_link_view == rgt.m_link_view && m_table.get() == rgt.m_table.get();
 }
 
-NotificationToken List::add_notification_callback(CollectionChangeCallback cb) &
+NotificationToken List::add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths) &
 {
     verify_attached();
+    _impl::CollectionNotifier::validate_key_paths(*m_table, key_paths);
     // Adding a new callback to a notifier which had all of its callbacks
     // removed does not properly reinitialize the notifier. Work around this by
     // recreating it instead.
@@ -431,7 +432,7 @@ NotificationToken List::add_notification_callback(CollectionChangeCallback cb) &
             m_notifier = std::static_pointer_cast<_impl::CollectionNotifier>(std::make_shared<PrimitiveListNotifier>(m_table, m_realm));
         RealmCoordinator::register_notifier(m_notifier);
     }
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(key_paths))};
 }
 
 List::OutOfBoundsIndexException::OutOfBoundsIndexException(size_t r, size_t c)
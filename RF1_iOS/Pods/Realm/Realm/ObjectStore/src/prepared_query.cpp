@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "prepared_query.hpp"
+
+#include "object_store.hpp"
+#include "results.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/parser/query_builder.hpp>
+#include <realm/query.hpp>
+#include <realm/views.hpp>
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace realm;
+
+namespace {
+// Enough for every distinct query an app runs repeatedly, while bounding the
+// memory used by apps which build query strings with values embedded in them
+const size_t s_max_cached_queries = 256;
+
+std::mutex s_cache_mutex;
+// Most recently used first
+std::list<std::shared_ptr<PreparedQuery const>> s_lru;
+std::unordered_map<std::string, decltype(s_lru)::iterator> s_cache;
+
+std::string cache_key(std::string const& object_type, std::string const& text)
+{
+    // Object type names can't contain a nul, so this can't be ambiguous
+    std::string key;
+    key.reserve(object_type.size() + text.size() + 1);
+    key += object_type;
+    key += '\0';
+    key += text;
+    return key;
+}
+
+TableRef table_for(Realm& realm, std::string const& object_type)
+{
+    auto table = ObjectStore::table_for_object_type(realm.read_group(), object_type);
+    if (!table)
+        throw std::logic_error(util::format("Object type '%1' not found in schema.", object_type));
+    return table;
+}
+
+parser::KeyPathMapping key_path_mapping()
+{
+    parser::KeyPathMapping mapping;
+    mapping.set_allow_backlinks(true);
+    mapping.set_backlink_class_prefix(ObjectStore::table_name_for_object_type(""));
+    return mapping;
+}
+} // anonymous namespace
+
+PreparedQuery::PreparedQuery(std::string object_type, std::string text)
+: m_object_type(std::move(object_type))
+, m_text(std::move(text))
+, m_parsed(parser::parse(m_text))
+{
+}
+
+std::shared_ptr<PreparedQuery const> PreparedQuery::get(std::string const& object_type, std::string const& text)
+{
+    auto key = cache_key(object_type, text);
+    {
+        std::lock_guard<std::mutex> lock(s_cache_mutex);
+        auto it = s_cache.find(key);
+        if (it != s_cache.end()) {
+            s_lru.splice(s_lru.begin(), s_lru, it->second);
+            return *it->second;
+        }
+    }
+
+    // Parse without holding the lock so that a slow parse doesn't block
+    // lookups of other queries. If another thread prepares the same query in
+    // the meantime, whichever gets cached first wins.
+    auto prepared = std::make_shared<PreparedQuery const>(object_type, text);
+
+    std::lock_guard<std::mutex> lock(s_cache_mutex);
+    auto it = s_cache.find(key);
+    if (it != s_cache.end()) {
+        s_lru.splice(s_lru.begin(), s_lru, it->second);
+        return *it->second;
+    }
+    s_lru.push_front(prepared);
+    s_cache.emplace(std::move(key), s_lru.begin());
+    if (s_lru.size() > s_max_cached_queries) {
+        auto& oldest = *s_lru.back();
+        s_cache.erase(cache_key(oldest.m_object_type, oldest.m_text));
+        s_lru.pop_back();
+    }
+    return prepared;
+}
+
+void PreparedQuery::clear_cache()
+{
+    std::lock_guard<std::mutex> lock(s_cache_mutex);
+    s_cache.clear();
+    s_lru.clear();
+}
+
+Query PreparedQuery::query(Realm& realm, std::vector<util::Any> const& arguments) const
+{
+    Query query = table_for(realm, m_object_type)->where();
+    query_builder::AnyContext ctx;
+    query_builder::ArgumentConverter<util::Any, query_builder::AnyContext> args(ctx, arguments.data(), arguments.size());
+    query_builder::apply_predicate(query, m_parsed.predicate, args, key_path_mapping());
+    return query;
+}
+
+Results PreparedQuery::results(std::shared_ptr<Realm> const& realm, std::vector<util::Any> const& arguments) const
+{
+    query_builder::AnyContext ctx;
+    query_builder::ArgumentConverter<util::Any, query_builder::AnyContext> args(ctx, arguments.data(), arguments.size());
+    DescriptorOrdering ordering;
+    query_builder::apply_ordering(ordering, table_for(*realm, m_object_type), m_parsed.ordering, args);
+    return Results(realm, query(*realm, arguments), std::move(ordering));
+}
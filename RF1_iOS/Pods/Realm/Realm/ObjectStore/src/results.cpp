@@ -462,6 +462,31 @@ void Results::clear()
     }
 }
 
+size_t Results::delete_matching(Query&& q)
+{
+    if (m_mode == Mode::Empty)
+        return 0;
+    validate_write();
+
+    auto query = [&] {
+        // Distinct, limit and snapshots pick out particular rows, so the query
+        // has to be restricted to the evaluated rows. Sorting doesn't change
+        // which rows match, so otherwise it's skipped.
+        if (m_mode == Mode::TableView || m_descriptor_ordering.will_apply_distinct()
+            || m_descriptor_ordering.will_apply_limit()) {
+            evaluate_query_if_needed();
+            return Query(*m_table, std::unique_ptr<TableViewBase>(new TableView(m_table_view)));
+        }
+        return get_query();
+    }();
+    query.and_query(std::move(q));
+
+    auto tv = query.find_all();
+    size_t count = tv.size();
+    tv.clear(RemoveMode::unordered);
+    return count;
+}
+
 PropertyType Results::get_type() const
 {
     validate_read();
@@ -729,10 +754,12 @@ void Results::prepare_async(ForCallback force)
     _impl::RealmCoordinator::register_notifier(m_notifier);
 }
 
-NotificationToken Results::add_notification_callback(CollectionChangeCallback cb) &
+NotificationToken Results::add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths) &
 {
+    if (m_table)
+        _impl::CollectionNotifier::validate_key_paths(*m_table, key_paths);
     prepare_async(ForCallback{true});
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(key_paths))};
 }
 
 bool Results::is_in_table_order() const
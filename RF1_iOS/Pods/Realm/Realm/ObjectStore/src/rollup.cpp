@@ -0,0 +1,348 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "rollup.hpp"
+
+#include "impl/collection_notifier.hpp"
+#include "impl/transact_log_handler.hpp"
+#include "object_schema.hpp"
+#include "object_store.hpp"
+#include "property.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/group.hpp>
+#include <realm/table.hpp>
+#include <realm/table_view.hpp>
+
+#include <algorithm>
+#include <map>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+using Function = RollupDefinition::Function;
+
+const char* const s_bucket_property = "bucket";
+const char* const s_count_property = "count";
+
+int64_t bucket_start(int64_t time, int64_t width) noexcept
+{
+    // Round towards negative infinity so that negative times aren't folded
+    // into the bucket starting at zero
+    int64_t start = time / width;
+    if (time % width < 0)
+        --start;
+    return start * width;
+}
+
+// A running aggregate of one column, stored as an int64 for Int source
+// properties and as a double for Float and Double ones
+struct Accumulator {
+    int64_t i = 0;
+    double d = 0;
+};
+
+struct ResolvedRollup {
+    struct Column {
+        size_t source_col;
+        size_t target_col;
+        DataType source_type;
+        Function function;
+    };
+
+    TableRef source;
+    TableRef target;
+    int64_t bucket_width;
+    size_t time_col;
+    size_t bucket_col;
+    size_t count_col;
+    std::vector<Column> columns;
+};
+
+struct PendingBucket {
+    int64_t count = 0;
+    std::vector<Accumulator> values;
+};
+
+size_t column_for(Table& table, StringData object_type, StringData name, bool (*valid_type)(DataType))
+{
+    size_t col = table.get_column_index(name);
+    if (col == npos || table.is_nullable(col) || !valid_type(table.get_column_type(col)))
+        throw std::logic_error(util::format("Rollup property '%1.%2' is missing or has the wrong type",
+                                            object_type, name));
+    return col;
+}
+
+bool is_int(DataType type) { return type == type_Int; }
+bool is_double(DataType type) { return type == type_Double; }
+bool is_numeric(DataType type) { return type == type_Int || type == type_Float || type == type_Double; }
+
+// Get the tables and columns for `definition`, or a ResolvedRollup with no
+// source table if the source type doesn't exist yet
+ResolvedRollup resolve(Group& group, RollupDefinition const& definition)
+{
+    ResolvedRollup rollup;
+    rollup.source = ObjectStore::table_for_object_type(group, definition.source_type);
+    if (!rollup.source)
+        return rollup;
+    rollup.target = ObjectStore::table_for_object_type(group, definition.name);
+    if (!rollup.target)
+        throw std::logic_error(util::format("Object type '%1' for the rollup of '%2' not found in schema.",
+                                            definition.name, definition.source_type));
+
+    auto& source = *rollup.source;
+    auto& target = *rollup.target;
+    rollup.bucket_width = definition.bucket_width;
+    rollup.time_col = column_for(source, definition.source_type, definition.time_property, is_int);
+    rollup.bucket_col = column_for(target, definition.name, s_bucket_property, is_int);
+    rollup.count_col = column_for(target, definition.name, s_count_property, is_int);
+    for (auto& aggregate : definition.aggregates) {
+        size_t source_col = column_for(source, definition.source_type, aggregate.property, is_numeric);
+        auto source_type = source.get_column_type(source_col);
+        auto target_name = Rollup::column_name(aggregate);
+        size_t target_col = column_for(target, definition.name, target_name,
+                                       source_type == type_Int ? is_int : is_double);
+        rollup.columns.push_back({source_col, target_col, source_type, aggregate.function});
+    }
+    return rollup;
+}
+
+template<typename T>
+T combine(Function function, T a, T b)
+{
+    switch (function) {
+        case Function::Sum: return a + b;
+        case Function::Min: return std::min(a, b);
+        case Function::Max: return std::max(a, b);
+    }
+    REALM_UNREACHABLE();
+}
+
+void add_row(ResolvedRollup const& rollup, std::map<int64_t, PendingBucket>& buckets, size_t row)
+{
+    auto& source = *rollup.source;
+    auto& bucket = buckets[bucket_start(source.get_int(rollup.time_col, row), rollup.bucket_width)];
+    bool first = bucket.count++ == 0;
+    if (first)
+        bucket.values.resize(rollup.columns.size());
+
+    for (size_t i = 0; i < rollup.columns.size(); ++i) {
+        auto& column = rollup.columns[i];
+        auto& value = bucket.values[i];
+        switch (column.source_type) {
+            case type_Int: {
+                int64_t v = source.get_int(column.source_col, row);
+                value.i = first ? v : combine(column.function, value.i, v);
+                break;
+            }
+            case type_Float: {
+                double v = source.get_float(column.source_col, row);
+                value.d = first ? v : combine(column.function, value.d, v);
+                break;
+            }
+            default: {
+                double v = source.get_double(column.source_col, row);
+                value.d = first ? v : combine(column.function, value.d, v);
+                break;
+            }
+        }
+    }
+}
+
+// Merge the pending buckets into the stored ones, creating any which don't
+// exist yet
+void apply(ResolvedRollup const& rollup, std::map<int64_t, PendingBucket> const& buckets)
+{
+    auto& target = *rollup.target;
+    for (auto& bucket : buckets) {
+        size_t row = target.find_first_int(rollup.bucket_col, bucket.first);
+        bool created = row == npos;
+        if (created) {
+            row = target.add_empty_row();
+            target.set_int(rollup.bucket_col, row, bucket.first);
+        }
+        target.set_int(rollup.count_col, row, target.get_int(rollup.count_col, row) + bucket.second.count);
+
+        for (size_t i = 0; i < rollup.columns.size(); ++i) {
+            auto& column = rollup.columns[i];
+            auto& value = bucket.second.values[i];
+            if (column.source_type == type_Int) {
+                int64_t v = created ? value.i : combine(column.function, target.get_int(column.target_col, row), value.i);
+                target.set_int(column.target_col, row, v);
+            }
+            else {
+                double v = created ? value.d : combine(column.function, target.get_double(column.target_col, row), value.d);
+                target.set_double(column.target_col, row, v);
+            }
+        }
+    }
+}
+} // anonymous namespace
+
+ObjectSchema Rollup::object_schema(RollupDefinition const& definition, ObjectSchema const& source_schema)
+{
+    if (definition.name.empty())
+        throw std::invalid_argument("Rollup name must not be empty");
+    if (definition.bucket_width <= 0)
+        throw std::invalid_argument(util::format("Rollup '%1' bucket width must be greater than zero", definition.name));
+    if (source_schema.name != definition.source_type)
+        throw std::invalid_argument(util::format("Rollup '%1' is of '%2', not '%3'",
+                                                 definition.name, definition.source_type, source_schema.name));
+
+    auto time_prop = source_schema.property_for_name(definition.time_property);
+    if (!time_prop || time_prop->type != PropertyType::Int)
+        throw std::invalid_argument(util::format("Rollup time property '%1.%2' must be a non-optional int",
+                                                 definition.source_type, definition.time_property));
+
+    ObjectSchema schema(definition.name, {
+        {s_bucket_property, PropertyType::Int, Property::IsPrimary{false}, Property::IsIndexed{true}},
+        {s_count_property, PropertyType::Int},
+    });
+    for (auto& aggregate : definition.aggregates) {
+        auto prop = source_schema.property_for_name(aggregate.property);
+        if (!prop || (prop->type != PropertyType::Int && prop->type != PropertyType::Float
+                      && prop->type != PropertyType::Double))
+            throw std::invalid_argument(util::format("Rollup property '%1.%2' must be a non-optional int, float or double",
+                                                     definition.source_type, aggregate.property));
+        schema.persisted_properties.push_back({column_name(aggregate),
+            prop->type == PropertyType::Int ? PropertyType::Int : PropertyType::Double});
+    }
+    return schema;
+}
+
+std::string Rollup::column_name(RollupDefinition::Aggregate const& aggregate)
+{
+    switch (aggregate.function) {
+        case Function::Sum: return aggregate.property + "_sum";
+        case Function::Min: return aggregate.property + "_min";
+        case Function::Max: return aggregate.property + "_max";
+    }
+    REALM_UNREACHABLE();
+}
+
+void Rollup::rebuild(Realm& realm, RollupDefinition const& definition)
+{
+    realm.verify_in_write();
+    auto rollup = resolve(realm.read_group(), definition);
+    if (!rollup.source)
+        throw std::logic_error(util::format("Object type '%1' not found in schema.", definition.source_type));
+
+    std::map<int64_t, PendingBucket> buckets;
+    for (size_t row = 0, size = rollup.source->size(); row < size; ++row)
+        add_row(rollup, buckets, row);
+    rollup.target->clear();
+    apply(rollup, buckets);
+}
+
+std::vector<RollupBucket> Rollup::read(Realm& realm, RollupDefinition const& definition,
+                                       int64_t begin, int64_t end, int64_t width)
+{
+    realm.verify_thread();
+    if (width == 0)
+        width = definition.bucket_width;
+    if (width <= 0 || width % definition.bucket_width != 0)
+        throw std::invalid_argument(util::format("Rollup '%1' can only be read in multiples of its bucket width (%2)",
+                                                 definition.name, definition.bucket_width));
+
+    std::vector<RollupBucket> result;
+    auto rollup = resolve(realm.read_group(), definition);
+    if (!rollup.source || begin >= end)
+        return result;
+
+    auto& target = *rollup.target;
+    auto rows = target.where().greater_equal(rollup.bucket_col, begin).less(rollup.bucket_col, end).find_all();
+    std::map<int64_t, RollupBucket> merged;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        size_t row = rows.get_source_ndx(i);
+        int64_t start = bucket_start(target.get_int(rollup.bucket_col, row), width);
+        auto& bucket = merged[start];
+        bool first = bucket.count == 0;
+        if (first) {
+            bucket.start = start;
+            bucket.values.resize(rollup.columns.size());
+        }
+        bucket.count += target.get_int(rollup.count_col, row);
+
+        for (size_t c = 0; c < rollup.columns.size(); ++c) {
+            auto& column = rollup.columns[c];
+            double v = column.source_type == type_Int ? double(target.get_int(column.target_col, row))
+                                                       : target.get_double(column.target_col, row);
+            bucket.values[c] = first ? v : combine(column.function, bucket.values[c], v);
+        }
+    }
+
+    result.reserve(merged.size());
+    for (auto& bucket : merged)
+        result.push_back(std::move(bucket.second));
+    return result;
+}
+
+void Rollup::update(Group& group, Replication& history, std::vector<RollupDefinition> const& rollups)
+{
+    std::vector<ResolvedRollup> resolved;
+    TransactionChangeInfo info{};
+    for (auto& definition : rollups) {
+        auto rollup = resolve(group, definition);
+        if (!rollup.source)
+            continue;
+        size_t ndx = rollup.source->get_index_in_group();
+        if (info.table_modifications_needed.size() <= ndx) {
+            info.table_modifications_needed.resize(ndx + 1);
+            info.table_moves_needed.resize(ndx + 1);
+        }
+        info.table_modifications_needed[ndx] = true;
+        info.table_moves_needed[ndx] = true;
+        resolved.push_back(std::move(rollup));
+    }
+    if (resolved.empty())
+        return;
+
+    try {
+        transaction::collect_uncommitted_changes(history, info);
+    }
+    catch (UnsupportedSchemaChange const&) {
+        // Schema changes in the same write (such as a migration) make row
+        // positions in the log meaningless. Rollups over data written by a
+        // migration can be recomputed with rebuild().
+        return;
+    }
+
+    std::map<int64_t, PendingBucket> buckets;
+    for (auto& rollup : resolved) {
+        size_t ndx = rollup.source->get_index_in_group();
+        if (ndx >= info.tables.size())
+            continue;
+        // Copy rather than finalize the builder in place, as several rollups
+        // can share a source table
+        auto changes = CollectionChangeBuilder(info.tables[ndx]).finalize();
+        if (changes.insertions.empty())
+            continue;
+
+        // A row moved by an unordered delete shows up as an insertion at its
+        // new position, but isn't a new object
+        IndexSet new_rows = changes.insertions;
+        for (auto& move : changes.moves)
+            new_rows.remove(move.to);
+
+        buckets.clear();
+        for (auto row : new_rows.as_indexes())
+            add_row(rollup, buckets, row);
+        apply(rollup, buckets);
+    }
+}
@@ -18,8 +18,10 @@
 
 #include "shared_realm.hpp"
 
+#include "impl/async_write_queue.hpp"
 #include "impl/collection_notifier.hpp"
 #include "impl/realm_coordinator.hpp"
+#include "impl/retention_engine.hpp"
 #include "impl/transact_log_handler.hpp"
 
 #include "binding_context.hpp"
@@ -32,6 +34,7 @@
 #include "thread_safe_reference.hpp"
 
 #include <realm/history.hpp>
+#include <realm/util/file.hpp>
 #include <realm/util/scope_exit.hpp>
 
 #if REALM_ENABLE_SYNC
@@ -148,6 +151,16 @@ static bool is_nonupgradable_history(IncompatibleHistories const& ex)
 }
 #endif
 
+static SharedGroupOptions::Durability to_core_durability(Durability durability)
+{
+    switch (durability) {
+        case Durability::Full:    return SharedGroupOptions::Durability::Full;
+        case Durability::MemOnly: return SharedGroupOptions::Durability::MemOnly;
+        case Durability::Async:   return SharedGroupOptions::Durability::Async;
+    }
+    REALM_UNREACHABLE();
+}
+
 void Realm::open_with_config(const Config& config,
                              std::unique_ptr<Replication>& history,
                              std::unique_ptr<SharedGroup>& shared_group,
@@ -178,8 +191,7 @@ void Realm::open_with_config(const Config& config,
             }
 
             SharedGroupOptions options;
-            options.durability = config.in_memory ? SharedGroupOptions::Durability::MemOnly :
-                                                    SharedGroupOptions::Durability::Full;
+            options.durability = to_core_durability(config.effective_durability());
             options.encryption_key = config.encryption_key.data();
             options.allow_file_format_upgrade = !config.disable_format_upgrade &&
                                                 config.schema_mode != SchemaMode::ResetFile;
@@ -226,7 +238,7 @@ void Realm::open_with_config(const Config& config,
 Realm::~Realm()
 {
     if (m_coordinator) {
-        m_coordinator->unregister_realm(this);
+        close();
     }
 }
 
@@ -324,6 +336,7 @@ bool Realm::reset_file(Schema& schema, std::vector<SchemaChange>& required_chang
     open_with_config(m_config, m_history, m_shared_group, m_read_only_group, this);
     m_schema = ObjectStore::schema_from_group(read_group());
     m_schema_version = ObjectStore::get_schema_version(read_group());
+    ++m_schema_generation;
     required_changes = m_schema.compare(schema);
     m_coordinator->clear_schema_cache_and_set_schema_version(m_schema_version);
     return false;
@@ -483,10 +496,12 @@ void Realm::update_schema(Schema schema, uint64_t version, MigrationFunction mig
         // migration function needs to see the target schema on the "new" Realm
         std::swap(m_schema, schema);
         std::swap(m_schema_version, version);
+        ++m_schema_generation;
         m_in_migration = true;
         auto restore = util::make_scope_exit([&]() noexcept {
             std::swap(m_schema, schema);
             std::swap(m_schema_version, version);
+            ++m_schema_generation;
             m_in_migration = false;
         });
 
@@ -509,9 +524,11 @@ void Realm::update_schema(Schema schema, uint64_t version, MigrationFunction mig
         uint64_t temp_version = ObjectStore::get_schema_version(read_group());
         std::swap(m_schema, schema);
         std::swap(m_schema_version, temp_version);
+        ++m_schema_generation;
         auto restore = util::make_scope_exit([&]() noexcept {
             std::swap(m_schema, schema);
             std::swap(m_schema_version, temp_version);
+            ++m_schema_generation;
         });
         initialization_function(shared_from_this());
     }
@@ -580,6 +597,7 @@ void Realm::translate_schema_error()
 
 void Realm::notify_schema_changed()
 {
+    ++m_schema_generation;
     if (m_binding_context) {
         m_binding_context->schema_did_change(m_schema);
     }
@@ -678,6 +696,8 @@ void Realm::commit_transaction()
         throw InvalidTransactionException("Can't commit a non-existing write transaction");
     }
 
+    for (auto& buffer : m_write_buffers)
+        buffer.second->flush();
     m_coordinator->commit_write(*this);
     cache_new_schema();
     invalidate_permission_cache();
@@ -692,10 +712,20 @@ void Realm::cancel_transaction()
         throw InvalidTransactionException("Can't cancel a non-existing write transaction");
     }
 
+    for (auto& buffer : m_write_buffers)
+        buffer.second->discard();
     transaction::cancel(*m_shared_group, m_binding_context.get());
     invalidate_permission_cache();
 }
 
+void Realm::async_write(AsyncWriteFunction write, AsyncWriteCompletion completion)
+{
+    check_write(this);
+    verify_open();
+
+    m_coordinator->async_write_queue().push(std::move(write), std::move(completion));
+}
+
 void Realm::invalidate()
 {
     verify_open();
@@ -740,6 +770,37 @@ bool Realm::compact()
     return m_shared_group->compact();
 }
 
+Realm::CompactionResult Realm::compact_if_needed(Config const& config)
+{
+    if (config.immutable() || config.read_only_alternative() || config.in_memory)
+        throw std::logic_error("Only writable on-disk Realms can be compacted");
+    if (config.compaction_free_ratio < 0 || config.compaction_free_ratio >= 1)
+        throw std::logic_error("The compaction free space ratio must be at least 0 and less than 1");
+
+    // Opening the file below would create it
+    if (!util::File::exists(config.path))
+        return CompactionResult::NotNeeded;
+
+    std::unique_ptr<Replication> history;
+    std::unique_ptr<SharedGroup> shared_group;
+    std::unique_ptr<Group> read_only_group;
+    open_with_config(config, history, shared_group, read_only_group, nullptr);
+
+    // SharedGroup::get_stats() only has the stats from a commit made with
+    // that SharedGroup, so measure the latest snapshot against the file
+    // instead of writing to the file just to read them
+    uint64_t used_space = shared_group->begin_read().get_used_space();
+    shared_group->end_read();
+    uint64_t file_size = util::File(config.path).get_size();
+    uint64_t free_space = file_size > used_space ? file_size - used_space : 0;
+    if (file_size < config.compaction_min_size || free_space < config.compaction_free_ratio * file_size)
+        return CompactionResult::NotNeeded;
+
+    // compact() returns false without doing anything if any other SharedGroups
+    // have the file open
+    return shared_group->compact() ? CompactionResult::Compacted : CompactionResult::FileInUse;
+}
+
 void Realm::write_copy(StringData path, BinaryData key)
 {
     if (key.data() && key.size() != 64) {
@@ -764,6 +825,60 @@ OwnedBinaryData Realm::write_copy()
     return OwnedBinaryData(std::unique_ptr<char[]>((char*)buffer.data()), buffer.size());
 }
 
+void Realm::write_copy(util::CopySink sink, bool compress, size_t chunk_size)
+{
+    verify_thread();
+    util::CopyStreamBuf buffer(std::move(sink), compress, chunk_size);
+    std::ostream out(&buffer);
+    // Rethrow errors from the sink rather than just setting badbit
+    out.exceptions(std::ios_base::badbit);
+    read_group().write(out);
+    buffer.finish();
+}
+
+void Realm::import_copy(util::CopySource const& source, std::string const& path)
+{
+    util::File file;
+    try {
+        file.open(path, util::File::access_ReadWrite, util::File::create_Must, 0);
+    }
+    catch (...) {
+        translate_file_exception(path);
+    }
+
+    try {
+        util::read_copy_stream(source, file);
+        file.sync();
+    }
+    catch (...) {
+        file.close();
+        util::File::try_remove(path);
+        throw;
+    }
+}
+
+void Realm::flush_write_behind()
+{
+    verify_open();
+    if (m_config.write_behind_path.empty())
+        return;
+    try {
+        m_coordinator->flush_write_behind();
+    }
+    catch (...) {
+        translate_file_exception(m_config.write_behind_path);
+    }
+}
+
+size_t Realm::enforce_retention()
+{
+    verify_thread();
+    if (is_in_transaction())
+        throw InvalidTransactionException("Cannot enforce retention policies while in a write transaction");
+    return RetentionEngine::enforce(*this, m_config.retention_policies,
+                                    std::max<size_t>(m_config.retention_batch_size, 1));
+}
+
 void Realm::notify()
 {
     if (is_closed() || is_in_transaction()) {
@@ -893,11 +1008,18 @@ void Realm::close()
 
     m_permissions_cache = nullptr;
     m_table_info_cache = nullptr;
+    m_write_buffers.clear();
     m_group = nullptr;
     m_shared_group = nullptr;
     m_history = nullptr;
     m_read_only_group = nullptr;
     m_binding_context = nullptr;
+
+    // Only once the SharedGroup is closed, as a background compaction may be
+    // waiting for the file
+    if (m_coordinator) {
+        m_coordinator->did_close_realm();
+    }
     m_coordinator = nullptr;
 }
 
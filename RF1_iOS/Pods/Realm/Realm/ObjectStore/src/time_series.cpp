@@ -0,0 +1,399 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "time_series.hpp"
+
+#include "impl/time_series_codec.hpp"
+#include "object_schema.hpp"
+#include "object_store.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/table.hpp>
+#include <realm/table_view.hpp>
+
+#include <algorithm>
+#include <tuple>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+const char* const s_start_property = "start";
+const char* const s_end_property = "end";
+const char* const s_count_property = "count";
+const char* const s_time_property = "time";
+
+bool is_reserved_name(StringData name)
+{
+    return name == s_start_property || name == s_end_property
+        || name == s_count_property || name == s_time_property;
+}
+
+size_t column_for(ObjectSchema const& object_schema, const char* name, PropertyType type)
+{
+    auto prop = object_schema.property_for_name(name);
+    if (!prop || prop->type != type)
+        throw std::logic_error(util::format("'%1' is not a time series type: property '%2' is missing or has the wrong type",
+                                            object_schema.name, name));
+    return prop->table_column;
+}
+} // anonymous namespace
+
+// The chunk which samples are being appended to. Its streams are kept encoded
+// here so that appending to it doesn't copy and rewrite the whole chunk, and
+// its row is only written when it's flushed. The cached state is valid for as
+// long as the table's version counter is the one recorded when it was last
+// read or written.
+class TimeSeries::OpenChunk : public Realm::WriteBuffer {
+public:
+    OpenChunk(TableRef table, size_t start_col, size_t end_col, size_t count_col, std::vector<size_t> stream_cols)
+    : m_table(std::move(table)), m_start_col(start_col), m_end_col(end_col), m_count_col(count_col)
+    , m_stream_cols(std::move(stream_cols)), m_streams(m_stream_cols.size())
+    {
+    }
+
+    bool has_columns(Table const& table, size_t start_col, size_t end_col, size_t count_col,
+                     std::vector<size_t> const& stream_cols) const noexcept
+    {
+        return m_table.get() == &table && m_start_col == start_col && m_end_col == end_col
+            && m_count_col == count_col && m_stream_cols == stream_cols;
+    }
+
+    bool has_unflushed_samples() const noexcept { return m_row != npos && m_count != m_flushed_count; }
+
+    // Make sure the cached chunk matches the table, reading it if the table
+    // has changed since. Leaves no chunk open if the table is empty.
+    void load();
+
+    // Flush the current chunk and start a new one beginning at `time`
+    void start(int64_t time);
+
+    // Append `n` samples to the current chunk, which must have room for them
+    void append(size_t offset, size_t n, const int64_t* times, const int64_t* const* columns);
+
+    bool is_open() const noexcept { return m_row != npos; }
+    size_t count() const noexcept { return m_count; }
+    int64_t end() const noexcept { return m_end; }
+
+    void flush() override;
+    void discard() noexcept override { m_row = npos; }
+
+private:
+    TableRef m_table;
+    size_t m_start_col;
+    size_t m_end_col;
+    size_t m_count_col;
+    // The time column followed by the value columns
+    std::vector<size_t> m_stream_cols;
+
+    size_t m_row = npos;
+    int64_t m_end = 0;
+    size_t m_count = 0;
+    size_t m_flushed_count = 0;
+    std::vector<std::vector<char>> m_streams;
+    uint_fast64_t m_table_version = 0;
+
+    size_t last_chunk() const;
+};
+
+size_t TimeSeries::OpenChunk::last_chunk() const
+{
+    if (m_table->size() == 0)
+        return npos;
+
+    // Chunks only share a time key at their boundaries, so the last chunk is
+    // the one which ends latest, and of those the one which starts latest.
+    // A run of identical time keys can leave several chunks with the same
+    // start and end, in which case all but one of them are full.
+    int64_t latest_end = m_table->maximum_int(m_end_col);
+    auto rows = m_table->where().equal(m_end_col, latest_end).find_all();
+    size_t best = npos;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        size_t row = rows.get_source_ndx(i);
+        if (best == npos) {
+            best = row;
+            continue;
+        }
+        int64_t start = m_table->get_int(m_start_col, row);
+        int64_t best_start = m_table->get_int(m_start_col, best);
+        if (start > best_start || (start == best_start
+                                   && m_table->get_int(m_count_col, row) < m_table->get_int(m_count_col, best)))
+            best = row;
+    }
+    return best;
+}
+
+void TimeSeries::OpenChunk::load()
+{
+    if (m_row != npos && m_table->get_version_counter() == m_table_version)
+        return;
+    if (has_unflushed_samples())
+        throw std::logic_error(util::format("The '%1' table was modified while it had unflushed time series samples",
+                                            m_table->get_name()));
+
+    m_row = last_chunk();
+    if (m_row == npos)
+        return;
+    m_end = m_table->get_int(m_end_col, m_row);
+    m_count = m_flushed_count = size_t(m_table->get_int(m_count_col, m_row));
+    for (size_t i = 0; i < m_streams.size(); ++i) {
+        auto stream = m_table->get_binary(m_stream_cols[i], m_row);
+        m_streams[i].assign(stream.data(), stream.data() + stream.size());
+    }
+    m_table_version = m_table->get_version_counter();
+}
+
+void TimeSeries::OpenChunk::start(int64_t time)
+{
+    flush();
+    m_row = m_table->add_empty_row();
+    m_table->set_int(m_start_col, m_row, time);
+    m_table->set_int(m_end_col, m_row, time);
+    m_end = time;
+    m_count = m_flushed_count = 0;
+    for (auto& stream : m_streams)
+        time_series::init_stream(stream);
+    m_table_version = m_table->get_version_counter();
+}
+
+void TimeSeries::OpenChunk::append(size_t offset, size_t n, const int64_t* times, const int64_t* const* columns)
+{
+    time_series::append_values(m_streams[0], times + offset, n);
+    for (size_t i = 1; i < m_streams.size(); ++i)
+        time_series::append_values(m_streams[i], columns[i - 1] + offset, n);
+    m_end = times[offset + n - 1];
+    m_count += n;
+}
+
+void TimeSeries::OpenChunk::flush()
+{
+    if (!has_unflushed_samples())
+        return;
+    for (size_t i = 0; i < m_streams.size(); ++i)
+        m_table->set_binary(m_stream_cols[i], m_row, BinaryData(m_streams[i].data(), m_streams[i].size()));
+    m_table->set_int(m_end_col, m_row, m_end);
+    m_table->set_int(m_count_col, m_row, int64_t(m_count));
+    m_flushed_count = m_count;
+    m_table_version = m_table->get_version_counter();
+}
+
+ObjectSchema TimeSeries::object_schema(std::string name, std::vector<std::string> const& columns)
+{
+    ObjectSchema schema(std::move(name), {
+        {s_start_property, PropertyType::Int, Property::IsPrimary{false}, Property::IsIndexed{true}},
+        {s_end_property, PropertyType::Int, Property::IsPrimary{false}, Property::IsIndexed{true}},
+        {s_count_property, PropertyType::Int},
+        {s_time_property, PropertyType::Data},
+    });
+    for (auto& column : columns) {
+        if (is_reserved_name(column))
+            throw std::invalid_argument(util::format("'%1' cannot be used as a time series column name", column));
+        schema.persisted_properties.push_back({column, PropertyType::Data});
+    }
+    return schema;
+}
+
+TimeSeries::TimeSeries(std::shared_ptr<Realm> realm, StringData object_type, size_t chunk_size)
+: m_realm(std::move(realm))
+, m_chunk_size(chunk_size)
+{
+    if (chunk_size == 0)
+        throw std::invalid_argument("Time series chunk size must be greater than zero");
+
+    auto it = m_realm->schema().find(object_type);
+    if (it == m_realm->schema().end())
+        throw std::logic_error(util::format("Object type '%1' not found in schema.", object_type));
+    auto& object_schema = *it;
+
+    m_table = ObjectStore::table_for_object_type(m_realm->read_group(), object_type);
+    m_start_col = column_for(object_schema, s_start_property, PropertyType::Int);
+    m_end_col = column_for(object_schema, s_end_property, PropertyType::Int);
+    m_count_col = column_for(object_schema, s_count_property, PropertyType::Int);
+    m_time_col = column_for(object_schema, s_time_property, PropertyType::Data);
+    for (auto& prop : object_schema.persisted_properties) {
+        if (is_reserved_name(prop.name))
+            continue;
+        if (prop.type != PropertyType::Data)
+            throw std::logic_error(util::format("'%1' is not a time series type: property '%2' is not binary data",
+                                                object_schema.name, prop.name));
+        m_value_cols.push_back(prop.table_column);
+    }
+
+    std::vector<size_t> stream_cols{m_time_col};
+    stream_cols.insert(stream_cols.end(), m_value_cols.begin(), m_value_cols.end());
+
+    // Every TimeSeries for the type on this Realm appends through the same open
+    // chunk, so that none of them append to a stale copy of it
+    auto& buffer = Realm::Internal::get_write_buffer(*m_realm, "TimeSeries " + object_schema.name);
+    m_open_chunk = std::static_pointer_cast<OpenChunk>(buffer);
+    if (!m_open_chunk || !m_open_chunk->has_columns(*m_table, m_start_col, m_end_col, m_count_col, stream_cols)) {
+        if (m_open_chunk && m_open_chunk->has_unflushed_samples())
+            throw std::logic_error(util::format("The schema for '%1' changed while it had unflushed time series samples",
+                                                object_schema.name));
+        m_open_chunk = std::make_shared<OpenChunk>(m_table, m_start_col, m_end_col, m_count_col, std::move(stream_cols));
+        buffer = m_open_chunk;
+    }
+}
+
+size_t TimeSeries::column_index(StringData name) const noexcept
+{
+    for (size_t i = 0; i < m_value_cols.size(); ++i) {
+        if (m_table->get_column_name(m_value_cols[i]) == name)
+            return i;
+    }
+    return npos;
+}
+
+size_t TimeSeries::size() const
+{
+    flush_open_chunk();
+    return size_t(m_table->sum_int(m_count_col));
+}
+
+TimeSeries::Chunk TimeSeries::get_chunk(size_t row) const
+{
+    return {row, m_table->get_int(m_start_col, row), m_table->get_int(m_end_col, row),
+            size_t(m_table->get_int(m_count_col, row))};
+}
+
+std::vector<TimeSeries::Chunk> TimeSeries::chunks_in_range(int64_t begin, int64_t end) const
+{
+    std::vector<Chunk> chunks;
+    if (begin >= end)
+        return chunks;
+
+    auto rows = m_table->where().less(m_start_col, end).greater_equal(m_end_col, begin).find_all();
+    chunks.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        chunks.push_back(get_chunk(rows.get_source_ndx(i)));
+    std::sort(chunks.begin(), chunks.end(), [](auto const& a, auto const& b) {
+        return std::tie(a.start, a.end) < std::tie(b.start, b.end);
+    });
+    return chunks;
+}
+
+void TimeSeries::append(int64_t time, const int64_t* values)
+{
+    std::vector<const int64_t*> columns(m_value_cols.size());
+    for (size_t i = 0; i < columns.size(); ++i)
+        columns[i] = values + i;
+    append(1, &time, columns.data());
+}
+
+void TimeSeries::append(size_t count, const int64_t* times, const int64_t* const* columns)
+{
+    m_realm->verify_in_write();
+    if (count == 0)
+        return;
+    if (!std::is_sorted(times, times + count))
+        throw std::invalid_argument("Time series samples must be appended in time order");
+
+    m_open_chunk->load();
+    if (m_open_chunk->is_open() && times[0] < m_open_chunk->end())
+        throw std::invalid_argument("Time series samples must be appended in time order");
+
+    size_t appended = 0;
+    while (appended < count) {
+        if (!m_open_chunk->is_open() || m_open_chunk->count() >= m_chunk_size)
+            m_open_chunk->start(times[appended]);
+
+        size_t n = std::min(count - appended, m_chunk_size - m_open_chunk->count());
+        m_open_chunk->append(appended, n, times, columns);
+        appended += n;
+    }
+}
+
+void TimeSeries::flush()
+{
+    flush_open_chunk();
+}
+
+void TimeSeries::flush_open_chunk() const
+{
+    m_realm->verify_thread();
+    if (m_realm->is_in_transaction())
+        m_open_chunk->flush();
+}
+
+void TimeSeries::read(int64_t begin, int64_t end, std::vector<int64_t>& times,
+                      std::vector<std::vector<int64_t>>& columns) const
+{
+    flush_open_chunk();
+    times.clear();
+    columns.assign(m_value_cols.size(), {});
+
+    std::vector<int64_t> chunk_times;
+    std::vector<int64_t> chunk_values;
+    for (auto& chunk : chunks_in_range(begin, end)) {
+        chunk_times.resize(chunk.count);
+        time_series::decode_values(m_table->get_binary(m_time_col, chunk.row), chunk.count, chunk_times.data());
+        // Times are sorted within a chunk, so the samples in range are contiguous
+        size_t first = std::lower_bound(chunk_times.begin(), chunk_times.end(), begin) - chunk_times.begin();
+        size_t last = std::lower_bound(chunk_times.begin() + first, chunk_times.end(), end) - chunk_times.begin();
+        times.insert(times.end(), chunk_times.begin() + first, chunk_times.begin() + last);
+
+        for (size_t i = 0; i < m_value_cols.size(); ++i) {
+            chunk_values.resize(chunk.count);
+            time_series::decode_values(m_table->get_binary(m_value_cols[i], chunk.row), last, chunk_values.data());
+            columns[i].insert(columns[i].end(), chunk_values.begin() + first, chunk_values.begin() + last);
+        }
+    }
+}
+
+TimeSeries::Aggregate TimeSeries::aggregate(size_t column, int64_t begin, int64_t end) const
+{
+    flush_open_chunk();
+    if (column >= m_value_cols.size())
+        throw std::out_of_range(util::format("Time series column index %1 is out of range (%2 columns)",
+                                             column, m_value_cols.size()));
+
+    Aggregate result;
+    std::vector<int64_t> chunk_times;
+    std::vector<int64_t> values;
+    for (auto& chunk : chunks_in_range(begin, end)) {
+        size_t first = 0, last = chunk.count;
+        // Only chunks which straddle the ends of the range need their time
+        // keys decoded
+        if (chunk.start < begin || chunk.end >= end) {
+            chunk_times.resize(chunk.count);
+            time_series::decode_values(m_table->get_binary(m_time_col, chunk.row), chunk.count, chunk_times.data());
+            first = std::lower_bound(chunk_times.begin(), chunk_times.end(), begin) - chunk_times.begin();
+            last = std::lower_bound(chunk_times.begin() + first, chunk_times.end(), end) - chunk_times.begin();
+            if (first == last)
+                continue;
+        }
+
+        values.resize(last);
+        time_series::decode_values(m_table->get_binary(m_value_cols[column], chunk.row), last, values.data());
+
+        // Kept to straight-line loops over a flat buffer so that they vectorize
+        int64_t sum = 0, min = values[first], max = values[first];
+        for (size_t i = first; i < last; ++i) {
+            sum += values[i];
+            min = std::min(min, values[i]);
+            max = std::max(max, values[i]);
+        }
+        result.min = result.count ? std::min(result.min, min) : min;
+        result.max = result.count ? std::max(result.max, max) : max;
+        result.sum += sum;
+        result.count += last - first;
+    }
+    return result;
+}
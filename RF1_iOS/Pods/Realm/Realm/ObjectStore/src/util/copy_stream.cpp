@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "util/copy_stream.hpp"
+
+#include <realm/util/file.hpp>
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+using namespace realm;
+using namespace realm::util;
+
+namespace {
+// Realm files start with an 8-byte aligned ref, so can never start with this
+const char s_compressed_magic[4] = {'R', 'L', 'M', 'Z'};
+const uint32_t s_format_version = 1;
+// Magic, format version and chunk size
+const size_t s_stream_header_size = 12;
+const size_t s_frame_header_size = 8;
+// Used for copying uncompressed streams
+const size_t s_uncompressed_read_size = 1024 * 1024;
+
+void store_u32(char* out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out[i] = char((value >> (8 * i)) & 0xFF);
+}
+
+uint32_t load_u32(const char* in)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= uint32_t(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+// Read exactly `size` bytes unless the stream ends first, returning the number read
+size_t read_fully(CopySource const& source, char* buffer, size_t size)
+{
+    size_t total = 0;
+    while (total < size) {
+        size_t n = source(buffer + total, size - total);
+        if (n == 0)
+            break;
+        total += n;
+    }
+    return total;
+}
+
+void read_exactly(CopySource const& source, char* buffer, size_t size)
+{
+    if (read_fully(source, buffer, size) != size)
+        throw std::runtime_error("Realm copy stream ended unexpectedly");
+}
+} // anonymous namespace
+
+CopyStreamBuf::CopyStreamBuf(CopySink sink, bool compress, size_t chunk_size)
+: m_sink(std::move(sink))
+, m_compress(compress)
+, m_buffer(chunk_size)
+{
+    if (chunk_size == 0 || chunk_size > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("Copy chunk size must be greater than zero and fit in 32 bits");
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+CopyStreamBuf::int_type CopyStreamBuf::overflow(int_type ch)
+{
+    write_chunk();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int CopyStreamBuf::sync()
+{
+    // Chunks are only passed on when full, so that the chunk size is honored
+    // regardless of how the writer flushes
+    return 0;
+}
+
+void CopyStreamBuf::finish()
+{
+    write_chunk();
+    if (m_compress)
+        write_frame_header(0, 0);
+    setp(nullptr, nullptr);
+}
+
+void CopyStreamBuf::write_frame_header(uint32_t uncompressed_size, uint32_t stored_size)
+{
+    if (!m_started) {
+        char header[s_stream_header_size];
+        memcpy(header, s_compressed_magic, sizeof(s_compressed_magic));
+        store_u32(header + 4, s_format_version);
+        store_u32(header + 8, uint32_t(m_buffer.size()));
+        m_sink(BinaryData(header, sizeof(header)));
+        m_started = true;
+    }
+
+    char frame[s_frame_header_size];
+    store_u32(frame, uncompressed_size);
+    store_u32(frame + 4, stored_size);
+    m_sink(BinaryData(frame, sizeof(frame)));
+}
+
+void CopyStreamBuf::write_chunk()
+{
+    size_t size = pptr() - pbase();
+    if (size == 0)
+        return;
+
+    if (!m_compress) {
+        m_sink(BinaryData(pbase(), size));
+    }
+    else {
+        // The arena and output buffer are reused for every chunk, so memory use
+        // stays at what's needed for one chunk
+        size_t compressed_size = compression::allocate_and_compress(m_arena, BinaryData(pbase(), size),
+                                                                    m_compressed);
+        if (compressed_size < size) {
+            write_frame_header(uint32_t(size), uint32_t(compressed_size));
+            m_sink(BinaryData(m_compressed.data(), compressed_size));
+        }
+        else {
+            write_frame_header(uint32_t(size), uint32_t(size));
+            m_sink(BinaryData(pbase(), size));
+        }
+    }
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+void realm::util::read_copy_stream(CopySource const& source, File& out)
+{
+    char header[s_stream_header_size];
+    size_t header_size = read_fully(source, header, sizeof(header));
+
+    if (header_size < sizeof(s_compressed_magic) ||
+        memcmp(header, s_compressed_magic, sizeof(s_compressed_magic)) != 0) {
+        // Not compressed, so just copy it as-is
+        out.write(header, header_size);
+        std::vector<char> buffer(s_uncompressed_read_size);
+        while (size_t n = source(buffer.data(), buffer.size()))
+            out.write(buffer.data(), n);
+        return;
+    }
+
+    if (header_size != sizeof(header))
+        throw std::runtime_error("Realm copy stream ended unexpectedly");
+    if (load_u32(header + 4) != s_format_version)
+        throw std::runtime_error("Unsupported Realm copy stream format version");
+    size_t chunk_size = load_u32(header + 8);
+
+    std::vector<char> stored;
+    std::vector<char> decompressed(chunk_size);
+    while (true) {
+        char frame[s_frame_header_size];
+        read_exactly(source, frame, sizeof(frame));
+        size_t uncompressed_size = load_u32(frame);
+        size_t stored_size = load_u32(frame + 4);
+        if (uncompressed_size == 0)
+            return;
+        // Checking against the chunk size bounds the memory a corrupt stream
+        // can make us allocate
+        if (uncompressed_size > chunk_size || stored_size > uncompressed_size)
+            throw std::runtime_error("Corrupt Realm copy stream");
+
+        stored.resize(stored_size);
+        read_exactly(source, stored.data(), stored_size);
+        if (stored_size == uncompressed_size) {
+            out.write(stored.data(), stored_size);
+            continue;
+        }
+
+        if (auto ec = compression::decompress(stored.data(), stored_size, decompressed.data(), uncompressed_size))
+            throw std::system_error(ec);
+        out.write(decompressed.data(), uncompressed_size);
+    }
+}
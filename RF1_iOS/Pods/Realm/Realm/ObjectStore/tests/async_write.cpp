@@ -0,0 +1,239 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "impl/async_write_queue.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace realm;
+using namespace std::chrono;
+
+namespace {
+// What each write saw, filled in on the writer thread and only read by the
+// test once every completion has been called. Catch assertions aren't
+// thread-safe, so nothing is checked on the writer thread itself.
+struct WriteLog {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<uint_fast64_t> versions;
+    std::vector<std::exception_ptr> errors;
+    std::vector<size_t> completions;
+    std::vector<std::thread::id> completion_threads;
+
+    explicit WriteLog(size_t count)
+    : versions(count), errors(count), completions(count), completion_threads(count)
+    {
+    }
+
+    Realm::AsyncWriteFunction write(size_t i, bool fail = false)
+    {
+        return [=](Realm& realm) {
+            auto table = realm.read_group().get_table("class_object");
+            table->set_int(0, table->add_empty_row(), int64_t(i));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                versions[i] = TestHelper::get_shared_group(realm).get_version_of_current_transaction().version;
+            }
+            if (fail)
+                throw std::runtime_error("write failed");
+        };
+    }
+
+    Realm::AsyncWriteCompletion completion(size_t i)
+    {
+        return [=](std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                errors[i] = error;
+                ++completions[i];
+                completion_threads[i] = std::this_thread::get_id();
+            }
+            cv.notify_all();
+        };
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool done = cv.wait_for(lock, seconds(10), [&] {
+            return std::all_of(completions.begin(), completions.end(), [](size_t c) { return c > 0; });
+        });
+        REQUIRE(done);
+    }
+};
+} // anonymous namespace
+
+TEST_CASE("async_write") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int}
+        }},
+    };
+
+    auto open = [&] {
+        auto r = Realm::get_shared_realm(config);
+        return std::make_pair(r, r->read_group().get_table("class_object"));
+    };
+
+    SECTION("writes are committed in batches of async_write_batch_size") {
+        config.async_write_batch_size = 5;
+        config.async_write_max_latency = milliseconds(500);
+        auto realm = open();
+        auto r = realm.first;
+
+        WriteLog log(12);
+        for (size_t i = 0; i < 12; ++i)
+            r->async_write(log.write(i), log.completion(i));
+        log.wait();
+
+        for (size_t i = 1; i < 12; ++i) {
+            if (i % 5 == 0)
+                REQUIRE(log.versions[i] > log.versions[i - 1]);
+            else
+                REQUIRE(log.versions[i] == log.versions[i - 1]);
+        }
+        r->refresh();
+        REQUIRE(realm.second->size() == 12);
+        for (size_t i = 0; i < 12; ++i)
+            REQUIRE(realm.second->get_int(0, i) == int64_t(i));
+    }
+
+    SECTION("a partial batch is committed once async_write_max_latency has passed") {
+        config.async_write_batch_size = 1000;
+        config.async_write_max_latency = milliseconds(100);
+        auto realm = open();
+        auto r = realm.first;
+
+        WriteLog log(3);
+        auto start = steady_clock::now();
+        r->async_write(log.write(0), log.completion(0));
+        r->async_write(log.write(1), log.completion(1));
+        std::this_thread::sleep_for(milliseconds(300));
+        size_t completed_before_third;
+        {
+            std::lock_guard<std::mutex> lock(log.mutex);
+            completed_before_third = log.completions[0] + log.completions[1];
+        }
+        r->async_write(log.write(2), log.completion(2));
+        log.wait();
+
+        // The first two didn't wait for a full batch
+        REQUIRE(completed_before_third == 2);
+        REQUIRE(steady_clock::now() - start >= milliseconds(300));
+        REQUIRE(log.versions[0] == log.versions[1]);
+        REQUIRE(log.versions[2] > log.versions[1]);
+        r->refresh();
+        REQUIRE(realm.second->size() == 3);
+    }
+
+    SECTION("a throwing write is dropped and the rest of its batch is committed") {
+        config.async_write_batch_size = 3;
+        config.async_write_max_latency = seconds(5);
+        auto realm = open();
+        auto r = realm.first;
+
+        WriteLog log(3);
+        r->async_write(log.write(0), log.completion(0));
+        r->async_write(log.write(1, true), log.completion(1));
+        r->async_write(log.write(2), log.completion(2));
+        log.wait();
+
+        REQUIRE_FALSE(log.errors[0]);
+        REQUIRE(log.errors[1]);
+        REQUIRE_THROWS_WITH(std::rethrow_exception(log.errors[1]), "write failed");
+        REQUIRE_FALSE(log.errors[2]);
+        REQUIRE(log.versions[0] == log.versions[2]);
+
+        r->refresh();
+        REQUIRE(realm.second->size() == 2);
+        REQUIRE(realm.second->get_int(0, 0) == 0);
+        REQUIRE(realm.second->get_int(0, 1) == 2);
+    }
+
+    SECTION("each completion is called once on the writer thread after the commit") {
+        config.async_write_batch_size = 2;
+        config.async_write_max_latency = milliseconds(10);
+        auto realm = open();
+        auto r = realm.first;
+
+        WriteLog log(5);
+        for (size_t i = 0; i < 5; ++i)
+            r->async_write(log.write(i), log.completion(i));
+        log.wait();
+        // Give any stray second call a chance to happen
+        std::this_thread::sleep_for(milliseconds(50));
+
+        for (size_t i = 0; i < 5; ++i) {
+            REQUIRE(log.completions[i] == 1);
+            REQUIRE_FALSE(log.errors[i]);
+            REQUIRE(log.completion_threads[i] != std::this_thread::get_id());
+        }
+
+        // The commit is visible by the time the completion is called
+        r->refresh();
+        REQUIRE(realm.second->size() == 5);
+        auto version = TestHelper::get_shared_group(r).get_version_of_current_transaction().version;
+        for (size_t i = 0; i < 5; ++i)
+            REQUIRE(log.versions[i] < version);
+    }
+
+    SECTION("destroying the queue waits for the queued writes") {
+        config.async_write_batch_size = 1;
+        config.async_write_max_latency = milliseconds(0);
+        auto realm = open();
+        auto r = realm.first;
+
+        const size_t count = 20;
+        WriteLog log(count);
+        {
+            _impl::AsyncWriteQueue queue(config);
+            for (size_t i = 0; i < count; ++i) {
+                auto write = log.write(i);
+                queue.push([=](Realm& realm) {
+                    std::this_thread::sleep_for(milliseconds(1));
+                    write(realm);
+                }, log.completion(i));
+            }
+        }
+
+        // Every write has completed by the time the destructor returns
+        for (size_t i = 0; i < count; ++i) {
+            REQUIRE(log.completions[i] == 1);
+            REQUIRE_FALSE(log.errors[i]);
+        }
+        r->refresh();
+        REQUIRE(realm.second->size() == count);
+    }
+}
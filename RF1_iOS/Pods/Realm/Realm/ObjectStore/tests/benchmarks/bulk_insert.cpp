@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "bulk_insert.hpp"
+#include "impl/object_accessor_impl.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+#include <vector>
+
+using namespace realm;
+
+// Importing a batch of sensor samples with Object::create(), as the app does
+// for each sample, and with a BulkInserter, and deleting them again one object
+// at a time and with Results::delete_matching()
+TEST_CASE("Benchmark bulk insert and delete") {
+    const size_t count = 100000;
+
+    InMemoryTestFile config;
+    config.schema = Schema{
+        {"sample", {
+            {"index", PropertyType::Int},
+            {"forefoot", PropertyType::Int},
+            {"heel", PropertyType::Int},
+            {"temperature", PropertyType::Double},
+        }},
+    };
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_sample");
+
+    std::vector<int64_t> index(count), forefoot(count), heel(count);
+    std::vector<double> temperature(count);
+    for (size_t i = 0; i < count; ++i) {
+        index[i] = int64_t(i);
+        forefoot[i] = int64_t(i * 7 % 1024);
+        heel[i] = int64_t(i * 13 % 1024);
+        temperature[i] = 30.0 + double(i % 50) / 10;
+    }
+
+    // Catch runs each benchmark many times, so each starts from an empty table
+    // rather than after the rows the previous one created
+    auto clear = [&] {
+        r->begin_transaction();
+        table->clear();
+        r->commit_transaction();
+    };
+
+    BENCHMARK_ADVANCED("Object::create()")(Catch::Benchmark::Chronometer meter) {
+        clear();
+        CppContext ctx(r);
+        auto& object_schema = *r->schema().find("sample");
+        meter.measure([&] {
+            r->begin_transaction();
+            for (size_t i = 0; i < count; ++i) {
+                Object::create(ctx, r, object_schema, util::Any(AnyDict{
+                    {"index", index[i]},
+                    {"forefoot", forefoot[i]},
+                    {"heel", heel[i]},
+                    {"temperature", temperature[i]},
+                }));
+            }
+            r->commit_transaction();
+        });
+    };
+
+    BENCHMARK_ADVANCED("BulkInserter::insert()")(Catch::Benchmark::Chronometer meter) {
+        clear();
+        BulkInserter inserter(r, "sample", {"index", "forefoot", "heel", "temperature"});
+        meter.measure([&] {
+            r->begin_transaction();
+            inserter.insert(count, {index.data(), forefoot.data(), heel.data(), temperature.data()});
+            r->commit_transaction();
+        });
+    };
+
+    // Each run imports the batch and then deletes it again in two passes, so
+    // that every run starts from an empty table and the deleted rows are
+    // spread over the whole table rather than at one end of it
+    auto delete_passes = [&] {
+        return std::vector<Query>{table->where().less(2, int64_t(512)), table->where().greater_equal(2, int64_t(512))};
+    };
+
+    BENCHMARK_ADVANCED("Object::create() and deleting each object")(Catch::Benchmark::Chronometer meter) {
+        clear();
+        CppContext ctx(r);
+        auto& object_schema = *r->schema().find("sample");
+        meter.measure([&] {
+            r->begin_transaction();
+            for (size_t i = 0; i < count; ++i) {
+                Object::create(ctx, r, object_schema, util::Any(AnyDict{
+                    {"index", index[i]},
+                    {"forefoot", forefoot[i]},
+                    {"heel", heel[i]},
+                    {"temperature", temperature[i]},
+                }));
+            }
+            r->commit_transaction();
+
+            for (auto& query : delete_passes()) {
+                r->begin_transaction();
+                auto results = Results(r, std::move(query)).snapshot();
+                for (size_t i = 0; i < results.size(); ++i) {
+                    Object object(r, object_schema, results.get(i));
+                    object.row().move_last_over();
+                }
+                r->commit_transaction();
+            }
+        });
+    };
+
+    BENCHMARK_ADVANCED("BulkInserter::insert() and Results::delete_matching()")(Catch::Benchmark::Chronometer meter) {
+        clear();
+        BulkInserter inserter(r, "sample", {"index", "forefoot", "heel", "temperature"});
+        meter.measure([&] {
+            r->begin_transaction();
+            inserter.insert(count, {index.data(), forefoot.data(), heel.data(), temperature.data()});
+            r->commit_transaction();
+
+            for (auto& query : delete_passes()) {
+                r->begin_transaction();
+                Results(r, *table).delete_matching(std::move(query));
+                r->commit_transaction();
+            }
+        });
+    };
+}
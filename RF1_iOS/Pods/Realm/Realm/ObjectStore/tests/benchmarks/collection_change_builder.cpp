@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "impl/collection_change_builder.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+// The row lists for a sorted Results before and after a commit which
+// deletes, inserts and modifies the given numbers of random rows. Modified
+// rows get a new sort key, so they usually move.
+struct SortedChange {
+    std::vector<size_t> old_rows;
+    std::vector<size_t> new_rows;
+    std::vector<bool> modified;
+
+    SortedChange(size_t count, size_t deletions, size_t insertions, size_t modifications)
+    {
+        std::mt19937 rng(count + deletions + insertions + modifications);
+        std::uniform_int_distribution<int64_t> key_dist;
+        std::uniform_int_distribution<size_t> row_dist(0, count - 1);
+
+        std::vector<int64_t> keys(count);
+        for (auto& key : keys)
+            key = key_dist(rng);
+        old_rows = sorted_rows(keys, std::vector<bool>(count));
+
+        std::vector<bool> deleted(count + insertions);
+        modified.resize(count + insertions);
+        for (size_t i = 0; i < deletions; ++i)
+            deleted[row_dist(rng)] = true;
+        for (size_t i = 0; i < modifications; ++i) {
+            size_t row = row_dist(rng);
+            modified[row] = true;
+            keys[row] = key_dist(rng);
+        }
+        for (size_t i = 0; i < insertions; ++i)
+            keys.push_back(key_dist(rng));
+        new_rows = sorted_rows(keys, deleted);
+    }
+
+private:
+    static std::vector<size_t> sorted_rows(std::vector<int64_t> const& keys, std::vector<bool> const& deleted)
+    {
+        std::vector<size_t> rows;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (!deleted[i])
+                rows.push_back(i);
+        }
+        std::stable_sort(rows.begin(), rows.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+        return rows;
+    }
+};
+} // anonymous namespace
+
+// Diffing a large sorted Results, where there are no move candidates and
+// the moves come from the longest common subsequence of the two row lists
+TEST_CASE("Benchmark CollectionChangeBuilder::calculate() for sorted results") {
+    const size_t count = 100000;
+
+    auto benchmark = [&](const char* name, size_t deletions, size_t insertions, size_t modifications) {
+        SortedChange change(count, deletions, insertions, modifications);
+        auto row_did_change = [&](size_t row) { return change.modified[row]; };
+        BENCHMARK(name) {
+            return CollectionChangeBuilder::calculate(change.old_rows, change.new_rows, row_did_change);
+        };
+    };
+
+    benchmark("no changes", 0, 0, 0);
+    benchmark("0.1% inserted, deleted and modified", count / 1000, count / 1000, count / 1000);
+    benchmark("1% inserted, deleted and modified", count / 100, count / 100, count / 100);
+    benchmark("10% inserted, deleted and modified", count / 10, count / 10, count / 10);
+    benchmark("10% inserted", 0, count / 10, 0);
+    benchmark("10% deleted", count / 10, 0, 0);
+    benchmark("10% modified", 0, 0, count / 10);
+}
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "impl/collection_notifier.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/link_view.hpp>
+
+using namespace realm;
+using namespace realm::_impl;
+
+// Checking every object in a table for modifications made to objects they
+// link to through a List, as a notifier on that table does after a commit
+// which only modified the linked objects
+TEST_CASE("Benchmark DeepChangeChecker over List links") {
+    const size_t parent_count = 10000;
+    const size_t child_count = 10000;
+    const size_t list_size = 10;
+
+    InMemoryTestFile config;
+    config.schema = Schema{
+        {"parent", {
+            {"value", PropertyType::Int},
+            {"children", PropertyType::Array|PropertyType::Object, "child"},
+        }},
+        {"child", {
+            {"value", PropertyType::Int},
+        }},
+    };
+    auto r = Realm::get_shared_realm(config);
+    auto& group = r->read_group();
+    auto parent = group.get_table("class_parent");
+    auto child = group.get_table("class_child");
+    size_t children_col = parent->get_column_index("children");
+
+    r->begin_transaction();
+    parent->add_empty_row(parent_count);
+    child->add_empty_row(child_count);
+    for (size_t i = 0; i < parent_count; ++i) {
+        auto lv = parent->get_linklist(children_col, i);
+        for (size_t j = 0; j < list_size; ++j)
+            lv->add((i * list_size + j * 7919) % child_count);
+    }
+    r->commit_transaction();
+
+    auto related = DeepChangeChecker::RelatedTables::make(*parent);
+
+    // Change info for a commit which modified every `stride`th child
+    auto change_info = [&](size_t stride) {
+        TransactionChangeInfo info{};
+        info.tables.resize(group.size());
+        if (stride) {
+            auto& changes = info.tables[child->get_index_in_group()];
+            for (size_t i = 0; i < child_count; i += stride)
+                changes.modify(i);
+        }
+        return info;
+    };
+
+    auto benchmark = [&](const char* name, size_t stride) {
+        auto info = change_info(stride);
+        BENCHMARK(name) {
+            DeepChangeChecker checker(info, *parent, related);
+            size_t modified = 0;
+            for (size_t i = 0; i < parent_count; ++i)
+                modified += checker(i);
+            return modified;
+        };
+    };
+
+    benchmark("no children modified", 0);
+    benchmark("1% of children modified", 100);
+    benchmark("10% of children modified", 10);
+    benchmark("every child modified", 1);
+}
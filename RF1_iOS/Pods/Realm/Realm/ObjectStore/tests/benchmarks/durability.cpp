@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+using namespace realm;
+
+// Small commits, one per sample as the app makes them, with each durability
+// setting. Full syncs every commit, MemOnly never touches the disk and Async
+// leaves syncing to core's commit daemon where there is one.
+TEST_CASE("Benchmark commit throughput by durability") {
+    const size_t commits = 100;
+
+    auto benchmark = [&](const char* name, Durability durability) {
+        TestFile config;
+        config.durability = durability;
+        config.schema = Schema{
+            {"sample", {
+                {"index", PropertyType::Int},
+                {"value", PropertyType::Int},
+            }},
+        };
+        auto r = Realm::get_shared_realm(config);
+        auto table = r->read_group().get_table("class_sample");
+
+        BENCHMARK(name) {
+            for (size_t i = 0; i < commits; ++i) {
+                r->begin_transaction();
+                size_t row = table->add_empty_row();
+                table->set_int(0, row, int64_t(row));
+                table->set_int(1, row, int64_t(i));
+                r->commit_transaction();
+            }
+            return table->size();
+        };
+    };
+
+    benchmark("100 commits with Full durability", Durability::Full);
+    benchmark("100 commits with MemOnly durability", Durability::MemOnly);
+#ifdef REALM_ASYNC_DAEMON
+    benchmark("100 commits with Async durability", Durability::Async);
+#endif
+}
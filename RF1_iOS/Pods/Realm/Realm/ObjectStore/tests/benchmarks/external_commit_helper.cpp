@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "collection_notifications.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace realm;
+
+// The time from a commit in another process to a notification being
+// delivered here: the other process's commit_write() signalling the .note
+// pipe, this process's listener thread waking up and running on_change(), and
+// the notifier being run for the new version.
+TEST_CASE("Benchmark cross-process commit notification") {
+    InMemoryTestFile config;
+    config.automatic_change_notifications = true;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+        }},
+    };
+
+    int commands[2];
+    REQUIRE(pipe(commands) == 0);
+    pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        // Commit once for each byte the parent sends, until it closes the
+        // pipe. Leaves with _exit() so that the TestFile copied from the
+        // parent doesn't remove the parent's directory.
+        close(commands[1]);
+        {
+            auto r = Realm::get_shared_realm(config);
+            auto table = r->read_group().get_table("class_object");
+            char command;
+            while (read(commands[0], &command, 1) == 1) {
+                r->begin_transaction();
+                table->add_empty_row();
+                r->commit_transaction();
+            }
+        }
+        _exit(0);
+    }
+    close(commands[0]);
+
+    auto r = Realm::get_shared_realm(config);
+    Results results(r, *r->read_group().get_table("class_object"));
+    size_t calls = 0;
+    auto token = results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+        ++calls;
+    });
+    // Registering a notifier doesn't wake the listener thread
+    advance_and_notify(*r);
+    REQUIRE(calls == 1);
+
+    // There's no event loop to deliver notifications on this platform, so
+    // spin on notify(), which delivers them once the notifier has run
+    auto commit_and_wait = [&] {
+        size_t expected = calls + 1;
+        char command = 'c';
+        REQUIRE(write(commands[1], &command, 1) == 1);
+        while (calls < expected)
+            r->notify();
+    };
+
+    BENCHMARK("commit in another process to notification") {
+        commit_and_wait();
+    };
+
+    close(commands[1]);
+    waitpid(child, nullptr, 0);
+}
@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "bulk_insert.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/group.hpp>
+#include <realm/link_view.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace realm;
+
+TEST_CASE("BulkInserter") {
+    TestFile config;
+    config.schema = Schema{
+        {"sample", {
+            {"a", PropertyType::Int},
+            {"b", PropertyType::Int},
+            {"c", PropertyType::Int|PropertyType::Nullable},
+        }},
+    };
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_sample");
+
+    int64_t b[] = {1, 2, 3};
+    int64_t c[] = {10, 20, 30};
+    BulkInserter inserter(r, "sample", {"b", "c"});
+
+    SECTION("sets the listed properties") {
+        r->begin_transaction();
+        inserter.insert(3, {b, c});
+        r->commit_transaction();
+        REQUIRE(table->size() == 3);
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(table->get_int(0, i) == 0);
+            REQUIRE(table->get_int(1, i) == b[i]);
+            REQUIRE(table->get_int(2, i) == c[i]);
+        }
+    }
+
+    SECTION("rejects mismatched columns without creating objects") {
+        double d[] = {1, 2, 3};
+        bool nulls[] = {false, true, false};
+        r->begin_transaction();
+        REQUIRE_THROWS_AS(inserter.insert(3, {b}), std::invalid_argument);
+        REQUIRE_THROWS_AS(inserter.insert(3, {b, d}), std::invalid_argument);
+        REQUIRE_THROWS_AS(inserter.insert(3, {{b, nulls}, c}), std::invalid_argument);
+        REQUIRE(table->size() == 0);
+        inserter.insert(3, {b, {c, nulls}});
+        REQUIRE(table->is_null(2, 1));
+        r->cancel_transaction();
+    }
+
+    SECTION("follows the columns when the schema changes") {
+        // Removing "a" moves the columns after it down by one
+        r->update_schema(Schema{
+            {"sample", {
+                {"b", PropertyType::Int},
+                {"c", PropertyType::Int|PropertyType::Nullable},
+            }},
+        }, 1, [](auto, auto, auto&) {});
+        REQUIRE(table->get_column_index("c") == 1);
+
+        r->begin_transaction();
+        inserter.insert(3, {b, c});
+        r->commit_transaction();
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(table->get_int(0, i) == b[i]);
+            REQUIRE(table->get_int(1, i) == c[i]);
+        }
+    }
+
+    SECTION("throws if a property is removed from the schema") {
+        r->update_schema(Schema{
+            {"sample", {
+                {"a", PropertyType::Int},
+                {"b", PropertyType::Int},
+            }},
+        }, 1, [](auto, auto, auto&) {});
+
+        r->begin_transaction();
+        REQUIRE_THROWS_AS(inserter.insert(3, {b, c}), std::logic_error);
+        REQUIRE(table->size() == 0);
+        r->cancel_transaction();
+    }
+}
+
+TEST_CASE("Results::delete_matching()") {
+    TestFile config;
+    config.schema = Schema{
+        {"sample", {
+            {"a", PropertyType::Int},
+            {"b", PropertyType::Int},
+        }},
+        {"parent", {
+            {"samples", PropertyType::Array|PropertyType::Object, "sample"},
+        }},
+    };
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_sample");
+    auto parent = r->read_group().get_table("class_parent");
+
+    // a = 0...9 and b = a % 3, with the even rows also in the parent's list
+    r->begin_transaction();
+    table->add_empty_row(10);
+    parent->add_empty_row();
+    auto list = parent->get_linklist(0, 0);
+    for (size_t i = 0; i < 10; ++i) {
+        table->set_int(0, i, i);
+        table->set_int(1, i, i % 3);
+        if (i % 2 == 0)
+            list->add(i);
+    }
+    r->commit_transaction();
+
+    auto a_at_least = [&](int64_t value) { return table->where().greater_equal(0, value); };
+    auto remaining = [&] {
+        std::vector<int64_t> values;
+        for (size_t i = 0; i < table->size(); ++i)
+            values.push_back(table->get_int(0, i));
+        std::sort(values.begin(), values.end());
+        return values;
+    };
+
+    r->begin_transaction();
+
+    SECTION("deletes the matching rows of a table") {
+        Results results(r, *table);
+        REQUIRE(results.delete_matching(a_at_least(5)) == 5);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 1, 2, 3, 4}));
+        REQUIRE(results.size() == 5);
+    }
+
+    SECTION("deletes the rows which match both the query and the results") {
+        Results results(r, table->where().less(0, 8));
+        REQUIRE(results.delete_matching(a_at_least(5)) == 3);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 1, 2, 3, 4, 8, 9}));
+    }
+
+    SECTION("ignores sorting") {
+        auto results = Results(r, *table).sort({{"a", false}});
+        REQUIRE(results.delete_matching(a_at_least(5)) == 5);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 1, 2, 3, 4}));
+    }
+
+    SECTION("deletes only the objects in a list") {
+        Results results(r, list);
+        REQUIRE(results.delete_matching(a_at_least(5)) == 2);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 1, 2, 3, 4, 5, 7, 9}));
+        REQUIRE(list->size() == 3);
+        REQUIRE(results.size() == 3);
+    }
+
+    SECTION("is restricted to the rows within a limit") {
+        auto results = Results(r, *table).sort({{"a", false}}).limit(3);
+        REQUIRE(results.delete_matching(a_at_least(8)) == 2);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+    }
+
+    SECTION("is restricted to the rows picked by distinct") {
+        // The first row for each value of b is a = 0, 1 and 2
+        auto results = Results(r, *table).distinct({"b"});
+        REQUIRE(results.delete_matching(a_at_least(1)) == 2);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 3, 4, 5, 6, 7, 8, 9}));
+    }
+
+    SECTION("is restricted to the rows in a snapshot") {
+        auto results = Results(r, a_at_least(5)).snapshot();
+        size_t row = table->add_empty_row();
+        table->set_int(0, row, 100);
+        REQUIRE(results.delete_matching(a_at_least(0)) == 5);
+        REQUIRE(remaining() == (std::vector<int64_t>{0, 1, 2, 3, 4, 100}));
+    }
+
+    SECTION("deletes nothing for empty results") {
+        REQUIRE(Results().delete_matching(a_at_least(0)) == 0);
+        REQUIRE(table->size() == 10);
+    }
+
+    SECTION("requires a write transaction") {
+        r->cancel_transaction();
+        Results results(r, *table);
+        REQUIRE_THROWS_AS(results.delete_matching(a_at_least(0)), InvalidTransactionException);
+        REQUIRE(table->size() == 10);
+        r->begin_transaction();
+    }
+
+    r->cancel_transaction();
+}
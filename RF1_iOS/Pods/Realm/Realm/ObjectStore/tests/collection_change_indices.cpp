@@ -0,0 +1,261 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+
+#include "impl/collection_change_builder.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace realm;
+using _impl::CollectionChangeBuilder;
+
+namespace {
+auto none_modified = [](size_t) { return false; };
+
+// Apply `c` to `prev` the way a binding would, taking inserted values from `next`
+std::vector<size_t> apply(std::vector<size_t> prev, CollectionChangeSet const& c,
+                          std::vector<size_t> const& next)
+{
+    for (auto it = c.deletions.end(); it != c.deletions.begin(); ) {
+        --it;
+        prev.erase(prev.begin() + it->first, prev.begin() + it->second);
+    }
+    for (auto i : c.insertions.as_indexes())
+        prev.insert(prev.begin() + i, next[i]);
+    return prev;
+}
+
+// Scores a common subsequence the way calculate() ranks them: its length,
+// then how many unmodified rows it keeps in place
+struct Score {
+    size_t length;
+    size_t unmodified;
+    bool operator==(Score const& s) const { return length == s.length && unmodified == s.unmodified; }
+    bool operator<(Score const& s) const
+    {
+        return length < s.length || (length == s.length && unmodified < s.unmodified);
+    }
+};
+
+// The best possible score, by the textbook O(N*M) dynamic programming LCS
+template<typename Modified>
+Score reference_score(std::vector<size_t> const& a, std::vector<size_t> const& b, Modified&& modified)
+{
+    std::vector<std::vector<Score>> dp(a.size() + 1, std::vector<Score>(b.size() + 1, Score{0, 0}));
+    for (size_t i = 1; i <= a.size(); ++i) {
+        for (size_t j = 1; j <= b.size(); ++j) {
+            dp[i][j] = std::max(dp[i - 1][j], dp[i][j - 1]);
+            if (a[i - 1] == b[j - 1]) {
+                auto& d = dp[i - 1][j - 1];
+                dp[i][j] = std::max(dp[i][j], Score{d.length + 1, d.unmodified + !modified(b[j - 1])});
+            }
+        }
+    }
+    return dp[a.size()][b.size()];
+}
+
+// The score of the subsequence which a change set leaves in place
+template<typename Modified>
+Score kept_score(std::vector<size_t> const& next, CollectionChangeSet const& c, Modified&& modified)
+{
+    Score score{0, 0};
+    for (size_t i = 0; i < next.size(); ++i) {
+        if (c.insertions.contains(i))
+            continue;
+        ++score.length;
+        score.unmodified += !modified(next[i]);
+    }
+    return score;
+}
+
+// Fill `prev` with random rows and `next` with the result of a few random
+// inserts, deletes and moves on it. Rows are below `range`, and only repeat if
+// `duplicates` is set.
+void random_edit(std::mt19937& rng, size_t range, bool duplicates,
+                 std::vector<size_t>& prev, std::vector<size_t>& next)
+{
+    size_t next_unique = 0;
+    auto new_row = [&] { return duplicates ? rng() % range : next_unique++; };
+
+    prev.resize(rng() % 20);
+    for (auto& row : prev)
+        row = new_row();
+    if (!duplicates)
+        std::shuffle(prev.begin(), prev.end(), rng);
+
+    next = prev;
+    for (int edits = rng() % 6; edits > 0; --edits) {
+        switch (rng() % 3) {
+            case 0:
+                if (!next.empty())
+                    next.erase(next.begin() + rng() % next.size());
+                break;
+            case 1:
+                next.insert(next.begin() + rng() % (next.size() + 1), new_row());
+                break;
+            case 2:
+                if (next.size() > 1) {
+                    size_t from = rng() % next.size();
+                    auto row = next[from];
+                    next.erase(next.begin() + from);
+                    next.insert(next.begin() + rng() % (next.size() + 1), row);
+                }
+                break;
+        }
+    }
+}
+
+// Length of the longest increasing subsequence, which for a permutation of
+// 0..N-1 is the LCS with the identity
+size_t longest_increasing(std::vector<size_t> const& values)
+{
+    std::vector<size_t> tails;
+    for (auto v : values) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), v);
+        if (it == tails.end())
+            tails.push_back(v);
+        else
+            *it = v;
+    }
+    return tails.size();
+}
+} // anonymous namespace
+
+TEST_CASE("collection_change: calculate() sorted") {
+    _impl::CollectionChangeBuilder c;
+
+    SECTION("returns an empty set when the rows are unchanged") {
+        c = CollectionChangeBuilder::calculate({1, 2, 3}, {1, 2, 3}, none_modified);
+        REQUIRE(c.empty());
+    }
+
+    SECTION("marks rows which changed as modified") {
+        c = CollectionChangeBuilder::calculate({1, 2, 3}, {1, 2, 3}, [](size_t row) { return row == 2; });
+        REQUIRE_INDICES(c.modifications, 1);
+        REQUIRE(c.deletions.empty());
+        REQUIRE(c.insertions.empty());
+    }
+
+    SECTION("reports rows which are only in one side as inserted or deleted") {
+        c = CollectionChangeBuilder::calculate({1, 2, 3}, {1, 3, 4}, none_modified);
+        REQUIRE_INDICES(c.deletions, 1);
+        REQUIRE_INDICES(c.insertions, 2);
+    }
+
+    SECTION("reports a row moved towards the end as a delete and an insert") {
+        c = CollectionChangeBuilder::calculate({1, 2, 3}, {2, 3, 1}, none_modified);
+        REQUIRE_INDICES(c.deletions, 0);
+        REQUIRE_INDICES(c.insertions, 2);
+    }
+
+    SECTION("reports a row moved towards the start as a delete and an insert") {
+        c = CollectionChangeBuilder::calculate({1, 2, 3}, {3, 1, 2}, none_modified);
+        REQUIRE_INDICES(c.deletions, 2);
+        REQUIRE_INDICES(c.insertions, 0);
+    }
+
+    SECTION("moves the modified row when either row could move") {
+        c = CollectionChangeBuilder::calculate({1, 2}, {2, 1}, [](size_t row) { return row == 2; });
+        REQUIRE_INDICES(c.deletions, 1);
+        REQUIRE_INDICES(c.insertions, 0);
+
+        c = CollectionChangeBuilder::calculate({1, 2}, {2, 1}, [](size_t row) { return row == 1; });
+        REQUIRE_INDICES(c.deletions, 0);
+        REQUIRE_INDICES(c.insertions, 1);
+    }
+
+    SECTION("prefers a smaller diff over moving only modified rows") {
+        c = CollectionChangeBuilder::calculate({1, 2, 3}, {3, 1, 2}, [](size_t row) { return row != 3; });
+        REQUIRE_INDICES(c.deletions, 2);
+        REQUIRE_INDICES(c.insertions, 0);
+    }
+
+    SECTION("finds the longest common subsequence rather than splitting on the first longest block") {
+        // Splitting around the matching block {1} leaves nothing else to
+        // keep, while {2, 3} and {2, 4} are both common subsequences
+        c = CollectionChangeBuilder::calculate({1, 2, 3, 4}, {2, 4, 3, 1}, none_modified);
+        REQUIRE(c.deletions.count() == 2);
+        REQUIRE(c.insertions.count() == 2);
+    }
+
+    SECTION("supports duplicate rows") {
+        std::vector<size_t> prev = {1, 1, 2, 2, 3, 3};
+        std::vector<size_t> next = {1, 2, 3, 1, 2, 3};
+        c = CollectionChangeBuilder::calculate(prev, next, none_modified);
+        REQUIRE(apply(prev, c, next) == next);
+        REQUIRE(c.deletions.count() == 2);
+        REQUIRE(c.insertions.count() == 2);
+    }
+
+    SECTION("matches a reference LCS on random input") {
+        std::mt19937 rng(42);
+        for (int iteration = 0; iteration < 5000; ++iteration) {
+            std::vector<size_t> prev, next;
+            random_edit(rng, 1000, false, prev, next);
+
+            size_t modified_row = prev.empty() ? 0 : prev[rng() % prev.size()];
+            auto modified = [&](size_t row) { return row == modified_row || row % 5 == 0; };
+
+            CAPTURE(iteration);
+            c = CollectionChangeBuilder::calculate(prev, next, modified);
+            REQUIRE(apply(prev, c, next) == next);
+            REQUIRE(kept_score(next, c, modified) == reference_score(prev, next, modified));
+        }
+    }
+
+    SECTION("produces a valid diff for random input with duplicate rows") {
+        // Duplicates are paired up by row index before the LCS is computed, so
+        // the result isn't always the longest possible and only its validity
+        // is checked
+        std::mt19937 rng(43);
+        for (int iteration = 0; iteration < 5000; ++iteration) {
+            std::vector<size_t> prev, next;
+            random_edit(rng, 8, true, prev, next);
+
+            CAPTURE(iteration);
+            c = CollectionChangeBuilder::calculate(prev, next, [](size_t row) { return row == 3; });
+            REQUIRE(apply(prev, c, next) == next);
+        }
+    }
+
+    SECTION("handles large permutations without recursing") {
+        const size_t size = 100000;
+        std::mt19937 rng(7);
+        std::vector<size_t> prev(size);
+        std::iota(prev.begin(), prev.end(), 0);
+
+        std::vector<size_t> next = prev;
+        for (size_t i = 0; i < size / 20; ++i)
+            std::swap(next[rng() % size], next[rng() % size]);
+        c = CollectionChangeBuilder::calculate(prev, next, none_modified);
+        REQUIRE(apply(prev, c, next) == next);
+        REQUIRE(size - c.deletions.count() == longest_increasing(next));
+
+        next = prev;
+        std::reverse(next.begin(), next.end());
+        c = CollectionChangeBuilder::calculate(prev, next, none_modified);
+        REQUIRE(apply(prev, c, next) == next);
+        REQUIRE(c.deletions.count() == size - 1);
+    }
+}
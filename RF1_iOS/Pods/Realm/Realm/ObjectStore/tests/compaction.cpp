@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/group_shared.hpp>
+#include <realm/util/file.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace realm;
+
+TEST_CASE("Realm::compact_if_needed()") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+            {"data", PropertyType::String},
+        }},
+    };
+
+    // Leave most of the file free by adding a lot of data and then deleting
+    // all but the first few rows of it
+    {
+        auto r = Realm::get_shared_realm(config);
+        auto table = r->read_group().get_table("class_object");
+        r->begin_transaction();
+        table->add_empty_row(1000);
+        for (size_t i = 0; i < 1000; ++i) {
+            table->set_int(0, i, i);
+            std::string data(500, 'a' + i % 26);
+            table->set_string(1, i, data);
+        }
+        r->commit_transaction();
+        r->begin_transaction();
+        while (table->size() > 10)
+            table->move_last_over(table->size() - 1);
+        r->commit_transaction();
+    }
+    auto size_before = util::File(config.path).get_size();
+
+    SECTION("compacts a closed file past the thresholds") {
+        config.compaction_free_ratio = 0.5;
+        REQUIRE(Realm::compact_if_needed(config) == Realm::CompactionResult::Compacted);
+        REQUIRE(util::File(config.path).get_size() < size_before);
+
+        auto r = Realm::get_shared_realm(config);
+        auto table = r->read_group().get_table("class_object");
+        REQUIRE(table->size() == 10);
+        for (size_t i = 0; i < 10; ++i) {
+            REQUIRE(table->get_int(0, i) == int64_t(i));
+            REQUIRE(std::string(table->get_string(1, i)) == std::string(500, 'a' + i % 26));
+        }
+    }
+
+    SECTION("leaves a file below the minimum size alone") {
+        config.compaction_min_size = size_before * 2;
+        REQUIRE(Realm::compact_if_needed(config) == Realm::CompactionResult::NotNeeded);
+        REQUIRE(util::File(config.path).get_size() == size_before);
+    }
+
+    SECTION("leaves a file with too little free space alone") {
+        config.compaction_free_ratio = 0.5;
+        REQUIRE(Realm::compact_if_needed(config) == Realm::CompactionResult::Compacted);
+        auto size_after = util::File(config.path).get_size();
+        REQUIRE(Realm::compact_if_needed(config) == Realm::CompactionResult::NotNeeded);
+        REQUIRE(util::File(config.path).get_size() == size_after);
+    }
+
+    SECTION("doesn't wait for an open file to be closed") {
+        auto r = Realm::get_shared_realm(config);
+        r->read_group();
+        REQUIRE(Realm::compact_if_needed(config) == Realm::CompactionResult::FileInUse);
+        REQUIRE(util::File(config.path).get_size() == size_before);
+    }
+
+    SECTION("isn't run by closing the Realm") {
+        config.compaction_free_ratio = 0.5;
+        Realm::get_shared_realm(config)->read_group();
+        REQUIRE(util::File(config.path).get_size() == size_before);
+    }
+
+    SECTION("doesn't create a missing file") {
+        util::File::remove(config.path);
+        REQUIRE(Realm::compact_if_needed(config) == Realm::CompactionResult::NotNeeded);
+        REQUIRE_FALSE(util::File::exists(config.path));
+    }
+
+    SECTION("rejects an invalid ratio") {
+        config.compaction_free_ratio = 1;
+        REQUIRE_THROWS(Realm::compact_if_needed(config));
+    }
+
+    SECTION("rejects in-memory Realms") {
+        config.in_memory = true;
+        REQUIRE_THROWS(Realm::compact_if_needed(config));
+    }
+}
+
+TEST_CASE("Config::background_compaction") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+            {"data", PropertyType::String},
+        }},
+    };
+    config.background_compaction = true;
+    config.compaction_free_ratio = 0.5;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Realm::BackgroundCompactionEvent> events;
+    config.background_compaction_function = [&](auto& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(event);
+        cv.notify_all();
+    };
+    using Kind = Realm::BackgroundCompactionEvent::Kind;
+    auto wait_for_result = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool done = cv.wait_for(lock, std::chrono::seconds(10), [&] {
+            return !events.empty() && events.back().kind != Kind::Started;
+        });
+        REQUIRE(done);
+        return events;
+    };
+    auto event_count = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return events.size();
+    };
+
+    // Leaves most of the file free, as in the compact_if_needed() tests
+    auto fill_and_delete = [](Realm& r) {
+        auto table = r.read_group().get_table("class_object");
+        r.begin_transaction();
+        table->add_empty_row(1000);
+        for (size_t i = 0; i < 1000; ++i) {
+            table->set_int(0, i, i);
+            std::string data(500, 'a' + i % 26);
+            table->set_string(1, i, data);
+        }
+        r.commit_transaction();
+        r.begin_transaction();
+        while (table->size() > 10)
+            table->move_last_over(table->size() - 1);
+        r.commit_transaction();
+    };
+
+    SECTION("compacts the file once the last Realm is closed") {
+        auto r = Realm::get_shared_realm(config);
+        fill_and_delete(*r);
+        auto size_before = util::File(config.path).get_size();
+        REQUIRE(event_count() == 0);
+
+        r->close();
+        auto result = wait_for_result();
+        REQUIRE(result.size() == 2);
+        REQUIRE(result[0].kind == Kind::Started);
+        REQUIRE(result[0].path == config.path);
+        REQUIRE(result[0].file_size == uint64_t(size_before));
+        REQUIRE(result[1].kind == Kind::Finished);
+        REQUIRE(result[1].bytes_reclaimed > 0);
+        REQUIRE(result[1].file_size == size_before - result[1].bytes_reclaimed);
+        REQUIRE(uint64_t(util::File(config.path).get_size()) == result[1].file_size);
+
+        r = Realm::get_shared_realm(config);
+        auto table = r->read_group().get_table("class_object");
+        REQUIRE(table->size() == 10);
+        for (size_t i = 0; i < 10; ++i) {
+            REQUIRE(table->get_int(0, i) == int64_t(i));
+            REQUIRE(std::string(table->get_string(1, i)) == std::string(500, 'a' + i % 26));
+        }
+    }
+
+    SECTION("waits for every Realm instance to be closed") {
+        auto r = Realm::get_shared_realm(config);
+        fill_and_delete(*r);
+        auto size_before = util::File(config.path).get_size();
+
+        // A second instance on another thread keeps the file open
+        SharedRealm r2;
+        std::thread([&] { r2 = Realm::get_shared_realm(config); r2->read_group(); }).join();
+        r->close();
+        REQUIRE(event_count() == 0);
+        REQUIRE(util::File(config.path).get_size() == size_before);
+
+        r2 = nullptr;
+        auto result = wait_for_result();
+        REQUIRE(result.back().kind == Kind::Finished);
+        REQUIRE(util::File(config.path).get_size() < size_before);
+    }
+
+    SECTION("isn't held up by notifiers which have been removed") {
+        auto r = Realm::get_shared_realm(config);
+        fill_and_delete(*r);
+        auto size_before = util::File(config.path).get_size();
+
+        // The notifier thread hasn't cleaned up the removed notifier yet
+        {
+            Results results(r, *r->read_group().get_table("class_object"));
+            auto token = results.add_notification_callback([](CollectionChangeSet, std::exception_ptr) {});
+            advance_and_notify(*r);
+        }
+        r->close();
+        auto result = wait_for_result();
+        REQUIRE(result.back().kind == Kind::Finished);
+        REQUIRE(util::File(config.path).get_size() < size_before);
+    }
+
+    SECTION("isn't requested below the thresholds") {
+        config.compaction_min_size = uint64_t(1) << 40;
+        auto r = Realm::get_shared_realm(config);
+        fill_and_delete(*r);
+        auto size_before = util::File(config.path).get_size();
+        r->close();
+        REQUIRE(event_count() == 0);
+        REQUIRE(util::File(config.path).get_size() == size_before);
+    }
+
+    SECTION("is skipped if the file was opened elsewhere before it could run") {
+        auto r = Realm::get_shared_realm(config);
+        fill_and_delete(*r);
+
+        // Not through a Realm instance, so the coordinator doesn't know about it
+        std::unique_ptr<Replication> history;
+        std::unique_ptr<SharedGroup> sg;
+        std::unique_ptr<Group> read_only_group;
+        Realm::open_with_config(config, history, sg, read_only_group, nullptr);
+        r->close();
+        auto result = wait_for_result();
+        REQUIRE(result.back().kind == Kind::Skipped);
+    }
+
+    SECTION("rejects in-memory Realms") {
+        config.in_memory = true;
+        REQUIRE_THROWS(Realm::get_shared_realm(config));
+    }
+
+    SECTION("rejects an invalid ratio") {
+        config.compaction_free_ratio = 1;
+        REQUIRE_THROWS(Realm::get_shared_realm(config));
+    }
+}
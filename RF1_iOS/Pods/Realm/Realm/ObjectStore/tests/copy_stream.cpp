@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+#include "util/copy_stream.hpp"
+
+#include <realm/group.hpp>
+#include <realm/util/file.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace realm;
+
+namespace {
+// Collects a streamed copy, keeping track of the largest write made to the sink
+struct CopyCollector {
+    std::string data;
+    size_t largest_write = 0;
+
+    util::CopySink sink()
+    {
+        return [this](BinaryData chunk) {
+            data.append(chunk.data(), chunk.size());
+            largest_write = std::max(largest_write, chunk.size());
+        };
+    }
+};
+
+// Serves `data` in reads of at most `read_size` bytes, so that reads don't
+// line up with the chunks the copy was written in
+util::CopySource source_for(std::string const& data, size_t read_size = 1000)
+{
+    auto position = std::make_shared<size_t>(0);
+    return [=, &data](char* buffer, size_t size) {
+        size_t n = std::min({size, read_size, data.size() - *position});
+        memcpy(buffer, data.data() + *position, n);
+        *position += n;
+        return n;
+    };
+}
+}
+
+TEST_CASE("Realm::write_copy() to a sink") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+            {"data", PropertyType::String},
+        }},
+    };
+    const size_t row_count = 1000;
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_object");
+    r->begin_transaction();
+    table->add_empty_row(row_count);
+    for (size_t i = 0; i < row_count; ++i) {
+        table->set_int(0, i, i);
+        std::string data(100, 'a' + i % 26);
+        table->set_string(1, i, data);
+    }
+    r->commit_transaction();
+
+    const size_t chunk_size = 4096;
+    std::string copy_path = config.path + ".copy";
+    Realm::Config copy_config;
+    copy_config.path = copy_path;
+    copy_config.schema_version = 0;
+
+    auto verify_copy = [&] {
+        auto copy = Realm::get_shared_realm(copy_config);
+        auto copy_table = copy->read_group().get_table("class_object");
+        REQUIRE(copy_table);
+        REQUIRE(copy_table->size() == row_count);
+        for (size_t i = 0; i < row_count; ++i) {
+            REQUIRE(copy_table->get_int(0, i) == int64_t(i));
+            REQUIRE(std::string(copy_table->get_string(1, i)) == std::string(100, 'a' + i % 26));
+        }
+    };
+
+    SECTION("uncompressed copy is a plain Realm file") {
+        CopyCollector collector;
+        r->write_copy(collector.sink(), false, chunk_size);
+        REQUIRE(collector.largest_write <= chunk_size);
+        REQUIRE(collector.largest_write > 0);
+
+        Realm::import_copy(source_for(collector.data), copy_path);
+        REQUIRE(uint64_t(util::File(copy_path).get_size()) == collector.data.size());
+        verify_copy();
+    }
+
+    SECTION("compressed copy round-trips through import_copy()") {
+        CopyCollector collector;
+        r->write_copy(collector.sink(), true, chunk_size);
+        REQUIRE(collector.largest_write <= chunk_size);
+
+        CopyCollector uncompressed;
+        r->write_copy(uncompressed.sink(), false, chunk_size);
+        REQUIRE(collector.data.size() < uncompressed.data.size());
+
+        Realm::import_copy(source_for(collector.data), copy_path);
+        verify_copy();
+    }
+
+    SECTION("chunks smaller than the copy stream headers") {
+        CopyCollector collector;
+        r->write_copy(collector.sink(), false, 1);
+        REQUIRE(collector.largest_write == 1);
+        Realm::import_copy(source_for(collector.data), copy_path);
+        verify_copy();
+    }
+
+    SECTION("rejects a zero chunk size") {
+        REQUIRE_THROWS_AS(r->write_copy([](BinaryData) {}, true, 0), std::invalid_argument);
+    }
+
+    SECTION("passes on errors from the sink") {
+        size_t writes = 0;
+        auto sink = [&](BinaryData) {
+            if (++writes == 3)
+                throw std::runtime_error("sink failed");
+        };
+        REQUIRE_THROWS_WITH(r->write_copy(sink, true, chunk_size), "sink failed");
+    }
+
+    SECTION("import_copy()") {
+        CopyCollector collector;
+        r->write_copy(collector.sink(), true, chunk_size);
+        auto& data = collector.data;
+
+        SECTION("rejects a truncated stream and removes the partial file") {
+            // Cut off partway through the frames, in the final frame's header,
+            // and right after the stream header
+            for (size_t size : {data.size() / 2, data.size() - 4, size_t(12)}) {
+                std::string truncated = data.substr(0, size);
+                REQUIRE_THROWS_AS(Realm::import_copy(source_for(truncated), copy_path), std::runtime_error);
+                REQUIRE_FALSE(util::File::exists(copy_path));
+            }
+        }
+
+        SECTION("rejects a frame larger than the chunk size") {
+            // The uncompressed size of the first frame, which follows the
+            // 12-byte stream header
+            data[12 + 3] = char(0x7F);
+            REQUIRE_THROWS_AS(Realm::import_copy(source_for(data), copy_path), std::runtime_error);
+            REQUIRE_FALSE(util::File::exists(copy_path));
+        }
+
+        SECTION("rejects corrupted compressed data") {
+            // Fill the middle of the first frame's compressed data with garbage
+            auto load_u32 = [&](size_t offset) {
+                size_t value = 0;
+                for (int i = 0; i < 4; ++i)
+                    value |= size_t(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+                return value;
+            };
+            size_t stored_size = load_u32(12 + 4);
+            REQUIRE(stored_size < load_u32(12));
+            REQUIRE(stored_size > 16);
+            std::fill(data.begin() + 20 + 4, data.begin() + 20 + stored_size - 4, char(0xAB));
+            REQUIRE_THROWS(Realm::import_copy(source_for(data), copy_path));
+            REQUIRE_FALSE(util::File::exists(copy_path));
+        }
+
+        SECTION("rejects an unknown format version") {
+            data[4] = char(2);
+            REQUIRE_THROWS_AS(Realm::import_copy(source_for(data), copy_path), std::runtime_error);
+            REQUIRE_FALSE(util::File::exists(copy_path));
+        }
+
+        SECTION("won't overwrite an existing file") {
+            util::File(copy_path, util::File::mode_Write);
+            REQUIRE_THROWS(Realm::import_copy(source_for(data), copy_path));
+            REQUIRE(util::File(copy_path).get_size() == 0);
+        }
+    }
+}
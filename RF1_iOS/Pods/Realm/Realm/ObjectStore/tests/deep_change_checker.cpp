@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+#include "util/test_file.hpp"
+
+#include "impl/collection_notifier.hpp"
+#include "impl/realm_coordinator.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/link_view.hpp>
+
+#include <vector>
+
+using namespace realm;
+using RelatedTables = _impl::DeepChangeChecker::RelatedTables;
+
+TEST_CASE("DeepChangeChecker") {
+    InMemoryTestFile config;
+    config.schema = Schema{
+        {"a", {
+            {"value", PropertyType::Int},
+            {"link", PropertyType::Object|PropertyType::Nullable, "b"},
+            {"list", PropertyType::Array|PropertyType::Object, "b"},
+        }},
+        {"b", {
+            {"value", PropertyType::Int},
+            {"link", PropertyType::Object|PropertyType::Nullable, "c"},
+        }},
+        {"c", {
+            {"value", PropertyType::Int},
+            {"link", PropertyType::Object|PropertyType::Nullable, "a"},
+        }},
+        {"d", {
+            {"value", PropertyType::Int},
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto& group = r->read_group();
+    auto a = group.get_table("class_a");
+    auto b = group.get_table("class_b");
+    auto c = group.get_table("class_c");
+    auto d = group.get_table("class_d");
+
+    SECTION("RelatedTables::make() finds each reachable table once") {
+        auto related = RelatedTables::make(*a);
+        REQUIRE(related->tables.size() == 3);
+        REQUIRE(related->tables[0].table_ndx == a->get_index_in_group());
+
+        auto related_a = related->find(a->get_index_in_group());
+        REQUIRE(related_a);
+        REQUIRE(related_a->links.size() == 2);
+        REQUIRE(related_a->links[0].col_ndx == a->get_column_index("link"));
+        REQUIRE_FALSE(related_a->links[0].is_list);
+        REQUIRE(related_a->links[1].col_ndx == a->get_column_index("list"));
+        REQUIRE(related_a->links[1].is_list);
+
+        auto related_b = related->find(b->get_index_in_group());
+        REQUIRE(related_b);
+        REQUIRE(related_b->table_ndx == b->get_index_in_group());
+        REQUIRE(related_b->links.size() == 1);
+        REQUIRE(related_b->links[0].col_ndx == b->get_column_index("link"));
+
+        auto related_c = related->find(c->get_index_in_group());
+        REQUIRE(related_c);
+        REQUIRE(related_c->table_ndx == c->get_index_in_group());
+
+        REQUIRE_FALSE(related->find(d->get_index_in_group()));
+        REQUIRE_FALSE(related->find(group.size() + 10));
+        REQUIRE(RelatedTables::make(*d)->tables.size() == 1);
+    }
+
+    SECTION("the coordinator shares one graph per table until the schema changes") {
+        // update_schema() clears the coordinator's schema cache, and opening
+        // another Realm without a schema reads it from the file and caches it
+        Realm::Config dynamic_config = config;
+        dynamic_config.cache = false;
+        dynamic_config.schema = util::none;
+        auto r2 = Realm::get_shared_realm(dynamic_config);
+
+        auto coordinator = _impl::RealmCoordinator::get_existing_coordinator(config.path);
+        auto version = TestHelper::get_shared_group(r).get_version_of_current_transaction().version;
+
+        auto related = coordinator->get_related_tables(*a, version);
+        REQUIRE(related == coordinator->get_related_tables(*a, version));
+        REQUIRE(related != coordinator->get_related_tables(*b, version));
+        REQUIRE(related->tables.size() == 3);
+
+        auto schema = std::vector<ObjectSchema>(config.schema->begin(), config.schema->end());
+        schema.push_back({"e", {{"value", PropertyType::Int}}});
+        schema[2].persisted_properties.push_back({"e", PropertyType::Object|PropertyType::Nullable, "e"});
+        r->update_schema(Schema(std::move(schema)), 1);
+        r2->refresh();
+
+        auto new_version = TestHelper::get_shared_group(r).get_version_of_current_transaction().version;
+        REQUIRE(new_version > version);
+        auto new_related = coordinator->get_related_tables(*a, new_version);
+        REQUIRE(new_related != related);
+        REQUIRE(new_related->tables.size() == 4);
+        REQUIRE(new_related == coordinator->get_related_tables(*a, new_version));
+
+        // Graphs which were already handed out are never modified
+        REQUIRE(related->tables.size() == 3);
+
+        // and versions the cached schema isn't known to be valid for aren't cached
+        REQUIRE(coordinator->get_related_tables(*a, version) != coordinator->get_related_tables(*a, version));
+    }
+
+    SECTION("modifications are found through links, lists and cycles") {
+        // a0 -> b0 -> c0 -> a2, a1 -> [b1, b0], a2 has no links, and a3-a9
+        // all link to b1 -> c1, which is never modified
+        r->begin_transaction();
+        a->add_empty_row(10);
+        b->add_empty_row(2);
+        c->add_empty_row(2);
+        d->add_empty_row(1);
+        size_t a_link = a->get_column_index("link"), a_list = a->get_column_index("list");
+        size_t b_link = b->get_column_index("link"), c_link = c->get_column_index("link");
+        a->set_link(a_link, 0, 0);
+        a->get_linklist(a_list, 1)->add(1);
+        a->get_linklist(a_list, 1)->add(0);
+        for (size_t i = 3; i < 10; ++i)
+            a->set_link(a_link, i, 1);
+        b->set_link(b_link, 0, 0);
+        b->set_link(b_link, 1, 1);
+        c->set_link(c_link, 0, 2);
+        r->commit_transaction();
+
+        Results results(r, *a);
+        CollectionChangeSet change;
+        size_t calls = 0;
+        auto token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            change = std::move(c);
+            ++calls;
+        });
+        advance_and_notify(*r);
+        REQUIRE(calls == 1);
+
+        auto write = [&](auto&& f) {
+            r->begin_transaction();
+            f();
+            r->commit_transaction();
+            advance_and_notify(*r);
+        };
+
+        write([&] { c->set_int(0, 0, 1); });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.modifications, 0, 1);
+
+        write([&] { c->set_int(0, 1, 1); });
+        REQUIRE(calls == 3);
+        REQUIRE_INDICES(change.modifications, 1, 3, 4, 5, 6, 7, 8, 9);
+
+        write([&] { d->set_int(0, 0, 1); });
+        REQUIRE(calls == 3);
+
+        // a2 is reached from a0 and a1 through the c -> a link
+        write([&] { a->set_int(0, 2, 1); });
+        REQUIRE(calls == 4);
+        REQUIRE_INDICES(change.modifications, 0, 1, 2);
+    }
+}
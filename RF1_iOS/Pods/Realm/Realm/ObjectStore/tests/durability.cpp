@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+using namespace realm;
+
+TEST_CASE("durability") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int}
+        }},
+    };
+
+    SECTION("in-memory realms can't use async durability") {
+        config.in_memory = true;
+        config.durability = Durability::Async;
+        REQUIRE_THROWS_WITH(Realm::get_shared_realm(config), "In-memory realms cannot use async durability");
+    }
+
+#ifndef REALM_ASYNC_DAEMON
+    SECTION("async durability is rejected without the async commit daemon") {
+        config.durability = Durability::Async;
+        REQUIRE_THROWS_WITH(Realm::get_shared_realm(config), "Async durability is not supported on this platform");
+    }
+#endif
+
+    SECTION("in_memory is the same as MemOnly durability") {
+        config.in_memory = true;
+        auto r = Realm::get_shared_realm(config);
+
+        Realm::Config config2 = config;
+        config2.cache = false;
+        config2.in_memory = false;
+        config2.durability = Durability::MemOnly;
+        REQUIRE_NOTHROW(Realm::get_shared_realm(config2));
+    }
+
+    SECTION("a second instance with different durability is rejected") {
+        auto r = Realm::get_shared_realm(config);
+
+        Realm::Config config2 = config;
+        config2.cache = false;
+        config2.durability = Durability::MemOnly;
+        REQUIRE_THROWS_AS(Realm::get_shared_realm(config2), MismatchedConfigException);
+
+        config2.durability = Durability::Full;
+        config2.in_memory = true;
+        REQUIRE_THROWS_AS(Realm::get_shared_realm(config2), MismatchedConfigException);
+
+#ifdef REALM_ASYNC_DAEMON
+        config2.in_memory = false;
+        config2.durability = Durability::Async;
+        REQUIRE_THROWS_WITH(Realm::get_shared_realm(config2),
+                            Catch::Contains("already opened with different durability settings"));
+#endif
+    }
+
+    SECTION("commits are readable with each durability") {
+        auto durability = GENERATE(Durability::Full, Durability::MemOnly);
+        config.durability = durability;
+        {
+            auto r = Realm::get_shared_realm(config);
+            auto table = r->read_group().get_table("class_object");
+            r->begin_transaction();
+            table->set_int(0, table->add_empty_row(), 5);
+            r->commit_transaction();
+
+            Realm::Config config2 = config;
+            config2.cache = false;
+            auto r2 = Realm::get_shared_realm(config2);
+            auto table2 = r2->read_group().get_table("class_object");
+            REQUIRE(table2->size() == 1);
+            REQUIRE(table2->get_int(0, 0) == 5);
+        }
+    }
+}
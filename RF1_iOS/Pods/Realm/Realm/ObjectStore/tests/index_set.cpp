@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace realm;
+
+namespace {
+std::vector<size_t> to_vector(IndexSet const& is)
+{
+    is.verify();
+    std::vector<size_t> ret;
+    for (auto index : is.as_indexes())
+        ret.push_back(index);
+    return ret;
+}
+
+std::vector<size_t> to_vector(std::set<size_t> const& s)
+{
+    return {s.begin(), s.end()};
+}
+
+// std::set versions of the IndexSet operations, one index at a time
+size_t reference_shift(std::set<size_t> const& s, size_t index)
+{
+    for (auto value : s) {
+        if (value > index)
+            break;
+        ++index;
+    }
+    return index;
+}
+
+size_t reference_count(std::set<size_t> const& s, size_t start, size_t end)
+{
+    if (start >= end)
+        return 0;
+    return std::distance(s.lower_bound(start), s.lower_bound(end));
+}
+
+void reference_shift_for_insert_at(std::set<size_t>& s, size_t index, size_t count)
+{
+    std::set<size_t> ret;
+    for (auto value : s)
+        ret.insert(value >= index ? value + count : value);
+    s = std::move(ret);
+}
+
+void reference_erase_at(std::set<size_t>& s, size_t index)
+{
+    std::set<size_t> ret;
+    for (auto value : s) {
+        if (value != index)
+            ret.insert(value > index ? value - 1 : value);
+    }
+    s = std::move(ret);
+}
+
+// A random set of `size` indices below `range`, as both an IndexSet built by
+// adding them one at a time and a std::set
+struct RandomSet {
+    IndexSet is;
+    std::set<size_t> reference;
+
+    RandomSet(std::mt19937& rng, size_t range, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i) {
+            size_t index = rng() % range;
+            is.add(index);
+            reference.insert(index);
+        }
+    }
+};
+} // anonymous namespace
+
+TEST_CASE("index_set: contains()") {
+    SECTION("returns false if the index is before the first entry") {
+        IndexSet set = {1, 2, 5};
+        REQUIRE_FALSE(set.contains(0));
+    }
+
+    SECTION("returns true if the index is in the set") {
+        IndexSet set = {1, 2, 5};
+        REQUIRE(set.contains(1));
+        REQUIRE(set.contains(2));
+        REQUIRE(set.contains(5));
+    }
+
+    SECTION("returns false for indices between ranges and after the last entry") {
+        IndexSet set = {1, 2, 5};
+        REQUIRE_FALSE(set.contains(3));
+        REQUIRE_FALSE(set.contains(4));
+        REQUIRE_FALSE(set.contains(6));
+    }
+}
+
+TEST_CASE("index_set: count()") {
+    SECTION("returns the number of indices in the whole set by default") {
+        IndexSet set = {1, 2, 3, 5, 8, 9};
+        REQUIRE(set.count() == 6);
+    }
+
+    SECTION("counts only indices in the given range") {
+        IndexSet set = {1, 2, 3, 5, 8, 9};
+        REQUIRE(set.count(0, 2) == 1);
+        REQUIRE(set.count(2, 6) == 3);
+        REQUIRE(set.count(4, 8) == 1);
+        REQUIRE(set.count(6, 8) == 0);
+        REQUIRE(set.count(9, 100) == 1);
+    }
+
+    SECTION("counts a range which crosses the end index at the start of a later chunk") {
+        // Enough separate ranges to need several chunks, so that some range
+        // starting a chunk crosses every end index tested
+        IndexSet set;
+        std::set<size_t> reference;
+        for (size_t i = 0; i < 2000; ++i) {
+            set.add(i * 4);
+            set.add(i * 4 + 1);
+            reference.insert(i * 4);
+            reference.insert(i * 4 + 1);
+        }
+        for (size_t start = 0; start < 8000; start += 97) {
+            for (size_t end = start; end < 8000; end += 251)
+                REQUIRE(set.count(start, end) == reference_count(reference, start, end));
+        }
+    }
+}
+
+TEST_CASE("index_set: add()") {
+    SECTION("extends and merges existing ranges") {
+        IndexSet set = {1, 3};
+        set.add(2);
+        REQUIRE_INDICES(set, 1, 2, 3);
+        set.add(0);
+        set.add(4);
+        REQUIRE_INDICES(set, 0, 1, 2, 3, 4);
+    }
+
+    SECTION("adds another set into an empty set") {
+        IndexSet set;
+        set.add(IndexSet{1, 2, 5});
+        REQUIRE_INDICES(set, 1, 2, 5);
+    }
+
+    SECTION("merges another set with overlapping and adjacent ranges") {
+        IndexSet set = {1, 2, 5, 6, 10};
+        set.add(IndexSet{0, 3, 6, 7, 8, 12});
+        REQUIRE_INDICES(set, 0, 1, 2, 3, 5, 6, 7, 8, 10, 12);
+    }
+
+    SECTION("adds a small set to a large one") {
+        IndexSet set;
+        for (size_t i = 0; i < 1000; ++i)
+            set.add(i * 2);
+        set.add(IndexSet{1, 1999, 5000});
+        REQUIRE(set.count() == 1003);
+        REQUIRE(set.contains(0));
+        REQUIRE(set.contains(1));
+        REQUIRE(set.contains(2));
+        REQUIRE(set.contains(1999));
+        REQUIRE(set.contains(5000));
+    }
+}
+
+TEST_CASE("index_set: add_shifted()") {
+    SECTION("shifts the index past the ranges before it") {
+        IndexSet set = {1, 2};
+        REQUIRE(set.add_shifted(0) == 0);
+        REQUIRE(set.add_shifted(1) == 4);
+        REQUIRE_INDICES(set, 0, 1, 2, 4);
+    }
+}
+
+TEST_CASE("index_set: shift() and unshift()") {
+    IndexSet set = {1, 3, 4};
+
+    SECTION("shift() steps over every index in the set at or before the result") {
+        REQUIRE(set.shift(0) == 0);
+        REQUIRE(set.shift(1) == 2);
+        REQUIRE(set.shift(2) == 5);
+        REQUIRE(set.shift(3) == 6);
+    }
+
+    SECTION("unshift() subtracts the indices before it") {
+        REQUIRE(set.unshift(0) == 0);
+        REQUIRE(set.unshift(2) == 1);
+        REQUIRE(set.unshift(5) == 2);
+        REQUIRE(set.unshift(6) == 3);
+    }
+}
+
+TEST_CASE("index_set: insert_at(), shift_for_insert_at() and erase_at()") {
+    SECTION("insert_at() adds the index and shifts the ones after it") {
+        IndexSet set = {1, 3, 4};
+        set.insert_at(3);
+        REQUIRE_INDICES(set, 1, 3, 4, 5);
+        set.insert_at(0, 2);
+        REQUIRE_INDICES(set, 0, 1, 3, 5, 6, 7);
+    }
+
+    SECTION("shift_for_insert_at() shifts without adding") {
+        IndexSet set = {1, 3, 4};
+        set.shift_for_insert_at(3, 2);
+        REQUIRE_INDICES(set, 1, 5, 6);
+    }
+
+    SECTION("erase_at() removes the index and shifts the ones after it") {
+        IndexSet set = {1, 3, 4, 6};
+        set.erase_at(3);
+        REQUIRE_INDICES(set, 1, 3, 5);
+        set.erase_at(0);
+        REQUIRE_INDICES(set, 0, 2, 4);
+    }
+
+    SECTION("erase_or_unshift() returns npos for indices in the set") {
+        IndexSet set = {1, 3, 4};
+        REQUIRE(set.erase_or_unshift(3) == IndexSet::npos);
+        REQUIRE_INDICES(set, 1, 3);
+        REQUIRE(set.erase_or_unshift(2) == 1);
+        REQUIRE_INDICES(set, 1, 2);
+    }
+}
+
+TEST_CASE("index_set: matches std::set on random operations") {
+    std::mt19937 rng(1234);
+
+    // Small sets, and sets with enough separate ranges to need several chunks
+    const size_t ranges[] = {40, 20000};
+
+    SECTION("queries") {
+        for (size_t range : ranges) {
+            CAPTURE(range);
+            for (int iteration = 0; iteration < 200; ++iteration) {
+                RandomSet set(rng, range, rng() % (range / 4));
+                REQUIRE(to_vector(set.is) == to_vector(set.reference));
+                for (int i = 0; i < 200; ++i) {
+                    size_t index = rng() % (range + 10);
+                    size_t end = index + rng() % range;
+                    CAPTURE(index);
+                    CAPTURE(end);
+                    REQUIRE(set.is.contains(index) == (set.reference.count(index) == 1));
+                    REQUIRE(set.is.count(index, end) == reference_count(set.reference, index, end));
+                    REQUIRE(set.is.shift(index) == reference_shift(set.reference, index));
+                    if (!set.reference.count(index))
+                        REQUIRE(set.is.unshift(index) == index - reference_count(set.reference, 0, index));
+                }
+            }
+        }
+    }
+
+    SECTION("add() of another set") {
+        for (size_t range : ranges) {
+            CAPTURE(range);
+            for (int iteration = 0; iteration < 200; ++iteration) {
+                // Alternate between small sets, which are added an index at a
+                // time, and large ones, which are merged
+                RandomSet a(rng, range, rng() % (range / 4));
+                RandomSet b(rng, range, rng() % (iteration % 2 ? range / 4 : 5));
+                a.is.add(b.is);
+                a.reference.insert(b.reference.begin(), b.reference.end());
+                REQUIRE(to_vector(a.is) == to_vector(a.reference));
+            }
+        }
+    }
+
+    SECTION("remove() of another set") {
+        for (size_t range : ranges) {
+            CAPTURE(range);
+            for (int iteration = 0; iteration < 200; ++iteration) {
+                RandomSet a(rng, range, rng() % (range / 4));
+                RandomSet b(rng, range, rng() % (range / 4));
+                a.is.remove(b.is);
+                for (auto index : b.reference)
+                    a.reference.erase(index);
+                REQUIRE(to_vector(a.is) == to_vector(a.reference));
+            }
+        }
+    }
+
+    SECTION("mutations") {
+        for (size_t range : ranges) {
+            CAPTURE(range);
+            for (int iteration = 0; iteration < 100; ++iteration) {
+                RandomSet set(rng, range, rng() % (range / 4));
+                for (int i = 0; i < 50; ++i) {
+                    size_t index = rng() % (range + 10);
+                    size_t count = 1 + rng() % 5;
+                    int op = rng() % 7;
+                    CAPTURE(op);
+                    CAPTURE(index);
+                    CAPTURE(count);
+                    switch (op) {
+                        case 0:
+                            set.is.add(index);
+                            set.reference.insert(index);
+                            break;
+                        case 1: {
+                            size_t shifted = reference_shift(set.reference, index);
+                            REQUIRE(set.is.add_shifted(index) == shifted);
+                            set.reference.insert(shifted);
+                            break;
+                        }
+                        case 2:
+                            set.is.remove(index, count);
+                            for (size_t j = 0; j < count; ++j)
+                                set.reference.erase(index + j);
+                            break;
+                        case 3:
+                            set.is.insert_at(index, count);
+                            reference_shift_for_insert_at(set.reference, index, count);
+                            for (size_t j = 0; j < count; ++j)
+                                set.reference.insert(index + j);
+                            break;
+                        case 4:
+                            set.is.shift_for_insert_at(index, count);
+                            reference_shift_for_insert_at(set.reference, index, count);
+                            break;
+                        case 5:
+                            set.is.erase_at(index);
+                            reference_erase_at(set.reference, index);
+                            break;
+                        case 6: {
+                            size_t expected = set.reference.count(index) ? IndexSet::npos
+                                            : index - reference_count(set.reference, 0, index);
+                            REQUIRE(set.is.erase_or_unshift(index) == expected);
+                            reference_erase_at(set.reference, index);
+                            break;
+                        }
+                    }
+                    REQUIRE(to_vector(set.is) == to_vector(set.reference));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+#include "util/test_file.hpp"
+
+#include "list.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/link_view.hpp>
+
+using namespace realm;
+
+TEST_CASE("key path filtering") {
+    InMemoryTestFile config;
+    config.schema = Schema{
+        {"a", {
+            {"value", PropertyType::Int},
+            {"other", PropertyType::Int},
+            {"link", PropertyType::Object|PropertyType::Nullable, "b"},
+            {"list", PropertyType::Array|PropertyType::Object, "b"},
+        }},
+        {"b", {
+            {"value", PropertyType::Int},
+            {"other", PropertyType::Int},
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto a = r->read_group().get_table("class_a");
+    auto b = r->read_group().get_table("class_b");
+    size_t a_ndx = a->get_index_in_group(), b_ndx = b->get_index_in_group();
+    size_t a_value = a->get_column_index("value"), a_other = a->get_column_index("other");
+    size_t a_link = a->get_column_index("link"), a_list = a->get_column_index("list");
+    size_t b_value = b->get_column_index("value"), b_other = b->get_column_index("other");
+
+    r->begin_transaction();
+    a->add_empty_row(2);
+    b->add_empty_row(2);
+    a->set_link(a_link, 0, 0);
+    a->get_linklist(a_list, 1)->add(1);
+    r->commit_transaction();
+
+    Results results(r, *a);
+    auto noop = [](CollectionChangeSet, std::exception_ptr) { };
+
+    SECTION("invalid key paths are rejected when the callback is added") {
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, KeyPathArray{KeyPath{}}), InvalidKeyPathException);
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, {{{b_ndx, b_value}}}), InvalidKeyPathException);
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, {{{a_ndx, 100}}}), InvalidKeyPathException);
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, {{{a_ndx, a_value}, {b_ndx, b_value}}}),
+                          InvalidKeyPathException);
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, {{{a_ndx, a_link}, {a_ndx, a_value}}}),
+                          InvalidKeyPathException);
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, {{{a_ndx, a_link}, {b_ndx, 100}}}),
+                          InvalidKeyPathException);
+
+        // One bad path rejects the whole set
+        REQUIRE_THROWS_AS(results.add_notification_callback(noop, {{{a_ndx, a_value}}, {{b_ndx, b_value}}}),
+                          InvalidKeyPathException);
+
+        List list(r, *a, a_list, 1);
+        REQUIRE_THROWS_AS(list.add_notification_callback(noop, {{{a_ndx, a_value}}}), InvalidKeyPathException);
+    }
+
+    SECTION("valid key paths are accepted") {
+        REQUIRE_NOTHROW(results.add_notification_callback(noop, {{{a_ndx, a_value}}}));
+        REQUIRE_NOTHROW(results.add_notification_callback(noop, {{{a_ndx, a_link}, {b_ndx, b_value}}}));
+        REQUIRE_NOTHROW(results.add_notification_callback(noop, {{{a_ndx, a_list}, {b_ndx, b_value}}}));
+        REQUIRE_NOTHROW(results.add_notification_callback(noop, {{{a_ndx, a_link}}}));
+
+        List list(r, *a, a_list, 1);
+        REQUIRE_NOTHROW(list.add_notification_callback(noop, {{{b_ndx, b_value}}}));
+    }
+
+    SECTION("only the observed properties are checked for modifications") {
+        CollectionChangeSet change;
+        size_t calls = 0;
+        auto token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            change = std::move(c);
+            ++calls;
+        }, {{{a_ndx, a_value}}, {{a_ndx, a_link}, {b_ndx, b_value}}, {{a_ndx, a_list}, {b_ndx, b_value}}});
+        advance_and_notify(*r);
+        REQUIRE(calls == 1);
+
+        auto write = [&](auto&& f) {
+            r->begin_transaction();
+            f();
+            r->commit_transaction();
+            advance_and_notify(*r);
+        };
+
+        write([&] { a->set_int(a_other, 0, 1); });
+        REQUIRE(calls == 1);
+        write([&] { b->set_int(b_other, 0, 1); });
+        REQUIRE(calls == 1);
+
+        write([&] { a->set_int(a_value, 1, 1); });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.modifications, 1);
+
+        write([&] { b->set_int(b_value, 0, 1); });
+        REQUIRE(calls == 3);
+        REQUIRE_INDICES(change.modifications, 0);
+
+        write([&] { b->set_int(b_value, 1, 1); });
+        REQUIRE(calls == 4);
+        REQUIRE_INDICES(change.modifications, 1);
+    }
+}
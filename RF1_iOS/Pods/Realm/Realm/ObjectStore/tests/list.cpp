@@ -0,0 +1,221 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+#include "util/test_file.hpp"
+
+#include "list.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/link_view.hpp>
+
+#include <vector>
+
+using namespace realm;
+
+TEST_CASE("list: notifications for lists observed from several places") {
+    InMemoryTestFile config;
+    config.schema = Schema{
+        {"origin", {
+            {"array", PropertyType::Array|PropertyType::Object, "target"}
+        }},
+        {"target", {
+            {"value", PropertyType::Int}
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto origin = r->read_group().get_table("class_origin");
+    auto target = r->read_group().get_table("class_target");
+
+    const size_t list_count = 10;
+    r->begin_transaction();
+    target->add_empty_row(10);
+    for (size_t i = 0; i < 10; ++i)
+        target->set_int(0, i, i);
+    origin->add_empty_row(list_count);
+    for (size_t i = 0; i < list_count; ++i) {
+        auto lv = origin->get_linklist(0, i);
+        for (size_t j = 0; j < 5; ++j)
+            lv->add(j);
+    }
+    r->commit_transaction();
+
+    auto write = [&](auto&& f) {
+        r->begin_transaction();
+        f();
+        r->commit_transaction();
+        advance_and_notify(*r);
+    };
+
+    SECTION("each source version of the same list sees only the changes after it") {
+        List first(r, *origin, 0, 0);
+        CollectionChangeSet first_change;
+        size_t first_calls = 0;
+        auto first_token = first.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            first_change = c;
+            ++first_calls;
+        });
+
+        r->begin_transaction();
+        origin->get_linklist(0, 0)->add(5);
+        r->commit_transaction();
+
+        // Registered at a newer version than the first notifier, so the
+        // notifiers are advanced from two different source versions at once
+        List second(r, *origin, 0, 0);
+        CollectionChangeSet second_change;
+        size_t second_calls = 0;
+        auto second_token = second.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            second_change = c;
+            ++second_calls;
+        });
+
+        write([&] {
+            origin->get_linklist(0, 0)->add(6);
+        });
+
+        REQUIRE(first_calls == 1);
+        REQUIRE_INDICES(first_change.insertions, 5, 6);
+        REQUIRE(second_calls == 1);
+        REQUIRE_INDICES(second_change.insertions, 6);
+
+        write([&] {
+            origin->get_linklist(0, 0)->remove(0);
+        });
+
+        REQUIRE(first_calls == 2);
+        REQUIRE_INDICES(first_change.deletions, 0);
+        REQUIRE(second_calls == 2);
+        REQUIRE_INDICES(second_change.deletions, 0);
+    }
+
+    SECTION("changes from every later source version are merged into the earlier ones") {
+        const size_t count = 3;
+        std::vector<List> lists;
+        std::vector<CollectionChangeSet> changes(count);
+        std::vector<size_t> calls(count);
+        std::vector<NotificationToken> tokens;
+
+        // Each notifier is registered after another append, so the three
+        // have different source versions
+        for (size_t i = 0; i < count; ++i) {
+            lists.emplace_back(r, *origin, 0, 0);
+            tokens.push_back(lists.back().add_notification_callback([&, i](CollectionChangeSet c, std::exception_ptr) {
+                changes[i] = c;
+                ++calls[i];
+            }));
+
+            r->begin_transaction();
+            origin->get_linklist(0, 0)->add(5 + i);
+            r->commit_transaction();
+        }
+        advance_and_notify(*r);
+
+        for (size_t i = 0; i < count; ++i)
+            REQUIRE(calls[i] == 1);
+        REQUIRE_INDICES(changes[0].insertions, 5, 6, 7);
+        REQUIRE_INDICES(changes[1].insertions, 6, 7);
+        REQUIRE_INDICES(changes[2].insertions, 7);
+    }
+
+    SECTION("observed lists are tracked as their rows move") {
+        std::vector<List> lists;
+        std::vector<CollectionChangeSet> changes(list_count);
+        std::vector<size_t> calls(list_count);
+        std::vector<NotificationToken> tokens;
+        for (size_t i = 0; i < list_count; ++i)
+            lists.emplace_back(r, *origin, 0, i);
+        for (size_t i = 0; i < list_count; ++i) {
+            tokens.push_back(lists[i].add_notification_callback([&, i](CollectionChangeSet c, std::exception_ptr) {
+                changes[i] = c;
+                ++calls[i];
+            }));
+        }
+        advance_and_notify(*r);
+        REQUIRE(calls == std::vector<size_t>(list_count, 1));
+        std::fill(calls.begin(), calls.end(), 0);
+
+        SECTION("move_last_over() after the moved list was already looked up") {
+            write([&] {
+                origin->get_linklist(0, 9)->add(5);
+                origin->move_last_over(2);
+                origin->get_linklist(0, 2)->add(6);
+                origin->get_linklist(0, 5)->remove(0);
+            });
+
+            REQUIRE(calls[9] == 1);
+            REQUIRE_INDICES(changes[9].insertions, 5, 6);
+            REQUIRE(calls[2] == 1);
+            REQUIRE_INDICES(changes[2].deletions, 0, 1, 2, 3, 4);
+            REQUIRE(calls[5] == 1);
+            REQUIRE_INDICES(changes[5].deletions, 0);
+            for (size_t i : {0, 1, 3, 4, 6, 7, 8})
+                REQUIRE(calls[i] == 0);
+        }
+
+        SECTION("insert_empty_row() shifts the observed lists") {
+            write([&] {
+                origin->get_linklist(0, 3)->add(5);
+                origin->insert_empty_row(0, 2);
+                origin->get_linklist(0, 5)->add(6);
+                origin->get_linklist(0, 3)->remove(4);
+            });
+
+            REQUIRE(calls[3] == 1);
+            REQUIRE_INDICES(changes[3].insertions, 5, 6);
+            REQUIRE(calls[1] == 1);
+            REQUIRE_INDICES(changes[1].deletions, 4);
+            for (size_t i : {0, 2, 4, 5, 6, 7, 8, 9})
+                REQUIRE(calls[i] == 0);
+        }
+
+        SECTION("swap_rows() exchanges the observed lists") {
+            write([&] {
+                origin->get_linklist(0, 1)->add(5);
+                origin->swap_rows(1, 4);
+                origin->get_linklist(0, 1)->remove(0);
+                origin->get_linklist(0, 4)->add(6);
+            });
+
+            REQUIRE(calls[1] == 1);
+            REQUIRE_INDICES(changes[1].insertions, 5, 6);
+            REQUIRE(calls[4] == 1);
+            REQUIRE_INDICES(changes[4].deletions, 0);
+            for (size_t i : {0, 2, 3, 5, 6, 7, 8, 9})
+                REQUIRE(calls[i] == 0);
+        }
+
+        SECTION("clear() drops every observed list") {
+            write([&] {
+                origin->clear();
+            });
+
+            for (size_t i = 0; i < list_count; ++i) {
+                REQUIRE(calls[i] == 1);
+                REQUIRE_INDICES(changes[i].deletions, 0, 1, 2, 3, 4);
+            }
+        }
+    }
+}
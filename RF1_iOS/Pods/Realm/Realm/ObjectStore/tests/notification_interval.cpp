@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+#include "util/test_file.hpp"
+
+#include "impl/realm_coordinator.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace realm;
+
+TEST_CASE("notification interval") {
+    using namespace std::chrono;
+
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int}
+        }},
+    };
+    config.notification_interval = milliseconds(500);
+
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_object");
+    auto coordinator = _impl::RealmCoordinator::get_existing_coordinator(config.path);
+
+    // A second Realm for the same file, standing in for another thread
+    Realm::Config config2 = config;
+    config2.cache = false;
+    auto r2 = Realm::get_shared_realm(config2);
+    auto table2 = r2->read_group().get_table("class_object");
+    auto write = [&] {
+        r2->begin_transaction();
+        table2->add_empty_row();
+        r2->commit_transaction();
+    };
+
+    Results results(r, *table);
+    CollectionChangeSet change;
+    size_t calls = 0;
+    auto token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+        change = std::move(c);
+        ++calls;
+    });
+    advance_and_notify(*r);
+    REQUIRE(calls == 1);
+
+    SECTION("delivery waits out the interval and coalesces the commits") {
+        write();
+        write();
+
+        auto start = steady_clock::now();
+        on_change_but_no_notify(*r);
+        REQUIRE(steady_clock::now() - start >= milliseconds(400));
+
+        r->notify();
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 0, 1);
+    }
+
+    SECTION("refreshing doesn't wait for or cut short the interval") {
+        write();
+
+        // Stands in for the notifier worker thread, and waits out the
+        // interval after running the notifiers for the first write
+        std::atomic<bool> delivered{false};
+        std::thread worker([&] {
+            coordinator->on_change();
+            delivered = true;
+        });
+        std::this_thread::sleep_for(milliseconds(50));
+
+        // The notifiers haven't seen this write, so refresh() needs them to
+        // run again while the worker is still holding back the delivery
+        write();
+
+        auto start = steady_clock::now();
+        r->refresh();
+        auto elapsed = steady_clock::now() - start;
+        bool delivered_during_refresh = delivered;
+        worker.join();
+
+        REQUIRE(elapsed < milliseconds(250));
+        REQUIRE_FALSE(delivered_during_refresh);
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 0, 1);
+    }
+}
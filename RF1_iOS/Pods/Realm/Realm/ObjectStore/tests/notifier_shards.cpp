@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/query_expression.hpp>
+
+using namespace realm;
+
+// Each notifier SharedGroup only takes on more than four notifiers once no
+// more can be opened, so with a dozen notifiers they span several shards on
+// any machine with more than one core
+TEST_CASE("notifier shards") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int}
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_object");
+
+    r->begin_transaction();
+    for (int64_t i = 0; i < 10; ++i)
+        table->set_int(0, table->add_empty_row(), i);
+    r->commit_transaction();
+
+    struct Observed {
+        Results results;
+        CollectionChangeSet change;
+        size_t calls = 0;
+        size_t table_size = 0;
+        size_t results_size = 0;
+        NotificationToken token;
+    };
+
+    // Observer i sees the objects with a value of at least i, in table order
+    std::vector<std::unique_ptr<Observed>> observed;
+    auto observe = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            observed.push_back(std::make_unique<Observed>());
+            auto& o = *observed.back();
+            o.results = Results(r, table->where().greater_equal(0, int64_t(i)));
+            o.token = o.results.add_notification_callback([&o, &table](CollectionChangeSet c, std::exception_ptr) {
+                o.change = std::move(c);
+                o.table_size = table->size();
+                o.results_size = o.results.size();
+                ++o.calls;
+            });
+        }
+    };
+
+    // Modify the last object so that it matches every query, and add one
+    // which only the queries for 5 and under match
+    auto write = [&] {
+        r->begin_transaction();
+        table->set_int(0, 9, 100);
+        table->set_int(0, table->add_empty_row(), 5);
+        r->commit_transaction();
+    };
+
+    auto require_changes = [&](Observed& o, size_t i) {
+        if (i <= 5) {
+            REQUIRE(o.results_size == 11 - i);
+            REQUIRE_INDICES(o.change.insertions, 10 - i);
+            REQUIRE_INDICES(o.change.modifications, 9 - i);
+        }
+        else if (i <= 9) {
+            REQUIRE(o.results_size == 10 - i);
+            REQUIRE(o.change.insertions.empty());
+            REQUIRE_INDICES(o.change.modifications, 9 - i);
+        }
+        else {
+            REQUIRE(o.results_size == 1);
+            REQUIRE_INDICES(o.change.insertions, 0);
+            REQUIRE(o.change.modifications.empty());
+        }
+        REQUIRE(o.change.deletions.empty());
+    };
+
+    observe(12);
+    advance_and_notify(*r);
+    for (auto& o : observed) {
+        REQUIRE(o->calls == 1);
+        REQUIRE(o->table_size == 10);
+    }
+
+    SECTION("every shard advances to the same version with the right changes") {
+        write();
+        advance_and_notify(*r);
+
+        for (size_t i = 0; i < observed.size(); ++i) {
+            auto& o = *observed[i];
+            REQUIRE(o.calls == 2);
+            REQUIRE(o.table_size == 11);
+            require_changes(o, i);
+        }
+    }
+
+    SECTION("new notifiers join the shards in the same run as a commit to the existing ones") {
+        observe(12);
+        write();
+        advance_and_notify(*r);
+
+        for (size_t i = 0; i < 12; ++i) {
+            auto& o = *observed[i];
+            REQUIRE(o.calls == 2);
+            REQUIRE(o.table_size == 11);
+            require_changes(o, i);
+        }
+        for (size_t i = 12; i < observed.size(); ++i) {
+            auto& o = *observed[i];
+            REQUIRE(o.calls == 1);
+            REQUIRE(o.table_size == 11);
+            REQUIRE(o.change.empty());
+            REQUIRE(o.results_size == observed[i - 12]->results_size);
+        }
+    }
+
+    SECTION("removing notifiers leaves the other shards running") {
+        for (size_t i = 0; i < observed.size(); i += 2)
+            observed[i]->token = {};
+        write();
+        advance_and_notify(*r);
+
+        for (size_t i = 1; i < observed.size(); i += 2) {
+            auto& o = *observed[i];
+            REQUIRE(o.calls == 2);
+            REQUIRE(o.table_size == 11);
+            require_changes(o, i);
+        }
+    }
+}
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object.hpp"
+#include "object_creator.hpp"
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+using namespace realm;
+
+TEST_CASE("ObjectCreator") {
+    TestFile config;
+    config.schema = Schema{
+        {"sample", {
+            {"a", PropertyType::Int},
+            {"b", PropertyType::Int},
+            {"c", PropertyType::String|PropertyType::Nullable},
+            {"list", PropertyType::Array|PropertyType::Int},
+        }},
+        {"keyed", {
+            {"key", PropertyType::Int, Property::IsPrimary{true}},
+            {"value", PropertyType::Double},
+        }},
+    };
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_sample");
+
+    SECTION("sets the listed properties") {
+        ObjectCreator<int, int64_t, util::Optional<std::string>> creator(r, "sample", {"a", "b", "c"});
+        r->begin_transaction();
+        auto object = creator.create(1, 2, std::string("three"));
+        creator.create(4, 5, util::none);
+        r->commit_transaction();
+
+        REQUIRE(table->size() == 2);
+        REQUIRE(&object.get_object_schema() == &*r->schema().find("sample"));
+        REQUIRE(object.row().get_index() == 0);
+        REQUIRE(table->get_int(0, 0) == 1);
+        REQUIRE(table->get_int(1, 0) == 2);
+        REQUIRE(table->get_string(2, 0) == "three");
+        REQUIRE(table->is_null(2, 1));
+    }
+
+    SECTION("optional properties and lists can be left out") {
+        ObjectCreator<int, int> creator(r, "sample", {"a", "b"});
+        r->begin_transaction();
+        creator.create(1, 2);
+        REQUIRE(table->is_null(2, 0));
+        r->cancel_transaction();
+    }
+
+    SECTION("required properties can't be left out") {
+        using Creator = ObjectCreator<int64_t>;
+        REQUIRE_THROWS_AS(Creator(r, "sample", {"a"}), MissingPropertyValueException);
+        REQUIRE_THROWS_AS(Creator(r, "keyed", {"key"}), MissingPropertyValueException);
+    }
+
+    SECTION("rejects properties of the wrong type") {
+        using Creator = ObjectCreator<int64_t, double>;
+        REQUIRE_THROWS_AS(Creator(r, "sample", {"a", "b"}), std::logic_error);
+        REQUIRE_THROWS_AS(Creator(r, "sample", {"a", "missing"}), std::logic_error);
+        REQUIRE_THROWS_AS((ObjectCreator<int64_t, util::Optional<int64_t>>(r, "sample", {"a", "b"})),
+                          std::logic_error);
+    }
+
+    SECTION("primary keys must be listed and unique") {
+        REQUIRE_THROWS_AS(ObjectCreator<double>(r, "keyed", {"value"}), std::logic_error);
+
+        ObjectCreator<int64_t, double> creator(r, "keyed", {"key", "value"});
+        r->begin_transaction();
+        creator.create(1, 1.5);
+        REQUIRE_THROWS_AS(creator.create(1, 2.5), std::logic_error);
+        REQUIRE(r->read_group().get_table("class_keyed")->size() == 1);
+        r->cancel_transaction();
+    }
+
+    SECTION("follows the columns when the schema changes") {
+        ObjectCreator<int64_t, util::Optional<std::string>> creator(r, "sample", {"b", "c"});
+
+        // Removing "a" moves the columns after it down by one
+        r->update_schema(Schema{
+            {"sample", {
+                {"b", PropertyType::Int},
+                {"c", PropertyType::String|PropertyType::Nullable},
+            }},
+            {"keyed", {
+                {"key", PropertyType::Int, Property::IsPrimary{true}},
+                {"value", PropertyType::Double},
+            }},
+        }, 1, [](auto, auto, auto&) {});
+        REQUIRE(table->get_column_index("c") == 1);
+
+        r->begin_transaction();
+        auto object = creator.create(2, std::string("three"));
+        r->commit_transaction();
+        REQUIRE(&object.get_object_schema() == &*r->schema().find("sample"));
+        REQUIRE(table->get_int(0, 0) == 2);
+        REQUIRE(table->get_string(1, 0) == "three");
+    }
+
+    SECTION("throws if a required property is added to the schema") {
+        ObjectCreator<int64_t, int64_t> creator(r, "sample", {"a", "b"});
+        r->update_schema(Schema{
+            {"sample", {
+                {"a", PropertyType::Int},
+                {"b", PropertyType::Int},
+                {"c", PropertyType::String|PropertyType::Nullable},
+                {"list", PropertyType::Array|PropertyType::Int},
+                {"d", PropertyType::Int},
+            }},
+            {"keyed", {
+                {"key", PropertyType::Int, Property::IsPrimary{true}},
+                {"value", PropertyType::Double},
+            }},
+        }, 1, [](auto, auto, auto&) {});
+
+        r->begin_transaction();
+        REQUIRE_THROWS_AS(creator.create(1, 2), MissingPropertyValueException);
+        REQUIRE(table->size() == 0);
+        r->cancel_transaction();
+    }
+}
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "prepared_query.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/query.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace realm;
+
+TEST_CASE("PreparedQuery") {
+    PreparedQuery::clear_cache();
+
+    TestFile config;
+    config.schema = Schema{
+        {"person", {
+            {"name", PropertyType::String},
+            {"age", PropertyType::Int},
+        }},
+    };
+    auto r = Realm::get_shared_realm(config);
+    auto add_people = [](Realm& realm, std::vector<std::pair<std::string, int64_t>> const& people) {
+        auto table = realm.read_group().get_table("class_person");
+        realm.begin_transaction();
+        for (auto& person : people) {
+            size_t row = table->add_empty_row();
+            table->set_string(0, row, person.first);
+            table->set_int(1, row, person.second);
+        }
+        realm.commit_transaction();
+    };
+    add_people(*r, {{"a", 10}, {"b", 20}, {"c", 30}, {"b", 40}, {"a", 50}});
+
+    SECTION("get() returns the cached instance") {
+        auto query = PreparedQuery::get("person", "age > $0");
+        REQUIRE(PreparedQuery::get("person", "age > $0") == query);
+        REQUIRE(PreparedQuery::get("person", "age < $0") != query);
+        REQUIRE(PreparedQuery::get("other", "age > $0") != query);
+        REQUIRE(query->get_object_type() == "person");
+        REQUIRE(query->get_text() == "age > $0");
+    }
+
+    SECTION("clear_cache() leaves existing instances usable") {
+        auto query = PreparedQuery::get("person", "age > $0");
+        PreparedQuery::clear_cache();
+        REQUIRE(PreparedQuery::get("person", "age > $0") != query);
+        REQUIRE(query->query(*r, {util::Any(int64_t(25))}).count() == 3);
+    }
+
+    SECTION("get() throws for invalid query text") {
+        REQUIRE_THROWS(PreparedQuery::get("person", "age >"));
+    }
+
+    SECTION("the least recently used query is evicted after 256") {
+        auto text = [](size_t i) { return util::format("age > %1", i); };
+        auto first = PreparedQuery::get("person", text(0));
+        auto second = PreparedQuery::get("person", text(1));
+        for (size_t i = 2; i < 256; ++i)
+            PreparedQuery::get("person", text(i));
+
+        // Using the first query again makes the second one the oldest
+        REQUIRE(PreparedQuery::get("person", text(0)) == first);
+        PreparedQuery::get("person", text(256));
+        REQUIRE(PreparedQuery::get("person", text(0)) == first);
+        REQUIRE(PreparedQuery::get("person", text(1)) != second);
+    }
+
+    SECTION("binds arguments to placeholders") {
+        auto query = PreparedQuery::get("person", "age > $0 AND name == $1");
+        REQUIRE(query->query(*r, {util::Any(int64_t(15)), util::Any(StringData("b"))}).count() == 2);
+        REQUIRE(query->query(*r, {util::Any(int64_t(15)), util::Any(StringData("a"))}).count() == 1);
+        REQUIRE(query->query(*r, {util::Any(int64_t(100)), util::Any(StringData("a"))}).count() == 0);
+    }
+
+    SECTION("throws for too few arguments") {
+        auto query = PreparedQuery::get("person", "age > $0 AND name == $1");
+        REQUIRE_THROWS_AS(query->query(*r, {util::Any(int64_t(15))}), std::out_of_range);
+        REQUIRE_THROWS_AS(query->results(r), std::out_of_range);
+    }
+
+    SECTION("throws for an object type which isn't in the Realm") {
+        auto query = PreparedQuery::get("other", "age > 5");
+        REQUIRE_THROWS_AS(query->query(*r), std::logic_error);
+    }
+
+    SECTION("results() applies SORT, DISTINCT and LIMIT") {
+        auto query = PreparedQuery::get("person", "age > $0 SORT(age DESC) DISTINCT(name) LIMIT(2)");
+        auto results = query->results(r, {util::Any(int64_t(15))});
+        REQUIRE(results.size() == 2);
+        REQUIRE(results.get(0).get_int(1) == 50);
+        REQUIRE(results.get(1).get_int(1) == 40);
+
+        // query() ignores them
+        REQUIRE(query->query(*r, {util::Any(int64_t(15))}).count() == 4);
+    }
+
+    SECTION("can be used with different Realms") {
+        TestFile config2;
+        config2.schema = config.schema;
+        auto r2 = Realm::get_shared_realm(config2);
+        add_people(*r2, {{"d", 60}, {"e", 70}});
+
+        auto query = PreparedQuery::get("person", "age > $0");
+        REQUIRE(query->query(*r, {util::Any(int64_t(25))}).count() == 3);
+        REQUIRE(query->query(*r2, {util::Any(int64_t(25))}).count() == 2);
+    }
+
+    SECTION("can be shared between threads") {
+        auto query = PreparedQuery::get("person", "age > $0");
+        std::vector<std::shared_ptr<PreparedQuery const>> from_threads(4);
+        std::vector<size_t> counts(4);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < 4; ++i) {
+            threads.emplace_back([&, i] {
+                from_threads[i] = PreparedQuery::get("person", "age > $0");
+                auto realm = Realm::get_shared_realm(config);
+                counts[i] = from_threads[i]->query(*realm, {util::Any(int64_t(i * 10 + 5))}).count();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        for (size_t i = 0; i < 4; ++i) {
+            REQUIRE(from_threads[i] == query);
+            REQUIRE(counts[i] == 5 - i);
+        }
+    }
+
+    SECTION("threads preparing the same query get the same instance") {
+        std::vector<std::shared_ptr<PreparedQuery const>> from_threads(8);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < 8; ++i)
+            threads.emplace_back([&, i] { from_threads[i] = PreparedQuery::get("person", "name BEGINSWITH $0"); });
+        for (auto& thread : threads)
+            thread.join();
+        for (auto& query : from_threads)
+            REQUIRE(query == from_threads[0]);
+    }
+
+    PreparedQuery::clear_cache();
+}
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/index_helpers.hpp"
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/query_expression.hpp>
+
+using namespace realm;
+
+TEST_CASE("ResultsNotifier: appended rows") {
+    TestFile config;
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int}
+        }},
+        {"linking", {
+            {"value", PropertyType::Int},
+            {"link", PropertyType::Object|PropertyType::Nullable, "target"}
+        }},
+        {"target", {
+            {"value", PropertyType::Int}
+        }},
+    };
+
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_object");
+    auto linking = r->read_group().get_table("class_linking");
+    auto target = r->read_group().get_table("class_target");
+
+    r->begin_transaction();
+    for (int64_t i = 0; i < 10; ++i) {
+        table->set_int(0, table->add_empty_row(), i);
+        linking->set_int(0, linking->add_empty_row(), i);
+        target->set_int(0, target->add_empty_row(), i);
+        linking->set_link(1, i, i);
+    }
+    r->commit_transaction();
+
+    auto write = [&](auto&& fn) {
+        r->begin_transaction();
+        fn();
+        r->commit_transaction();
+        advance_and_notify(*r);
+    };
+
+    // Whichever way the notifier got there, the results have to be the
+    // same as running the query from scratch
+    auto require_rows = [](Results& results, Query query) {
+        auto expected = query.find_all();
+        REQUIRE(results.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+            REQUIRE(results.get(i).get_index() == expected.get_source_ndx(i));
+    };
+
+    CollectionChangeSet change;
+    size_t calls = 0;
+    auto callback = [&](CollectionChangeSet c, std::exception_ptr) {
+        change = std::move(c);
+        ++calls;
+    };
+
+    SECTION("commits which only append rows add the new matches to the end") {
+        Results results(r, table->where().greater_equal(0, 5));
+        auto token = results.add_notification_callback(callback);
+        advance_and_notify(*r);
+        REQUIRE(calls == 1);
+
+        write([&] {
+            table->set_int(0, table->add_empty_row(), 7);
+            table->set_int(0, table->add_empty_row(), 2);
+            table->set_int(0, table->add_empty_row(), 8);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 5, 6);
+        REQUIRE(change.deletions.empty());
+        REQUIRE(change.modifications.empty());
+        require_rows(results, table->where().greater_equal(0, 5));
+
+        // Appends after the first one carry on from the previous run
+        write([&] {
+            table->set_int(0, table->add_empty_row(), 1);
+        });
+        REQUIRE(calls == 2);
+        require_rows(results, table->where().greater_equal(0, 5));
+
+        write([&] {
+            table->set_int(0, table->add_empty_row(), 9);
+        });
+        REQUIRE(calls == 3);
+        REQUIRE_INDICES(change.insertions, 7);
+        require_rows(results, table->where().greater_equal(0, 5));
+    }
+
+    SECTION("commits which also change existing rows are diffed in full") {
+        Results results(r, table->where().greater_equal(0, 5));
+        auto token = results.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        // Row 0 starts matching and row 9 is modified along with the append
+        write([&] {
+            table->set_int(0, 0, 6);
+            table->set_int(0, 9, 10);
+            table->set_int(0, table->add_empty_row(), 7);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 0, 6);
+        REQUIRE_INDICES(change.modifications, 4);
+        REQUIRE(change.deletions.empty());
+        require_rows(results, table->where().greater_equal(0, 5));
+
+        // A deletion moves the last row over the deleted one
+        write([&] {
+            table->set_int(0, table->add_empty_row(), 8);
+            table->move_last_over(5);
+        });
+        REQUIRE(calls == 3);
+        require_rows(results, table->where().greater_equal(0, 5));
+
+        // And appending works again after a full run
+        write([&] {
+            table->set_int(0, table->add_empty_row(), 5);
+        });
+        REQUIRE(calls == 4);
+        REQUIRE_INDICES(change.insertions, results.size() - 1);
+        REQUIRE(change.modifications.empty());
+        require_rows(results, table->where().greater_equal(0, 5));
+    }
+
+    SECTION("appends to a table with links still report changes to linked objects") {
+        Results results(r, linking->where().greater_equal(0, 5));
+        auto token = results.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            auto row = linking->add_empty_row();
+            linking->set_int(0, row, 6);
+            linking->set_link(1, row, 0);
+            target->set_int(0, 9, 90);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 5);
+        REQUIRE_INDICES(change.modifications, 4);
+        require_rows(results, linking->where().greater_equal(0, 5));
+    }
+
+    SECTION("appends to a table which is linked to are picked up") {
+        Results results(r, target->where().greater_equal(0, 5));
+        auto token = results.add_notification_callback(callback);
+        advance_and_notify(*r);
+
+        write([&] {
+            target->set_int(0, target->add_empty_row(), 7);
+            target->set_int(0, target->add_empty_row(), 3);
+        });
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 5);
+        require_rows(results, target->where().greater_equal(0, 5));
+    }
+}
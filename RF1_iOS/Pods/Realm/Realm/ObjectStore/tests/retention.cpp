@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "retention.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/group_shared.hpp>
+#include <realm/table.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace realm;
+
+TEST_CASE("retention policies") {
+    TestFile config;
+    config.schema = Schema{
+        {"sample", {
+            {"time", PropertyType::Int},
+            {"value", PropertyType::Int},
+        }},
+    };
+    RetentionPolicy policy;
+    policy.object_type = "sample";
+    policy.time_property = "time";
+
+    // Add objects with the given times in an order unrelated to their times,
+    // so that nothing depends on the oldest objects being the first rows
+    auto add_samples = [](Realm& r, std::vector<int64_t> times) {
+        std::reverse(times.begin(), times.end());
+        std::rotate(times.begin(), times.begin() + times.size() / 3, times.end());
+        auto table = r.read_group().get_table("class_sample");
+        r.begin_transaction();
+        size_t row = table->add_empty_row(times.size());
+        for (auto time : times) {
+            table->set_int(0, row, time);
+            table->set_int(1, row, time * 10);
+            ++row;
+        }
+        r.commit_transaction();
+    };
+    auto times_range = [](int64_t begin, int64_t end) {
+        std::vector<int64_t> times;
+        for (int64_t i = begin; i < end; ++i)
+            times.push_back(i);
+        return times;
+    };
+    auto remaining_times = [](Realm& r) {
+        auto table = r.read_group().get_table("class_sample");
+        std::vector<int64_t> times;
+        for (size_t i = 0; i < table->size(); ++i)
+            times.push_back(table->get_int(0, i));
+        std::sort(times.begin(), times.end());
+        return times;
+    };
+    auto open = [&] {
+        config.retention_policies = {policy};
+        return Realm::get_shared_realm(config);
+    };
+
+    SECTION("max_age keeps objects within the age of the newest one") {
+        policy.max_age = 10;
+        auto r = open();
+        add_samples(*r, times_range(0, 100));
+        REQUIRE(r->enforce_retention() == 89);
+        REQUIRE(remaining_times(*r) == times_range(89, 100));
+    }
+
+    SECTION("max_count keeps the newest objects") {
+        policy.max_count = 25;
+        auto r = open();
+        add_samples(*r, times_range(0, 100));
+        REQUIRE(r->enforce_retention() == 75);
+        REQUIRE(remaining_times(*r) == times_range(75, 100));
+    }
+
+    SECTION("max_count keeps every object which ties with the oldest one kept") {
+        policy.max_count = 3;
+        auto r = open();
+        add_samples(*r, {1, 2, 2, 2, 3});
+        REQUIRE(r->enforce_retention() == 1);
+        REQUIRE(remaining_times(*r) == (std::vector<int64_t>{2, 2, 2, 3}));
+    }
+
+    SECTION("max_bytes keeps the newest objects which fit") {
+        auto r = open();
+        add_samples(*r, times_range(0, 100));
+        auto bytes = r->read_group().get_table("class_sample")->compute_aggregated_byte_size();
+        policy.max_bytes = bytes / 2;
+        r->close();
+
+        r = open();
+        size_t deleted = r->enforce_retention();
+        REQUIRE(deleted >= 50);
+        REQUIRE(deleted <= 51);
+        REQUIRE(remaining_times(*r) == times_range(deleted, 100));
+    }
+
+    SECTION("the strictest limit applies") {
+        policy.max_age = 50;
+        policy.max_count = 20;
+        auto r = open();
+        add_samples(*r, times_range(0, 100));
+        REQUIRE(r->enforce_retention() == 80);
+        REQUIRE(remaining_times(*r) == times_range(80, 100));
+    }
+
+    SECTION("objects within every limit are left alone") {
+        policy.max_age = 1000;
+        policy.max_count = 1000;
+        auto r = open();
+        add_samples(*r, times_range(0, 100));
+        REQUIRE(r->enforce_retention() == 0);
+        REQUIRE(remaining_times(*r).size() == 100);
+    }
+
+    SECTION("a limit which keeps nothing deletes objects with the maximum time") {
+        policy.max_bytes = 1;
+        auto r = open();
+        const int64_t max = std::numeric_limits<int64_t>::max();
+        add_samples(*r, {1, max - 1, max, max});
+        REQUIRE(r->enforce_retention() == 4);
+        REQUIRE(remaining_times(*r).empty());
+    }
+
+    SECTION("max_age near the minimum time doesn't overflow") {
+        policy.max_age = 10;
+        auto r = open();
+        const int64_t min = std::numeric_limits<int64_t>::min();
+        add_samples(*r, {min, min + 5});
+        REQUIRE(r->enforce_retention() == 0);
+    }
+
+    SECTION("deletes in batches of retention_batch_size") {
+        policy.max_count = 10;
+        auto version = [](Realm& r) {
+            r.read_group();
+            return TestHelper::get_shared_group(r).get_version_of_current_transaction().version;
+        };
+
+        SECTION("with a partial final batch") {
+            config.retention_batch_size = 3;
+            auto r = open();
+            add_samples(*r, times_range(0, 20));
+            auto before = version(*r);
+            REQUIRE(r->enforce_retention() == 10);
+            REQUIRE(version(*r) - before == 4);
+            REQUIRE(remaining_times(*r) == times_range(10, 20));
+        }
+
+        SECTION("with only full batches") {
+            config.retention_batch_size = 5;
+            auto r = open();
+            add_samples(*r, times_range(0, 20));
+            auto before = version(*r);
+            REQUIRE(r->enforce_retention() == 10);
+            REQUIRE(version(*r) - before == 2);
+            REQUIRE(remaining_times(*r) == times_range(10, 20));
+        }
+    }
+
+    SECTION("can't be enforced in a write transaction") {
+        policy.max_count = 10;
+        auto r = open();
+        r->begin_transaction();
+        REQUIRE_THROWS(r->enforce_retention());
+        r->cancel_transaction();
+    }
+
+    SECTION("rejects a time property which isn't a non-optional int") {
+        policy.time_property = "missing";
+        auto r = open();
+        add_samples(*r, times_range(0, 10));
+        REQUIRE_THROWS(r->enforce_retention());
+    }
+
+    SECTION("is enforced on a background thread") {
+        policy.max_count = 10;
+        config.retention_interval = std::chrono::milliseconds(10);
+        auto r = open();
+        add_samples(*r, times_range(0, 100));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (remaining_times(*r).size() > 10 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            r->refresh();
+        }
+        REQUIRE(remaining_times(*r) == times_range(90, 100));
+    }
+}
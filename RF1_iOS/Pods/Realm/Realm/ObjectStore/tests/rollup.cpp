@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "rollup.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+
+using namespace realm;
+using Function = RollupDefinition::Function;
+
+TEST_CASE("Rollup::object_schema()") {
+    ObjectSchema source("reading", {
+        {"time", PropertyType::Int},
+        {"value", PropertyType::Int},
+        {"temp", PropertyType::Double},
+        {"label", PropertyType::String},
+        {"maybe", PropertyType::Int|PropertyType::Nullable},
+    });
+    RollupDefinition definition{"per_minute", "reading", "time", 60, {
+        {"value", Function::Sum}, {"temp", Function::Max},
+    }};
+
+    SECTION("has an indexed bucket, a count and a property per aggregate") {
+        auto schema = Rollup::object_schema(definition, source);
+        REQUIRE(schema.name == "per_minute");
+        REQUIRE(schema.persisted_properties.size() == 4);
+        REQUIRE(schema.property_for_name("bucket")->is_indexed);
+        REQUIRE(schema.property_for_name("count")->type == PropertyType::Int);
+        REQUIRE(schema.property_for_name("value_sum")->type == PropertyType::Int);
+        REQUIRE(schema.property_for_name("temp_max")->type == PropertyType::Double);
+    }
+
+    SECTION("rejects a bucket width which isn't positive") {
+        definition.bucket_width = 0;
+        REQUIRE_THROWS_AS(Rollup::object_schema(definition, source), std::invalid_argument);
+    }
+
+    SECTION("rejects a source schema for the wrong type") {
+        definition.source_type = "other";
+        REQUIRE_THROWS_AS(Rollup::object_schema(definition, source), std::invalid_argument);
+    }
+
+    SECTION("rejects a time property which isn't a required int") {
+        definition.time_property = "maybe";
+        REQUIRE_THROWS_AS(Rollup::object_schema(definition, source), std::invalid_argument);
+        definition.time_property = "missing";
+        REQUIRE_THROWS_AS(Rollup::object_schema(definition, source), std::invalid_argument);
+    }
+
+    SECTION("rejects aggregates over non-numeric properties") {
+        definition.aggregates.push_back({"label", Function::Min});
+        REQUIRE_THROWS_AS(Rollup::object_schema(definition, source), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Rollup") {
+    ObjectSchema source("reading", {
+        {"time", PropertyType::Int},
+        {"value", PropertyType::Int},
+        {"temp", PropertyType::Double},
+    });
+    RollupDefinition definition{"per_minute", "reading", "time", 60, {
+        {"value", Function::Sum}, {"value", Function::Max}, {"temp", Function::Min},
+    }};
+
+    TestFile config;
+    config.schema = Schema{source, Rollup::object_schema(definition, source)};
+    config.rollups = {definition};
+    auto r = Realm::get_shared_realm(config);
+    auto table = r->read_group().get_table("class_reading");
+    auto buckets = r->read_group().get_table("class_per_minute");
+
+    auto add = [&](int64_t time, int64_t value, double temp) {
+        size_t row = table->add_empty_row();
+        table->set_int(0, row, time);
+        table->set_int(1, row, value);
+        table->set_double(2, row, temp);
+    };
+    auto read = [&](int64_t begin, int64_t end, int64_t width = 0) {
+        return Rollup::read(*r, definition, begin, end, width);
+    };
+
+    r->begin_transaction();
+    add(0, 1, 20.5);
+    add(59, 5, 19.0);
+    add(60, 2, 21.0);
+    add(-1, 7, 18.0);
+    r->commit_transaction();
+
+    SECTION("is updated when source objects are committed") {
+        REQUIRE(buckets->size() == 3);
+        auto result = read(-60, 120);
+        REQUIRE(result.size() == 3);
+
+        // Negative times are in the bucket before zero, not the one at zero
+        REQUIRE(result[0].start == -60);
+        REQUIRE(result[0].count == 1);
+        REQUIRE(result[0].values == std::vector<double>{7, 7, 18.0});
+
+        REQUIRE(result[1].start == 0);
+        REQUIRE(result[1].count == 2);
+        REQUIRE(result[1].values == std::vector<double>{6, 5, 19.0});
+
+        REQUIRE(result[2].start == 60);
+        REQUIRE(result[2].count == 1);
+        REQUIRE(result[2].values == std::vector<double>{2, 2, 21.0});
+    }
+
+    SECTION("later objects are folded into the existing buckets") {
+        r->begin_transaction();
+        add(30, 10, 17.5);
+        add(120, 3, 25.0);
+        r->commit_transaction();
+
+        REQUIRE(buckets->size() == 4);
+        auto result = read(0, 180);
+        REQUIRE(result.size() == 3);
+        REQUIRE(result[0].count == 3);
+        REQUIRE(result[0].values == std::vector<double>{16, 10, 17.5});
+        REQUIRE(result[2].start == 120);
+        REQUIRE(result[2].values == std::vector<double>{3, 3, 25.0});
+    }
+
+    SECTION("cancelled transactions don't change the rollup") {
+        r->begin_transaction();
+        add(0, 100, 0.0);
+        r->cancel_transaction();
+
+        auto result = read(0, 60);
+        REQUIRE(result.size() == 1);
+        REQUIRE(result[0].count == 2);
+        REQUIRE(result[0].values == std::vector<double>{6, 5, 19.0});
+    }
+
+    SECTION("deleting source objects doesn't change the rollup") {
+        // Moves the last row into the first one's place, which mustn't be
+        // counted as a new object
+        r->begin_transaction();
+        table->move_last_over(0);
+        r->commit_transaction();
+
+        auto result = read(-60, 120);
+        REQUIRE(result.size() == 3);
+        REQUIRE(result[0].count == 1);
+        REQUIRE(result[1].count == 2);
+        REQUIRE(result[2].count == 1);
+    }
+
+    SECTION("modifying source objects doesn't change the rollup") {
+        r->begin_transaction();
+        table->set_int(1, 0, 1000);
+        r->commit_transaction();
+        REQUIRE(read(0, 60)[0].values == std::vector<double>{6, 5, 19.0});
+    }
+
+    SECTION("read() merges buckets into multiples of the bucket width") {
+        auto result = read(-120, 120, 120);
+        REQUIRE(result.size() == 2);
+        REQUIRE(result[0].start == -120);
+        REQUIRE(result[0].count == 1);
+        REQUIRE(result[1].start == 0);
+        REQUIRE(result[1].count == 3);
+        REQUIRE(result[1].values == std::vector<double>{8, 5, 19.0});
+    }
+
+    SECTION("read() only returns buckets in range") {
+        REQUIRE(read(0, 60).size() == 1);
+        REQUIRE(read(1, 60).empty());
+        REQUIRE(read(60, 0).empty());
+    }
+
+    SECTION("read() rejects widths which aren't multiples of the bucket width") {
+        REQUIRE_THROWS_AS(read(0, 60, 90), std::invalid_argument);
+        REQUIRE_THROWS_AS(read(0, 60, -60), std::invalid_argument);
+    }
+
+    SECTION("rebuild() recomputes the rollup from the current source objects") {
+        r->begin_transaction();
+        table->move_last_over(0);
+        table->set_int(1, 0, 1000);
+        Rollup::rebuild(*r, definition);
+        r->commit_transaction();
+
+        auto result = read(-60, 120);
+        REQUIRE(result.size() == 3);
+        REQUIRE(result[0].start == -60);
+        REQUIRE(result[1].count == 1);
+        REQUIRE(result[1].values == std::vector<double>{5, 5, 19.0});
+        REQUIRE(result[2].values == std::vector<double>{2, 2, 21.0});
+    }
+
+    SECTION("rebuild() must be called in a write transaction") {
+        REQUIRE_THROWS(Rollup::rebuild(*r, definition));
+    }
+}
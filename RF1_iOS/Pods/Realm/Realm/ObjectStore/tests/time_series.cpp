@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+#include "time_series.hpp"
+
+#include <realm/group.hpp>
+
+#include <vector>
+
+using namespace realm;
+
+TEST_CASE("TimeSeries") {
+    TestFile config;
+    config.schema = Schema{TimeSeries::object_schema("sensor", {"a", "b"})};
+    auto r = Realm::get_shared_realm(config);
+    TimeSeries series(r, "sensor", 4);
+    auto& table = series.get_table();
+
+    // Sample i is at time 10 * i with values i and -i
+    auto append = [&](TimeSeries& series, int64_t first, int64_t last) {
+        for (int64_t i = first; i < last; ++i) {
+            int64_t values[] = {i, -i};
+            series.append(i * 10, values);
+        }
+    };
+    auto require_samples = [&](TimeSeries const& series, int64_t count) {
+        std::vector<int64_t> times;
+        std::vector<std::vector<int64_t>> columns;
+        series.read(0, count * 10, times, columns);
+        REQUIRE(times.size() == size_t(count));
+        for (int64_t i = 0; i < count; ++i) {
+            REQUIRE(times[i] == i * 10);
+            REQUIRE(columns[0][i] == i);
+            REQUIRE(columns[1][i] == -i);
+        }
+    };
+
+    SECTION("start and end are indexed") {
+        REQUIRE(table.has_search_index(table.get_column_index("start")));
+        REQUIRE(table.has_search_index(table.get_column_index("end")));
+    }
+
+    SECTION("the open chunk is only written when it fills up") {
+        r->begin_transaction();
+        append(series, 0, 3);
+        REQUIRE(table.size() == 1);
+        REQUIRE(table.get_int(table.get_column_index("count"), 0) == 0);
+        REQUIRE(table.get_binary(table.get_column_index("time"), 0).size() <= 8);
+
+        append(series, 3, 5);
+        REQUIRE(table.size() == 2);
+        REQUIRE(table.get_int(table.get_column_index("count"), 0) == 4);
+        REQUIRE(table.get_int(table.get_column_index("end"), 0) == 30);
+        r->cancel_transaction();
+    }
+
+    SECTION("reading flushes the open chunk") {
+        r->begin_transaction();
+        append(series, 0, 6);
+        REQUIRE(series.size() == 6);
+        require_samples(series, 6);
+        REQUIRE(series.aggregate(0, 0, 60).sum == 15);
+        r->cancel_transaction();
+    }
+
+    SECTION("committing flushes the open chunk") {
+        r->begin_transaction();
+        append(series, 0, 6);
+        r->commit_transaction();
+
+        Realm::Config config2 = config;
+        config2.cache = false;
+        auto r2 = Realm::get_shared_realm(config2);
+        require_samples(TimeSeries(r2, "sensor", 4), 6);
+    }
+
+    SECTION("appending continues the open chunk across transactions") {
+        for (int64_t i = 0; i < 10; ++i) {
+            r->begin_transaction();
+            append(series, i, i + 1);
+            r->commit_transaction();
+        }
+        REQUIRE(table.size() == 3);
+        require_samples(series, 10);
+    }
+
+    SECTION("cancelling discards the unflushed samples") {
+        r->begin_transaction();
+        append(series, 0, 2);
+        r->commit_transaction();
+
+        r->begin_transaction();
+        append(series, 2, 7);
+        r->cancel_transaction();
+        REQUIRE(series.size() == 2);
+
+        r->begin_transaction();
+        append(series, 2, 5);
+        r->commit_transaction();
+        require_samples(series, 5);
+        REQUIRE(table.size() == 2);
+    }
+
+    SECTION("instances for the same type share the open chunk") {
+        TimeSeries series2(r, "sensor", 4);
+        r->begin_transaction();
+        append(series, 0, 2);
+        append(series2, 2, 3);
+        append(series, 3, 5);
+        r->commit_transaction();
+        require_samples(series2, 5);
+        REQUIRE(table.size() == 2);
+    }
+
+    SECTION("appends from another Realm instance are picked up") {
+        r->begin_transaction();
+        append(series, 0, 2);
+        r->commit_transaction();
+
+        Realm::Config config2 = config;
+        config2.cache = false;
+        auto r2 = Realm::get_shared_realm(config2);
+        TimeSeries series2(r2, "sensor", 4);
+        r2->begin_transaction();
+        append(series2, 2, 3);
+        r2->commit_transaction();
+
+        r->begin_transaction();
+        append(series, 3, 5);
+        r->commit_transaction();
+        require_samples(series, 5);
+        REQUIRE(table.size() == 2);
+    }
+
+    SECTION("flush() writes the open chunk") {
+        r->begin_transaction();
+        append(series, 0, 3);
+        series.flush();
+        REQUIRE(table.get_int(table.get_column_index("count"), 0) == 3);
+        REQUIRE(table.get_int(table.get_column_index("end"), 0) == 20);
+        r->cancel_transaction();
+    }
+
+    SECTION("out of order samples are rejected") {
+        r->begin_transaction();
+        append(series, 0, 3);
+        int64_t values[] = {0, 0};
+        REQUIRE_THROWS(series.append(10, values));
+        r->cancel_transaction();
+    }
+}
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_TEST_UTIL_INDEX_HELPERS_HPP
+#define REALM_TEST_UTIL_INDEX_HELPERS_HPP
+
+#include "index_set.hpp"
+
+#include <initializer_list>
+#include <iterator>
+
+// Check that an IndexSet holds exactly the given indices, in order
+#define REQUIRE_INDICES(index_set, ...) do { \
+    (index_set).verify(); \
+    std::initializer_list<size_t> expected = {__VA_ARGS__}; \
+    auto actual = (index_set).as_indexes(); \
+    REQUIRE(expected.size() == static_cast<size_t>(std::distance(actual.begin(), actual.end()))); \
+    auto it = actual.begin(); \
+    for (auto index : expected) { \
+        REQUIRE(*it++ == index); \
+    } \
+} while (0)
+
+// Check that a change set has exactly the given moves, in order
+#define REQUIRE_MOVES(c, ...) do { \
+    auto&& changes = (c); \
+    std::initializer_list<realm::CollectionChangeSet::Move> expected = {__VA_ARGS__}; \
+    REQUIRE(expected.size() == changes.moves.size()); \
+    auto it = changes.moves.begin(); \
+    for (auto move : expected) { \
+        CHECK(it->from == move.from); \
+        CHECK(it->to == move.to); \
+        ++it; \
+    } \
+} while (0)
+
+#endif // REALM_TEST_UTIL_INDEX_HELPERS_HPP
@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "util/test_file.hpp"
+
+#include "impl/realm_coordinator.hpp"
+
+#include <realm/string_data.hpp>
+#include <realm/util/file.hpp>
+
+using namespace realm;
+
+TestFile::TestFile()
+: m_dir(util::make_temp_dir())
+{
+    path = m_dir + "/test.realm";
+    schema_version = 0;
+    automatic_change_notifications = false;
+}
+
+TestFile::~TestFile()
+{
+    _impl::RealmCoordinator::clear_all_caches();
+    util::try_remove_dir_recursive(m_dir);
+}
+
+InMemoryTestFile::InMemoryTestFile()
+{
+    in_memory = true;
+}
+
+void advance_and_notify(Realm& realm)
+{
+    on_change_but_no_notify(realm);
+    realm.notify();
+}
+
+void on_change_but_no_notify(Realm& realm)
+{
+    _impl::RealmCoordinator::get_existing_coordinator(realm.config().path)->on_change();
+}
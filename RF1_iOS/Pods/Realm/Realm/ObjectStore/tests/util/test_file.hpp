@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef REALM_TEST_UTIL_TEST_FILE_HPP
+#define REALM_TEST_UTIL_TEST_FILE_HPP
+
+#include "shared_realm.hpp"
+
+#include <realm/group_shared.hpp>
+
+// A Realm::Config for a uniquely-named file in a temporary directory, which is
+// removed along with its lock and management files when the config is
+// destroyed. Automatic change notifications are disabled so that tests decide
+// when notifiers run by calling advance_and_notify().
+struct TestFile : realm::Realm::Config {
+    TestFile();
+    ~TestFile();
+
+    TestFile(TestFile const&) = delete;
+    TestFile& operator=(TestFile const&) = delete;
+
+private:
+    std::string m_dir;
+};
+
+struct InMemoryTestFile : TestFile {
+    InMemoryTestFile();
+};
+
+// Run the async notifiers for the Realm's file on the calling thread and then
+// deliver their results to the Realm, as the background notifier thread and
+// the run loop would.
+void advance_and_notify(realm::Realm& realm);
+
+// Run the async notifiers without delivering anything, so that a commit made
+// afterwards is seen by the notifiers as a separate version.
+void on_change_but_no_notify(realm::Realm& realm);
+
+namespace realm {
+class TestHelper {
+public:
+    static SharedGroup& get_shared_group(SharedRealm const& shared_realm)
+    {
+        return *Realm::Internal::get_shared_group(*shared_realm);
+    }
+
+    static SharedGroup& get_shared_group(Realm& realm)
+    {
+        return *Realm::Internal::get_shared_group(realm);
+    }
+};
+}
+
+#endif // REALM_TEST_UTIL_TEST_FILE_HPP
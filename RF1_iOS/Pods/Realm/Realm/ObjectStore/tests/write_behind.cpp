@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+
+#include "catch.hpp"
+
+#include "util/test_file.hpp"
+
+#include "object_schema.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+
+#include <realm/group.hpp>
+#include <realm/link_view.hpp>
+#include <realm/util/file.hpp>
+
+#include <fstream>
+#include <iterator>
+
+using namespace realm;
+
+TEST_CASE("write-behind") {
+    TestFile config;
+    config.in_memory = true;
+    config.write_behind_path = config.path + ".copy";
+    config.schema = Schema{
+        {"object", {
+            {"value", PropertyType::Int},
+            {"name", PropertyType::String|PropertyType::Nullable},
+            {"link", PropertyType::Object|PropertyType::Nullable, "object"},
+            {"list", PropertyType::Array|PropertyType::Object, "object"},
+        }},
+    };
+
+    auto open = [&] {
+        auto r = Realm::get_shared_realm(config);
+        return std::make_pair(r, r->read_group().get_table("class_object"));
+    };
+
+    {
+        auto realm = open();
+        auto r = realm.first;
+        auto table = realm.second;
+        r->begin_transaction();
+        table->add_empty_row(3);
+        for (size_t i = 0; i < 3; ++i)
+            table->set_int(0, i, i * 10);
+        table->set_string(1, 1, "one");
+        table->set_link(2, 0, 2);
+        table->get_linklist(3, 1)->add(2);
+        table->get_linklist(3, 1)->add(0);
+        r->commit_transaction();
+    }
+    REQUIRE(util::File::exists(config.write_behind_path));
+
+    auto require_contents = [&](Table& table, size_t size) {
+        REQUIRE(table.size() == size);
+        for (size_t i = 0; i < 3; ++i)
+            REQUIRE(table.get_int(0, i) == int64_t(i * 10));
+        REQUIRE(table.get_string(1, 0).is_null());
+        REQUIRE(table.get_string(1, 1) == "one");
+        REQUIRE(table.get_link(2, 0) == 2);
+        REQUIRE(table.is_null_link(2, 1));
+        auto list = table.get_linklist(3, 1);
+        REQUIRE(list->size() == 2);
+        REQUIRE(list->get(0).get_index() == 2);
+        REQUIRE(list->get(1).get_index() == 0);
+    };
+
+    SECTION("the persistent copy is loaded when the Realm is reopened") {
+        auto realm = open();
+        require_contents(*realm.second, 3);
+    }
+
+    SECTION("changes made after reopening are added to the loaded data") {
+        {
+            auto realm = open();
+            auto r = realm.first;
+            r->begin_transaction();
+            realm.second->add_empty_row();
+            r->commit_transaction();
+            r->flush_write_behind();
+        }
+
+        auto realm = open();
+        require_contents(*realm.second, 4);
+    }
+
+    SECTION("reopening without writing keeps the copy") {
+        open();
+        auto realm = open();
+        require_contents(*realm.second, 3);
+    }
+
+    SECTION("a copy which can't be loaded is left untouched") {
+        util::File::remove(config.write_behind_path);
+        {
+            std::ofstream out(config.write_behind_path, std::ios::binary);
+            out << "not a realm file";
+        }
+
+        REQUIRE_THROWS(open());
+
+        std::ifstream in(config.write_behind_path, std::ios::binary);
+        std::string contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        REQUIRE(contents == "not a realm file");
+    }
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_BULK_INSERT_HPP
+#define REALM_OS_BULK_INSERT_HPP
+
+#include "property.hpp"
+
+#include <realm/binary_data.hpp>
+#include <realm/string_data.hpp>
+#include <realm/table_ref.hpp>
+#include <realm/timestamp.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace realm {
+class ObjectSchema;
+class Realm;
+
+// The values of one property for each of the objects created by
+// BulkInserter::insert(), in caller-owned contiguous storage which must stay
+// valid until insert() returns. `nulls`, if given, marks the objects which
+// get null rather than the value in `values`; null StringData, BinaryData and
+// Timestamp values are also stored as null.
+class BulkColumn {
+public:
+    BulkColumn(const int64_t* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::Int), m_values(values), m_nulls(nulls) { }
+    BulkColumn(const bool* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::Bool), m_values(values), m_nulls(nulls) { }
+    BulkColumn(const float* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::Float), m_values(values), m_nulls(nulls) { }
+    BulkColumn(const double* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::Double), m_values(values), m_nulls(nulls) { }
+    BulkColumn(const StringData* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::String), m_values(values), m_nulls(nulls) { }
+    BulkColumn(const BinaryData* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::Data), m_values(values), m_nulls(nulls) { }
+    BulkColumn(const Timestamp* values, const bool* nulls = nullptr)
+    : m_type(PropertyType::Date), m_values(values), m_nulls(nulls) { }
+
+private:
+    friend class BulkInserter;
+
+    PropertyType m_type;
+    const void* m_values;
+    const bool* m_nulls;
+
+    template<typename T>
+    T const& get(size_t i) const { return static_cast<const T*>(m_values)[i]; }
+    bool is_null(size_t i) const { return m_nulls && m_nulls[i]; }
+};
+
+// Creates objects of one type from columnar arrays, for importing many objects
+// at once. The properties to set are resolved to table columns up front (and
+// again only if the Realm's schema changes), and each column's values are then
+// written in a single loop, rather than going through an accessor context per
+// property per object as Object::create() does.
+//
+// Properties which aren't listed are left at their zero or empty value (or
+// null if they're nullable); default values from the binding aren't applied.
+// Link and list properties can't be bulk inserted.
+class BulkInserter {
+public:
+    // Throws std::logic_error if `object_type` or one of `properties` doesn't
+    // exist, if a property can't be bulk inserted, or if the type has a primary
+    // key which isn't in `properties`. insert() throws the same if the schema
+    // has since changed so that they no longer hold.
+    BulkInserter(std::shared_ptr<Realm> realm, StringData object_type, std::vector<std::string> properties);
+
+    // Create `count` objects, where `columns[i]` holds the values for the i'th
+    // property passed to the constructor. Must be called in a write
+    // transaction. Throws std::invalid_argument if the columns don't match the
+    // properties' types, or a null is given for a non-optional property, and
+    // std::logic_error if a primary key is duplicated or already exists; no
+    // objects are created in either case.
+    void insert(size_t count, std::vector<BulkColumn> const& columns);
+
+private:
+    std::shared_ptr<Realm> m_realm;
+    std::string m_object_type;
+    std::vector<std::string> m_property_names;
+
+    // Resolved from the schema with the generation m_schema_generation
+    uint64_t m_schema_generation;
+    TableRef m_table;
+    std::vector<Property> m_properties;
+    // Index in m_properties of the primary key, or -1 if there isn't one
+    size_t m_primary_key;
+
+    void resolve();
+    void validate(size_t count, std::vector<BulkColumn> const& columns) const;
+    // Append `count` rows, setting the primary key if there is one, and
+    // return the index of the first
+    size_t create_rows(size_t count, std::vector<BulkColumn> const& columns);
+    void set_column(Property const& prop, BulkColumn const& column, size_t first_row, size_t count);
+};
+
+} // namespace realm
+
+#endif // REALM_OS_BULK_INSERT_HPP
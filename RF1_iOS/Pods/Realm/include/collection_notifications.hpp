@@ -24,7 +24,10 @@
 
 #include <exception>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace realm {
@@ -51,6 +54,19 @@ private:
     uint64_t m_token;
 };
 
+// A path from a collection's object type to a property to observe, as a list
+// of (table index, column index) pairs. Every column but the last one must be a
+// Link or LinkList column whose target is the table of the next pair. Key
+// paths are checked against the current tables when a callback is added.
+using KeyPath = std::vector<std::pair<size_t, size_t>>;
+using KeyPathArray = std::vector<KeyPath>;
+
+// Thrown when registering a notification callback with a key path which does
+// not describe a chain of links from the collection's object type
+struct InvalidKeyPathException : public std::logic_error {
+    InvalidKeyPathException(std::string const& message) : std::logic_error(message) {}
+};
+
 struct CollectionChangeSet {
     struct Move {
         size_t from;
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_ASYNC_WRITE_QUEUE_HPP
+#define REALM_ASYNC_WRITE_QUEUE_HPP
+
+#include "shared_realm.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+// AsyncWriteQueue runs the writes passed to Realm::async_write() on a
+// background thread, grouping writes which arrive close together into a
+// single write transaction so that they share the cost of the commit.
+//
+// The writer thread opens its own Realm instance while there is work to do,
+// and closes it again after being idle for a while so that it doesn't keep the
+// file (and the RealmCoordinator which owns the queue) open indefinitely.
+class AsyncWriteQueue {
+public:
+    AsyncWriteQueue(Realm::Config config);
+    // Waits for all queued writes to complete
+    ~AsyncWriteQueue();
+
+    void push(Realm::AsyncWriteFunction write, Realm::AsyncWriteCompletion completion);
+
+private:
+    struct Write {
+        Realm::AsyncWriteFunction write;
+        Realm::AsyncWriteCompletion completion;
+        std::chrono::steady_clock::time_point queued_at;
+    };
+
+    // Shared with the writer thread, which may outlive the queue when the
+    // last reference to the coordinator is released on the writer thread
+    struct State {
+        Realm::Config config;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Write> writes;
+        bool thread_running = false;
+        bool stop = false;
+    };
+
+    std::shared_ptr<State> m_state;
+    std::thread m_thread;
+
+    static void run(std::shared_ptr<State> state);
+    // Commits the writes in `batch`, removing any which failed after calling
+    // their completion handler with the error
+    static void commit_batch(Realm& realm, std::vector<Write>& batch);
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_ASYNC_WRITE_QUEUE_HPP
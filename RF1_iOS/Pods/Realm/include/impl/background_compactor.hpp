@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_BACKGROUND_COMPACTOR_HPP
+#define REALM_BACKGROUND_COMPACTOR_HPP
+
+#include "shared_realm.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace realm {
+namespace _impl {
+class RealmCoordinator;
+
+// BackgroundCompactor compacts a Realm file on a background thread after a
+// commit has left it past the Config::compaction_* thresholds.
+//
+// Core can only compact a file which no other SharedGroup has open, so once a
+// compaction has been requested the compactor thread waits for the last Realm
+// instance for the file in this process to be closed. It then has the
+// coordinator close its own notifier SharedGroups and leaves it to core to
+// decide if any other process still has the file open. The thread keeps the
+// coordinator alive while it waits, so that reopening the file in the
+// meantime finds the same coordinator and simply defers the compaction.
+class BackgroundCompactor {
+public:
+    BackgroundCompactor(Realm::Config config);
+    // Abandons a compaction which is still waiting for the file to be closed,
+    // and waits for one which has already started
+    ~BackgroundCompactor();
+
+    // Compact the file once it's no longer open in this process
+    void request(std::shared_ptr<RealmCoordinator> coordinator);
+    // Check again if the file can be compacted after a Realm instance or the
+    // last notifier for the file was closed
+    void retry();
+
+private:
+    // Shared with the compactor thread, which may outlive the compactor when
+    // the last reference to the coordinator is released on the compactor thread
+    struct State {
+        Realm::Config config;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool thread_running = false;
+        bool retry = false;
+        bool stop = false;
+    };
+
+    std::shared_ptr<State> m_state;
+    std::thread m_thread;
+
+    static void run(std::shared_ptr<State> state, std::shared_ptr<RealmCoordinator> coordinator);
+    static void compact(Realm::Config const& config);
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_BACKGROUND_COMPACTOR_HPP
@@ -39,11 +39,36 @@ class Table;
 namespace _impl {
 class RealmCoordinator;
 
+// Identifies a single LinkList (or subtable) within a Group
+struct ListKey {
+    size_t table_ndx;
+    size_t col_ndx;
+    size_t row_ndx;
+
+    bool operator==(ListKey const& other) const noexcept
+    {
+        return table_ndx == other.table_ndx && col_ndx == other.col_ndx && row_ndx == other.row_ndx;
+    }
+
+    struct Hash {
+        size_t operator()(ListKey const& key) const noexcept
+        {
+            std::hash<size_t> hash;
+            size_t seed = hash(key.table_ndx);
+            seed ^= hash(key.col_ndx) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            seed ^= hash(key.row_ndx) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            return seed;
+        }
+    };
+};
+
 struct ListChangeInfo {
     size_t table_ndx;
     size_t row_ndx;
     size_t col_ndx;
     CollectionChangeBuilder* changes;
+
+    ListKey key() const noexcept { return {table_ndx, col_ndx, row_ndx}; }
 };
 
 struct TransactionChangeInfo {
@@ -67,9 +92,19 @@ public:
         size_t table_ndx;
         std::vector<OutgoingLink> links;
     };
+    // All of the tables reachable from a root table, with a lookup from table
+    // index to position in `tables`
+    struct RelatedTables {
+        std::vector<RelatedTable> tables;
+        std::vector<size_t> positions;
+
+        RelatedTable const* find(size_t table_ndx) const noexcept;
+
+        static std::shared_ptr<const RelatedTables> make(Table const& root_table);
+    };
 
     DeepChangeChecker(TransactionChangeInfo const& info, Table const& root_table,
-                      std::vector<RelatedTable> const& related_tables);
+                      std::shared_ptr<const RelatedTables> related_tables);
 
     bool operator()(size_t row_ndx);
 
@@ -82,8 +117,10 @@ private:
     Table const& m_root_table;
     const size_t m_root_table_ndx;
     IndexSet const* const m_root_modifications;
-    std::vector<IndexSet> m_not_modified;
-    std::vector<RelatedTable> const& m_related_tables;
+    std::shared_ptr<const RelatedTables> m_related_tables;
+    // Rows known to not be modified, as one bitmap per related table which is
+    // sized to that table the first time a row in it is checked
+    std::vector<std::vector<bool>> m_not_modified;
 
     struct Path {
         size_t table;
@@ -94,7 +131,7 @@ private:
     std::array<Path, 4> m_current_path;
 
     bool check_row(Table const& table, size_t row_ndx, size_t depth = 0);
-    bool check_outgoing_links(size_t table_ndx, Table const& table,
+    bool check_outgoing_links(RelatedTable const& related, Table const& table,
                               size_t row_ndx, size_t depth = 0);
 };
 
@@ -118,7 +155,15 @@ public:
     // Add a callback to be called each time the collection changes
     // This can only be called from the target collection's thread
     // Returns a token which can be passed to remove_callback()
-    uint64_t add_callback(CollectionChangeCallback callback);
+    // If `key_paths` is non-empty, only changes to the properties they reach
+    // are checked for modifications. This is done for the notifier as a whole,
+    // so a callback may also be told about modifications to properties
+    // observed by other callbacks on the same notifier.
+    uint64_t add_callback(CollectionChangeCallback callback, KeyPathArray key_paths = {});
+    // Check that each key path starts at `root_table` and follows its links,
+    // and throw InvalidKeyPathException if not. Must be called on the thread
+    // which owns `root_table` before passing the key paths to add_callback().
+    static void validate_key_paths(Table const& root_table, KeyPathArray const& key_paths);
     // Remove a previously added token. The token is no longer valid after
     // calling this function and must not be used again. This function can be
     // called from any thread.
@@ -209,10 +254,15 @@ private:
 
     VersionID m_sg_version;
     SharedGroup* m_sg = nullptr;
+    std::weak_ptr<RealmCoordinator> m_coordinator;
 
     bool m_has_run = false;
     bool m_error = false;
-    std::vector<DeepChangeChecker::RelatedTable> m_related_tables;
+    std::shared_ptr<const DeepChangeChecker::RelatedTables> m_related_tables;
+
+    // Union of the key paths of all callbacks, or empty if any callback
+    // observes everything. Only accessed on the worker thread.
+    KeyPathArray m_key_paths;
 
     struct Callback {
         CollectionChangeCallback fn;
@@ -221,8 +271,11 @@ private:
         uint64_t token;
         bool initial_delivered;
         bool skip_next;
+        KeyPathArray key_paths;
     };
 
+    void update_key_paths();
+
     // Currently registered callbacks and a mutex which must always be held
     // while doing anything with them or m_callback_index
     std::mutex m_callback_mutex;
@@ -19,6 +19,7 @@
 #ifndef REALM_COORDINATOR_HPP
 #define REALM_COORDINATOR_HPP
 
+#include "impl/collection_notifier.hpp"
 #include "shared_realm.hpp"
 
 #include <realm/version_id.hpp>
@@ -34,9 +35,14 @@ class StringData;
 class SyncSession;
 
 namespace _impl {
+class AsyncWriteQueue;
+class BackgroundCompactor;
 class CollectionNotifier;
 class ExternalCommitHelper;
+class NotifierShardWorker;
+class RetentionEngine;
 class WeakRealmNotifier;
+class WriteBehindFlusher;
 
 namespace partial_sync {
 class WorkQueue;
@@ -64,7 +70,7 @@ public:
     uint64_t get_schema_version() const noexcept { return m_schema_version; }
     const std::string& get_path() const noexcept { return m_config.path; }
     const std::vector<char>& get_encryption_key() const noexcept { return m_config.encryption_key; }
-    bool is_in_memory() const noexcept { return m_config.in_memory; }
+    bool is_in_memory() const noexcept { return m_config.effective_durability() == Durability::MemOnly; }
 
     // To avoid having to re-read and validate the file's schema every time a
     // new read transaction is begun, RealmCoordinator maintains a cache of the
@@ -85,6 +91,26 @@ public:
     void advance_schema_cache(uint64_t previous, uint64_t next);
     void clear_schema_cache_and_set_schema_version(uint64_t new_schema_version);
 
+    // Get the queue which runs Realm::async_write() writes for this path,
+    // creating it if needed
+    AsyncWriteQueue& async_write_queue();
+
+    // Write the latest version of a write-behind Realm to its persistent copy
+    void flush_write_behind();
+
+    // Close the SharedGroups used to run notifiers so that the file can be
+    // compacted. Returns false, without closing anything, if there are any
+    // open Realm instances or notifiers for the file.
+    bool release_for_compaction();
+    // Called by Realm::close() once the Realm's SharedGroup has been closed
+    void did_close_realm();
+
+    // Get the tables reachable via links from `table`, which must be from a
+    // read transaction at `transaction_version`. The result is shared between
+    // all callers for as long as the cached schema is valid.
+    std::shared_ptr<const DeepChangeChecker::RelatedTables> get_related_tables(Table const& table,
+                                                                               uint64_t transaction_version);
+
 
     // Asynchronously call notify() on every Realm instance for this coordinator's
     // path, including those in other processes
@@ -154,6 +180,7 @@ private:
     uint64_t m_schema_version = -1;
     uint64_t m_schema_transaction_version_min = 0;
     uint64_t m_schema_transaction_version_max = 0;
+    std::unordered_map<size_t, std::shared_ptr<const DeepChangeChecker::RelatedTables>> m_related_tables_cache;
 
     std::mutex m_realm_mutex;
     std::vector<WeakRealmNotifier> m_weak_realm_notifiers;
@@ -164,10 +191,21 @@ private:
     std::vector<std::shared_ptr<_impl::CollectionNotifier>> m_notifiers;
     VersionID m_notifier_skip_version = {0, 0};
 
-    // SharedGroup used for actually running async notifiers
-    // Will have a read transaction iff m_notifiers is non-empty
-    std::unique_ptr<Replication> m_notifier_history;
-    std::unique_ptr<SharedGroup> m_notifier_sg;
+    // SharedGroups used for actually running async notifiers. Each notifier
+    // is attached to one of them for its whole life, and notifiers on
+    // different SharedGroups are run concurrently
+    // Each will have a read transaction iff its notifiers is non-empty
+    // The first shard runs on the notifier thread and every other one has a
+    // worker thread of its own which lives as long as the shard
+    struct NotifierShard {
+        std::unique_ptr<Replication> history;
+        std::unique_ptr<SharedGroup> sg;
+        std::vector<std::shared_ptr<_impl::CollectionNotifier>> notifiers;
+        std::unique_ptr<NotifierShardWorker> worker;
+    };
+    std::vector<NotifierShard> m_notifier_shards;
+    // Set while run_async_notifiers() uses the shards without holding the lock
+    bool m_running_notifiers = false;
 
     // SharedGroup used to advance notifiers in m_new_notifiers to the main shared
     // group's transaction version
@@ -176,9 +214,33 @@ private:
     std::unique_ptr<SharedGroup> m_advancer_sg;
     std::exception_ptr m_async_error;
 
+    // Throttling of notification delivery for Config::notification_interval.
+    // After running the notifiers, on_change() waits on m_throttle_cv until the
+    // interval since the previous delivery has passed before waking up the
+    // Realms. It runs the notifiers again in the meantime if another thread
+    // is waiting for them to catch up to a newer version.
+    std::mutex m_throttle_mutex;
+    std::condition_variable m_throttle_cv;
+    std::chrono::steady_clock::time_point m_last_delivery;
+    bool m_catch_up_requested = false;
+    bool m_skip_throttle = false;
+
     std::unique_ptr<_impl::ExternalCommitHelper> m_notifier;
     std::function<void(VersionID, VersionID)> m_transaction_callback;
 
+    std::mutex m_async_write_mutex;
+    std::unique_ptr<_impl::AsyncWriteQueue> m_async_write_queue;
+
+    // Only set if Config::write_behind_path is, and created with the first Realm
+    std::unique_ptr<_impl::WriteBehindFlusher> m_write_behind_flusher;
+
+    // Only set if Config::retention_policies is, and created with the first Realm
+    std::unique_ptr<_impl::RetentionEngine> m_retention_engine;
+
+    // Only set if Config::background_compaction is, and created with the first Realm
+    std::unique_ptr<_impl::BackgroundCompactor> m_compactor;
+    void check_compaction_thresholds(SharedGroup& sg);
+
 #if REALM_ENABLE_SYNC
     std::shared_ptr<SyncSession> m_sync_session;
     std::unique_ptr<partial_sync::WorkQueue> m_partial_sync_work_queue;
@@ -191,7 +253,16 @@ private:
     void create_sync_session();
 
     void run_async_notifiers();
+    bool wait_for_notification_interval();
+    void request_notifier_catch_up();
+    void skip_notification_interval();
+    void run_notifier_shard(NotifierShard&, std::vector<std::shared_ptr<_impl::CollectionNotifier>> notifiers,
+                            std::vector<std::shared_ptr<_impl::CollectionNotifier>> new_notifiers,
+                            VersionID version, VersionID skip_version);
     void open_helper_shared_group();
+    size_t notifier_shards_needed() const;
+    std::vector<NotifierShard> open_notifier_shards(size_t count);
+    size_t shard_for_new_notifier(std::vector<size_t>& shard_sizes);
     void advance_helper_shared_group_to_latest();
     void clean_up_dead_notifiers();
 
@@ -208,6 +279,7 @@ std::unique_lock<std::mutex> RealmCoordinator::wait_for_notifiers(Pred&& wait_pr
         if (wait_predicate())
             return true;
         if (first) {
+            request_notifier_catch_up();
             wake_up_notifier_worker();
             first = false;
         }
@@ -50,6 +50,12 @@ private:
     TableView m_tv;
     std::unique_ptr<SharedGroup::Handover<TableView>> m_tv_handover;
     std::unique_ptr<SharedGroup::Handover<TableView>> m_tv_to_deliver;
+    // A copy of the last TableView handed over, which a run where rows were
+    // only appended to the table adds the new matches to
+    std::unique_ptr<SharedGroup::Handover<TableView>> m_previous_tv;
+
+    // The SharedGroup the query is attached to, or null if it's in handover form
+    SharedGroup* m_sg = nullptr;
 
     // The table version from the last time the query was run. Used to avoid
     // rerunning the query when there's no chance of it changing.
@@ -58,11 +64,21 @@ private:
     // The rows from the previous run of the query, for calculating diffs
     std::vector<size_t> m_previous_rows;
 
+    // True if the query is unsorted, not restricted to a view and on a table
+    // with no links in either direction, so that when a commit only appends
+    // rows to the table the only possible change is new matches at the end
+    bool m_appends_only_insert = false;
+    // The table's size the last time the query was run
+    size_t m_last_table_size = 0;
+
     // The changeset calculated during run() and delivered in do_prepare_handover()
     CollectionChangeBuilder m_changes;
     TransactionChangeInfo* m_info = nullptr;
 
     bool need_to_run();
+    bool only_rows_appended();
+    void append_rows();
+    void append_changes();
     void calculate_changes();
     void deliver(SharedGroup&) override;
 
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_RETENTION_ENGINE_HPP
+#define REALM_RETENTION_ENGINE_HPP
+
+#include "shared_realm.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace realm {
+namespace _impl {
+// RetentionEngine enforces Config::retention_policies on a background thread
+// every retention_interval. Each pass works out the oldest time to keep for
+// each policy in a read transaction, and then deletes everything older in
+// write transactions of at most retention_batch_size objects each, pausing
+// for retention_throttle between them so that other writers aren't starved.
+//
+// Like AsyncWriteQueue, the thread only opens a Realm while it's doing a pass,
+// so it never keeps the file or the RealmCoordinator which owns it open.
+class RetentionEngine {
+public:
+    // Starts the background thread
+    RetentionEngine(Realm::Config config);
+    // Stops the background thread, abandoning the rest of a pass in progress
+    ~RetentionEngine();
+
+    // Enforce `policies` on `realm`, which must not be in a write transaction,
+    // and return the number of objects deleted. `between_batches` is called
+    // after each write transaction other than the last, and stops enforcement
+    // early if it returns false.
+    static size_t enforce(Realm& realm, std::vector<RetentionPolicy> const& policies, size_t batch_size,
+                          std::function<bool()> const& between_batches = nullptr);
+
+private:
+    // Shared with the background thread, which may outlive the engine when
+    // the last reference to the coordinator is released on that thread
+    struct State {
+        Realm::Config config;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stop = false;
+    };
+
+    std::shared_ptr<State> m_state;
+    std::thread m_thread;
+
+    static void run(std::shared_ptr<State> state);
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_RETENTION_ENGINE_HPP
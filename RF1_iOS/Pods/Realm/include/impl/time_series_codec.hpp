@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_TIME_SERIES_CODEC_HPP
+#define REALM_TIME_SERIES_CODEC_HPP
+
+#include <realm/binary_data.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace realm {
+namespace _impl {
+namespace time_series {
+// The encoding used for each column of a TimeSeries chunk. A stream starts with
+// the most recently appended value as a little-endian int64, so that appending
+// doesn't require decoding the stream, followed by the difference between each
+// value and the one before it (with the first relative to zero) as a zigzag
+// varint. Slowly-changing sensor values and regularly-spaced time keys mostly
+// encode to a single byte each.
+
+// Create an empty stream in `stream`
+void init_stream(std::vector<char>& stream);
+
+// Get the last value appended to a stream, or zero for an empty stream
+int64_t last_value(BinaryData stream) noexcept;
+
+// Append `count` values to the stream
+void append_values(std::vector<char>& stream, const int64_t* values, size_t count);
+
+// Decode the first `count` values in a stream into `out`. Throws
+// std::runtime_error if the stream is shorter than that.
+void decode_values(BinaryData stream, size_t count, int64_t* out);
+
+} // namespace time_series
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_TIME_SERIES_CODEC_HPP
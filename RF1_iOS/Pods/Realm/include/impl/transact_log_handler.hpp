@@ -27,6 +27,7 @@
 
 namespace realm {
 class BindingContext;
+class Replication;
 class SharedGroup;
 
 namespace _impl {
@@ -58,6 +59,11 @@ void cancel(SharedGroup& sg, BindingContext* binding_context);
 
 // Advance the read transaction version, with change information gathered in info
 void advance(SharedGroup& sg, TransactionChangeInfo& info, VersionID version=VersionID{});
+
+// Gather change information for the changes made so far in the current write
+// transaction into info, without committing or rolling back. Throws
+// UnsupportedSchemaChange if the write transaction modifies the schema.
+void collect_uncommitted_changes(Replication& history, TransactionChangeInfo& info);
 } // namespace transaction
 } // namespace _impl
 } // namespace realm
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_WRITE_BEHIND_FLUSHER_HPP
+#define REALM_WRITE_BEHIND_FLUSHER_HPP
+
+#include "shared_realm.hpp"
+
+#include <realm/version_id.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace realm {
+class Replication;
+class SharedGroup;
+
+namespace _impl {
+// WriteBehindFlusher implements Config::write_behind_path: it periodically
+// writes a snapshot of the latest version of an in-memory Realm to a file on
+// disk, so that the live Realm never has to wait for the disk while the
+// persistent copy lags behind it by at most the flush interval.
+//
+// The flusher holds its own SharedGroup rather than a Realm so that it does
+// not keep the RealmCoordinator alive, and so that the in-memory file is still
+// open for the final flush when the coordinator is destroyed. It is created
+// before the first Realm for the path is opened, so that it can load the
+// persistent copy into the still-empty in-memory Realm.
+class WriteBehindFlusher {
+public:
+    // Opens the in-memory Realm at config.path, loads the persistent copy into
+    // it if the in-memory Realm is empty, and starts the flusher thread. Throws
+    // if the copy can't be loaded, leaving the copy untouched.
+    WriteBehindFlusher(Realm::Config const& config);
+    // Stops the flusher thread and flushes any remaining changes
+    ~WriteBehindFlusher();
+
+    // Write the latest version to the persistent copy if it has changed since
+    // the previous flush. Errors on the flusher thread are ignored and the
+    // flush retried at the next interval, but errors here are thrown.
+    void flush();
+
+private:
+    const std::string m_path;
+    const std::string m_tmp_path;
+    const std::vector<char> m_encryption_key;
+    const std::chrono::milliseconds m_interval;
+
+    // Guards the SharedGroup and m_flushed_version
+    std::mutex m_flush_mutex;
+    std::unique_ptr<Replication> m_history;
+    std::unique_ptr<SharedGroup> m_shared_group;
+    VersionID m_flushed_version;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    void load();
+    void run();
+};
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_WRITE_BEHIND_FLUSHER_HPP
@@ -117,7 +117,9 @@ public:
 
     bool operator==(List const& rgt) const noexcept;
 
-    NotificationToken add_notification_callback(CollectionChangeCallback cb) &;
+    // If `key_paths` is non-empty, modifications are only reported for the
+    // properties reachable via the given key paths
+    NotificationToken add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths = {}) &;
 
     template<typename Context>
     auto get(Context&, size_t row_ndx) const;
@@ -0,0 +1,349 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_OBJECT_CREATOR_HPP
+#define REALM_OS_OBJECT_CREATOR_HPP
+
+#include "object.hpp"
+#include "object_schema.hpp"
+#include "object_store.hpp"
+#include "property.hpp"
+#include "schema.hpp"
+#include "shared_realm.hpp"
+
+#include <realm/table.hpp>
+#include <realm/util/optional.hpp>
+
+#if REALM_ENABLE_SYNC
+#include <realm/sync/object.hpp>
+#endif // REALM_ENABLE_SYNC
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace realm {
+// ObjectCreator is a precompiled plan for creating objects of one type from
+// positional values, for code which creates many objects of the same type
+// with statically-typed values (such as log entries). The property names are
+// resolved to table columns and checked against the C++ value types when the
+// creator is constructed, and again only if the Realm's schema changes, so
+// create() is just a row insertion followed by one typed setter call per
+// value, with no per-property name lookups or boxing through an accessor
+// context as with Object::create().
+//
+// The value types can be any integral type, bool, float, double, StringData,
+// std::string, BinaryData or Timestamp, or util::Optional of one of those for
+// optional properties. There are no default values, so every property which
+// isn't optional or a list has to be listed. Optional properties which aren't
+// listed are null, and lists are empty. Link and list properties can't be set.
+//
+// A creator is tied to the Realm instance it was created with, and should be
+// created once and reused for each object:
+//
+//     ObjectCreator<int64_t, int64_t, int64_t> create_sample(realm, "FSRData",
+//         {"sampleIndex", "forefootVoltageData", "heelVoltageData"});
+//     realm->begin_transaction();
+//     for (auto& sample : samples)
+//         create_sample.create(sample.index, sample.forefoot, sample.heel);
+//     realm->commit_transaction();
+template<typename... Ts>
+class ObjectCreator {
+public:
+    // Throws std::logic_error if `object_type` or one of `properties` doesn't
+    // exist, if a property's type doesn't match the corresponding value type,
+    // or if the type has a primary key which isn't in `properties`, and
+    // MissingPropertyValueException if a required property isn't listed
+    ObjectCreator(std::shared_ptr<Realm> realm, StringData object_type,
+                  std::array<StringData, sizeof...(Ts)> const& properties);
+
+    // Create an object with the given property values. Must be called in a
+    // write transaction. Throws std::logic_error if an object with the same
+    // primary key already exists, or the same as the constructor if the schema
+    // has changed so that the properties are no longer valid.
+    Object create(Ts const&... values);
+    Object create(std::tuple<Ts...> const& values);
+
+private:
+    std::shared_ptr<Realm> m_realm;
+    std::string m_object_type;
+    std::array<std::string, sizeof...(Ts)> m_property_names;
+
+    // Resolved from the schema with the generation m_schema_generation. The
+    // ObjectSchema is the Realm's own, as the created Objects refer to it.
+    uint64_t m_schema_generation;
+    ObjectSchema const* m_object_schema;
+    TableRef m_table;
+    std::array<size_t, sizeof...(Ts)> m_columns;
+    // Index in m_columns of the primary key, or -1 if there isn't one
+    size_t m_primary_key;
+#if REALM_ENABLE_SYNC
+    // Looking up the table's object ID column for each object would otherwise
+    // mean building a cache for the whole group per object
+    std::unique_ptr<sync::TableInfoCache> m_table_info;
+#endif // REALM_ENABLE_SYNC
+
+    void resolve();
+    template<size_t... Is>
+    Object create(std::tuple<Ts const&...> const& values, std::index_sequence<Is...>);
+    template<typename T>
+    size_t create_with_primary_key(T const& value);
+    size_t create_row();
+};
+
+namespace _impl {
+namespace object_creator {
+// The property type (without flags) which values of type T are stored in, and
+// whether T is a util::Optional, which can only be used for optional properties
+template<typename T, typename = void>
+struct ValueTraits;
+
+template<typename T>
+struct ValueTraits<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> {
+    static constexpr PropertyType type = PropertyType::Int;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<bool> {
+    static constexpr PropertyType type = PropertyType::Bool;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<float> {
+    static constexpr PropertyType type = PropertyType::Float;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<double> {
+    static constexpr PropertyType type = PropertyType::Double;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<StringData> {
+    static constexpr PropertyType type = PropertyType::String;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<std::string> {
+    static constexpr PropertyType type = PropertyType::String;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<BinaryData> {
+    static constexpr PropertyType type = PropertyType::Data;
+    static constexpr bool optional = false;
+};
+template<> struct ValueTraits<Timestamp> {
+    static constexpr PropertyType type = PropertyType::Date;
+    static constexpr bool optional = false;
+};
+template<typename T>
+struct ValueTraits<util::Optional<T>> {
+    static constexpr PropertyType type = ValueTraits<T>::type;
+    static constexpr bool optional = true;
+};
+
+template<typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>
+set(Table& table, size_t col, size_t row, T value) { table.set_int(col, row, int64_t(value)); }
+inline void set(Table& table, size_t col, size_t row, bool value) { table.set_bool(col, row, value); }
+inline void set(Table& table, size_t col, size_t row, float value) { table.set_float(col, row, value); }
+inline void set(Table& table, size_t col, size_t row, double value) { table.set_double(col, row, value); }
+inline void set(Table& table, size_t col, size_t row, StringData value) { table.set_string(col, row, value); }
+inline void set(Table& table, size_t col, size_t row, std::string const& value) { table.set_string(col, row, value); }
+inline void set(Table& table, size_t col, size_t row, BinaryData value) { table.set_binary(col, row, value); }
+inline void set(Table& table, size_t col, size_t row, Timestamp value) { table.set_timestamp(col, row, value); }
+template<typename T>
+void set(Table& table, size_t col, size_t row, util::Optional<T> const& value)
+{
+    if (value)
+        set(table, col, row, *value);
+    else
+        table.set_null(col, row);
+}
+
+// Primary keys are either ints or strings. Other types are rejected when the
+// creator is constructed.
+template<typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, util::Optional<int64_t>>
+primary_key(T const& value) { return int64_t(value); }
+template<typename T>
+std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, util::Optional<int64_t>>
+primary_key(util::Optional<T> const& value) { return value ? util::make_optional(int64_t(*value)) : util::none; }
+inline StringData primary_key(StringData value) { return value; }
+inline StringData primary_key(std::string const& value) { return value; }
+inline StringData primary_key(util::Optional<std::string> const& value) { return value ? StringData(*value) : StringData(); }
+inline StringData primary_key(util::Optional<StringData> const& value) { return value ? *value : StringData(); }
+template<typename T>
+std::enable_if_t<!std::is_integral<T>::value || std::is_same<T, bool>::value, int64_t>
+primary_key(T const&) { REALM_UNREACHABLE(); }
+
+inline size_t find(Table& table, size_t col, util::Optional<int64_t> key)
+{
+    return key ? table.find_first_int(col, *key) : table.find_first_null(col);
+}
+inline size_t find(Table& table, size_t col, StringData key)
+{
+    return key.is_null() ? table.find_first_null(col) : table.find_first_string(col, key);
+}
+inline size_t find(Table&, size_t, int64_t) { REALM_UNREACHABLE(); }
+
+inline void set_unique(Table& table, size_t col, size_t row, util::Optional<int64_t> key)
+{
+    if (key)
+        table.set_unique(col, row, *key);
+    else
+        table.set_null_unique(col, row);
+}
+inline void set_unique(Table& table, size_t col, size_t row, StringData key)
+{
+    table.set_unique(col, row, key);
+}
+inline void set_unique(Table&, size_t, size_t, int64_t) { REALM_UNREACHABLE(); }
+
+inline std::string describe(util::Optional<int64_t> key) { return key ? util::format("%1", *key) : "null"; }
+inline std::string describe(StringData key) { return key.is_null() ? "null" : std::string(key); }
+inline std::string describe(int64_t) { REALM_UNREACHABLE(); }
+} // namespace object_creator
+} // namespace _impl
+
+template<typename... Ts>
+ObjectCreator<Ts...>::ObjectCreator(std::shared_ptr<Realm> realm, StringData object_type,
+                                    std::array<StringData, sizeof...(Ts)> const& properties)
+: m_realm(std::move(realm))
+, m_object_type(object_type)
+{
+    for (size_t i = 0; i < properties.size(); ++i)
+        m_property_names[i] = properties[i];
+    resolve();
+}
+
+template<typename... Ts>
+void ObjectCreator<Ts...>::resolve()
+{
+    using namespace _impl::object_creator;
+    auto it = m_realm->schema().find(m_object_type);
+    if (it == m_realm->schema().end())
+        throw std::logic_error(util::format("Object type '%1' not found in schema.", m_object_type));
+    auto& object_schema = *it;
+
+    const PropertyType types[] = {ValueTraits<Ts>::type..., PropertyType::Int};
+    const bool optional[] = {ValueTraits<Ts>::optional..., false};
+
+    m_table = ObjectStore::table_for_object_type(m_realm->read_group(), m_object_type);
+#if REALM_ENABLE_SYNC
+    // Refers to tables by index, so has to be rebuilt if the schema changes
+    m_table_info = std::make_unique<sync::TableInfoCache>(m_realm->read_group());
+#endif // REALM_ENABLE_SYNC
+    m_primary_key = -1;
+    for (size_t i = 0; i < m_property_names.size(); ++i) {
+        auto& name = m_property_names[i];
+        auto prop = object_schema.property_for_name(name);
+        if (!prop)
+            throw std::logic_error(util::format("Property '%1.%2' does not exist", m_object_type, name));
+        if (is_array(prop->type) || (prop->type & ~PropertyType::Flags) != types[i])
+            throw std::logic_error(util::format("Property '%1.%2' of type '%3' cannot be set from a value of type '%4'",
+                                                m_object_type, name, string_for_property_type(prop->type),
+                                                string_for_property_type(types[i])));
+        if (optional[i] && !is_nullable(prop->type))
+            throw std::logic_error(util::format("Property '%1.%2' is not optional", m_object_type, name));
+        if (prop->is_primary)
+            m_primary_key = i;
+        m_columns[i] = prop->table_column;
+    }
+
+    if (m_primary_key == size_t(-1) && object_schema.primary_key_property())
+        throw std::logic_error(util::format("Creating '%1' objects requires a value for its primary key '%2'",
+                                            m_object_type, object_schema.primary_key));
+
+    // Object::create() requires the same, unless the binding supplies a default
+    for (auto& prop : object_schema.persisted_properties) {
+        if (is_nullable(prop.type) || is_array(prop.type))
+            continue;
+        if (std::find(m_property_names.begin(), m_property_names.end(), prop.name) == m_property_names.end())
+            throw MissingPropertyValueException(m_object_type, prop.name);
+    }
+
+    m_object_schema = &object_schema;
+    m_schema_generation = m_realm->schema_generation();
+}
+
+template<typename... Ts>
+Object ObjectCreator<Ts...>::create(Ts const&... values)
+{
+    return create(std::tuple<Ts const&...>(values...), std::index_sequence_for<Ts...>());
+}
+
+template<typename... Ts>
+Object ObjectCreator<Ts...>::create(std::tuple<Ts...> const& values)
+{
+    return create(std::tuple<Ts const&...>(values), std::index_sequence_for<Ts...>());
+}
+
+template<typename... Ts>
+template<size_t... Is>
+Object ObjectCreator<Ts...>::create(std::tuple<Ts const&...> const& values, std::index_sequence<Is...>)
+{
+    using namespace _impl::object_creator;
+    m_realm->verify_in_write();
+    if (m_realm->schema_generation() != m_schema_generation)
+        resolve();
+
+    size_t row = npos;
+    if (m_primary_key == size_t(-1))
+        row = create_row();
+    else
+        static_cast<void>(std::initializer_list<int>{
+            (Is == m_primary_key ? (row = create_with_primary_key(std::get<Is>(values)), 0) : 0)...});
+
+    static_cast<void>(std::initializer_list<int>{
+        (Is != m_primary_key ? (set(*m_table, m_columns[Is], row, std::get<Is>(values)), 0) : 0)...});
+    return Object(m_realm, *m_object_schema, m_table->get(row));
+}
+
+template<typename... Ts>
+size_t ObjectCreator<Ts...>::create_row()
+{
+#if REALM_ENABLE_SYNC
+    return sync::create_object(*m_table_info, *m_table);
+#else
+    return m_table->add_empty_row();
+#endif // REALM_ENABLE_SYNC
+}
+
+template<typename... Ts>
+template<typename T>
+size_t ObjectCreator<Ts...>::create_with_primary_key(T const& value)
+{
+    using namespace _impl::object_creator;
+    auto key = primary_key(value);
+    size_t col = m_columns[m_primary_key];
+    if (find(*m_table, col, key) != npos)
+        throw std::logic_error(util::format("Attempting to create an object of type '%1' with an existing primary key value '%2'.",
+                                            m_object_type, describe(key)));
+
+#if REALM_ENABLE_SYNC
+    return sync::create_object_with_primary_key(*m_table_info, *m_table, key);
+#else
+    size_t row = m_table->add_empty_row();
+    set_unique(*m_table, col, row, key);
+    return row;
+#endif // REALM_ENABLE_SYNC
+}
+
+} // namespace realm
+
+#endif // REALM_OS_OBJECT_CREATOR_HPP
@@ -25,6 +25,7 @@
 #include <realm/util/optional.hpp>
 
 #include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 namespace realm {
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_PREPARED_QUERY_HPP
+#define REALM_OS_PREPARED_QUERY_HPP
+
+#include <realm/parser/parser.hpp>
+#include <realm/util/any.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace realm {
+class Query;
+class Realm;
+class Results;
+
+// A query string in core's query language (see realm/parser/parser.hpp),
+// parsed once and then run any number of times with different arguments.
+//
+// Parsing is the expensive part of running a string query, and the parse tree
+// doesn't depend on the Realm or thread it's used with, so prepared queries
+// are shared process-wide: get() returns the cached PreparedQuery for a given
+// object type and query text, which can be used from any thread. The Query
+// objects built from it are tied to a Realm instance like any other Query, so
+// a new one is built from the parse tree for each call, which only costs
+// resolving the key paths and binding the arguments.
+//
+// Arguments are referred to positionally in the query text as $0, $1 etc, and
+// bound from a vector of util::Any holding values of the core types:
+// bool, int64_t, float, double, StringData, BinaryData, Timestamp, RowExpr,
+// or realm::null.
+class PreparedQuery {
+public:
+    // Get the prepared query for `text` on `object_type`, parsing it if it
+    // isn't already in the cache. Throws the parser's exception if the text
+    // isn't a valid query. The most recently used queries are kept, up to a
+    // fixed number.
+    static std::shared_ptr<PreparedQuery const> get(std::string const& object_type, std::string const& text);
+    // Remove all cached queries. Prepared queries which are still referenced
+    // remain usable.
+    static void clear_cache();
+
+    std::string const& get_object_type() const noexcept { return m_object_type; }
+    std::string const& get_text() const noexcept { return m_text; }
+
+    // Build a Query on `realm` with `arguments` bound to the query's
+    // placeholders. Throws std::logic_error if the object type isn't in the
+    // Realm, std::out_of_range if there are too few arguments, and the query
+    // builder's exceptions for invalid key paths or argument types. Any
+    // SORT, DISTINCT or LIMIT clauses are ignored; use results() for those.
+    Query query(Realm& realm, std::vector<util::Any> const& arguments = {}) const;
+    // As query(), with the SORT, DISTINCT and LIMIT clauses applied
+    Results results(std::shared_ptr<Realm> const& realm, std::vector<util::Any> const& arguments = {}) const;
+
+    // Parse `text` without going through the cache
+    PreparedQuery(std::string object_type, std::string text);
+
+private:
+    const std::string m_object_type;
+    const std::string m_text;
+    const parser::ParserResult m_parsed;
+};
+
+} // namespace realm
+
+#endif // REALM_OS_PREPARED_QUERY_HPP
@@ -115,6 +115,13 @@ public:
     // Throws InvalidTransactionException if not in a write transaction
     void clear();
 
+    // Delete the rows in this Results which also match `q` from the Realm,
+    // and return the number deleted. The rows are found with a single
+    // unsorted query and removed together, so this is much faster than
+    // filtering and then deleting objects one at a time.
+    // Throws InvalidTransactionException if not in a write transaction
+    size_t delete_matching(Query&& q);
+
     // Create a new Results by further filtering or sorting this Results
     Results filter(Query&& q) const;
     Results sort(SortDescriptor&& sort) const;
@@ -210,7 +217,9 @@ public:
     // and then rerun after each commit (if needed) and redelivered if it changed
     template<typename Func>
     NotificationToken async(Func&& target);
-    NotificationToken add_notification_callback(CollectionChangeCallback cb) &;
+    // If `key_paths` is non-empty, modifications are only reported for the
+    // properties reachable via the given key paths
+    NotificationToken add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths = {}) &;
 
     bool wants_background_updates() const { return m_wants_background_updates; }
 
@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_RETENTION_HPP
+#define REALM_OS_RETENTION_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace realm {
+
+// A limit on how much of an object type's data is kept, for raw data such as
+// sensor samples which only needs to be kept for a while. The oldest objects
+// by time_property are deleted until all of the set limits are met. Ages are
+// measured from the newest object rather than from the wall clock, so
+// time_property can be any non-decreasing key such as a sample index, and
+// max_age is in the same units as it.
+//
+// Policies listed in Realm::Config::retention_policies are enforced on a
+// background thread (see Config::retention_interval), or immediately with
+// Realm::enforce_retention(). Rollups of the object type (see rollup.hpp) keep
+// their summaries of the deleted objects.
+struct RetentionPolicy {
+    std::string object_type;
+    // A non-optional Int property of object_type
+    std::string time_property;
+
+    // Zero for no limit. Objects which share a time with the oldest object
+    // which is kept are kept too, so max_count and max_bytes can be exceeded
+    // slightly if times repeat.
+    int64_t max_age = 0;
+    size_t max_count = 0;
+    // Measured as the size of the type's table within the file
+    uint64_t max_bytes = 0;
+};
+
+} // namespace realm
+
+#endif // REALM_OS_RETENTION_HPP
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_ROLLUP_HPP
+#define REALM_OS_ROLLUP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace realm {
+class Group;
+class ObjectSchema;
+class Realm;
+class Replication;
+
+// A rollup is an object type holding per-interval aggregates of the objects
+// of another type, with one object per interval ("bucket") which has any
+// source objects in it. Each source object is added to the bucket starting at
+// floor(time / bucket_width) * bucket_width, where `time` is the value of its
+// time_property.
+//
+// Rollups listed in Realm::Config::rollups are updated as part of each write
+// transaction which creates source objects, from that transaction's log, so
+// they never lag behind the source data and cost O(new objects) to maintain.
+// Modifying or deleting source objects does not change the rollup: rollups
+// are meant for append-only data such as sensor logs, and keeping the
+// summaries of raw data which has been aged out is intentional. Use
+// Rollup::rebuild() to recompute a rollup from the current source objects.
+struct RollupDefinition {
+    enum class Function : uint8_t {
+        Sum,
+        Min,
+        Max,
+    };
+
+    struct Aggregate {
+        // An Int, Float or Double property of the source type
+        std::string property;
+        Function function;
+    };
+
+    // The object type holding the buckets, created from Rollup::object_schema()
+    std::string name;
+    std::string source_type;
+    // An Int property of the source type
+    std::string time_property;
+    int64_t bucket_width = 0;
+    std::vector<Aggregate> aggregates;
+};
+
+// One bucket of a rollup, with `values` in the same order as the definition's
+// aggregates
+struct RollupBucket {
+    int64_t start;
+    int64_t count;
+    std::vector<double> values;
+};
+
+class Rollup {
+public:
+    // Get the schema for the rollup object type of `definition`, which has an
+    // indexed Int "bucket" property with the start of the bucket, an Int
+    // "count" property, and one property per aggregate named by column_name().
+    // `source_schema` is needed to pick the types of the aggregate properties.
+    static ObjectSchema object_schema(RollupDefinition const& definition, ObjectSchema const& source_schema);
+
+    // "<property>_sum", "<property>_min" or "<property>_max"
+    static std::string column_name(RollupDefinition::Aggregate const& aggregate);
+
+    // Recompute the rollup from all of the current source objects. Must be
+    // called in a write transaction.
+    static void rebuild(Realm& realm, RollupDefinition const& definition);
+
+    // Read the buckets with begin <= start < end, merged into buckets of
+    // `width`, which must be a multiple of the definition's bucket width (or
+    // zero to use the definition's bucket width). The cost is proportional to
+    // the number of stored buckets in the range, not the number of source
+    // objects.
+    static std::vector<RollupBucket> read(Realm& realm, RollupDefinition const& definition,
+                                          int64_t begin, int64_t end, int64_t width = 0);
+
+    // Fold the source objects created by the current write transaction into
+    // the rollups. Called by RealmCoordinator just before committing.
+    static void update(Group& group, Replication& history, std::vector<RollupDefinition> const& rollups);
+};
+
+} // namespace realm
+
+#endif // REALM_OS_ROLLUP_HPP
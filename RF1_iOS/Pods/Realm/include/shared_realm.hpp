@@ -20,7 +20,10 @@
 #define REALM_REALM_HPP
 
 #include "execution_context_id.hpp"
+#include "retention.hpp"
+#include "rollup.hpp"
 #include "schema.hpp"
+#include "util/copy_stream.hpp"
 
 #include <realm/util/optional.hpp>
 #include <realm/binary_data.hpp>
@@ -29,7 +32,11 @@
 #include <realm/sync/client.hpp>
 #endif
 
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <unordered_map>
 
 namespace realm {
 class BindingContext;
@@ -136,6 +143,21 @@ enum class SchemaMode : uint8_t {
     Manual
 };
 
+// How commits are made durable on disk
+enum class Durability : uint8_t {
+    // Every commit is synced to disk before commit_transaction() returns
+    Full,
+    // Equivalent to Config::in_memory: the file is only used as backing
+    // storage, is never synced, and is deleted when the last instance of
+    // the Realm is closed
+    MemOnly,
+    // Commits are not synced on commit; a background daemon syncs them
+    // later. A crash may lose the most recent commits, but will not
+    // corrupt the file. Requires core's async commit daemon, which is not
+    // available on iOS, watchOS, tvOS, Android or Windows.
+    Async
+};
+
 enum class ComputedPrivileges : uint8_t {
     None = 0,
 
@@ -181,6 +203,42 @@ public:
     // because it's not crash safe! It may corrupt your database if something fails
     using ShouldCompactOnLaunchFunction = std::function<bool (uint64_t total_bytes, uint64_t used_bytes)>;
 
+    // The outcome of Realm::compact_if_needed()
+    enum class CompactionResult : uint8_t {
+        // The file doesn't exist, or is below Config::compaction_min_size or
+        // Config::compaction_free_ratio
+        NotNeeded,
+        // The file was compacted
+        Compacted,
+        // The file is open, in this process or another one, so it was left
+        // as it is
+        FileInUse
+    };
+
+    // Passed to Config::background_compaction_function as a background
+    // compaction progresses
+    struct BackgroundCompactionEvent {
+        enum class Kind : uint8_t {
+            // The file is about to be compacted. file_size is its current size.
+            Started,
+            // The file was compacted. file_size is its new size.
+            Finished,
+            // The file was opened again before it could be compacted, either
+            // in this process or another one, or no longer needed compacting.
+            // It'll be retried the next time a commit leaves it past the
+            // thresholds.
+            Skipped,
+            // Compaction failed with `error`
+            Failed
+        };
+        Kind kind;
+        std::string path;
+        uint64_t file_size = 0;
+        uint64_t bytes_reclaimed = 0;
+        std::exception_ptr error;
+    };
+    using BackgroundCompactionFunction = std::function<void (BackgroundCompactionEvent const&)>;
+
     struct Config {
         // Path and binary data are mutually exclusive
         std::string path;
@@ -189,6 +247,8 @@ public:
         std::vector<char> encryption_key;
 
         bool in_memory = false;
+        // Setting in_memory is equivalent to setting this to MemOnly
+        Durability durability = Durability::Full;
         SchemaMode schema_mode = SchemaMode::Automatic;
 
         // Optional schema for the file.
@@ -212,10 +272,44 @@ public:
         // because it's not crash safe! It may corrupt your database if something fails
         ShouldCompactOnLaunchFunction should_compact_on_launch_function;
 
+        // Thresholds for compact_if_needed() and background compaction: the
+        // file is compacted if it is at least compaction_min_size bytes and at
+        // least compaction_free_ratio of it is free. A ratio of zero compacts
+        // whenever the file is at least the minimum size. They have no effect
+        // on opening the Realm.
+        double compaction_free_ratio = 0;
+        uint64_t compaction_min_size = 0;
+
+        // If set, a commit which leaves the file past the compaction
+        // thresholds schedules it to be compacted on a background thread once
+        // every Realm instance for it in this process has been closed, rather
+        // than blocking the next launch. background_compaction_function is
+        // called on that thread with the progress and the bytes reclaimed.
+        // Only the values from the first Realm opened for a path are used.
+        bool background_compaction = false;
+        BackgroundCompactionFunction background_compaction_function;
+
+        // Rollups to keep up to date as objects of their source types are
+        // created (see rollup.hpp). The object type of each rollup must be in
+        // the schema. Only the rollups from the first Realm opened for a path
+        // are used.
+        std::vector<RollupDefinition> rollups;
+
+        // Retention policies to enforce in the background (see retention.hpp).
+        // Every retention_interval, objects outside the policies' limits are
+        // deleted in write transactions of at most retention_batch_size
+        // objects, with a pause of retention_throttle between transactions.
+        // Only the values from the first Realm opened for a path are used.
+        std::vector<RetentionPolicy> retention_policies;
+        std::chrono::milliseconds retention_interval{60000};
+        size_t retention_batch_size = 10000;
+        std::chrono::milliseconds retention_throttle{10};
+
         // WARNING: The original read_only() has been renamed to immutable().
         bool immutable() const { return schema_mode == SchemaMode::Immutable; }
         // FIXME: Rename this to read_only().
         bool read_only_alternative() const { return schema_mode == SchemaMode::ReadOnlyAlternative; }
+        Durability effective_durability() const { return in_memory ? Durability::MemOnly : durability; }
 
         // The following are intended for internal/testing purposes and
         // should not be publicly exposed in binding APIs
@@ -235,6 +329,32 @@ public:
         // speeds up tests that don't need notifications.
         bool automatic_change_notifications = true;
 
+        // Minimum time between deliveries of change notifications by the
+        // background notifier. Commits made within the interval are coalesced,
+        // so that each notification callback is called once with the changes
+        // from all of them rather than once per commit. Notifications are
+        // still delivered right away when a Realm is refreshed or begins a
+        // write transaction. Zero delivers after every commit. Only the value
+        // from the first Realm opened for a path is used.
+        std::chrono::milliseconds notification_interval{0};
+
+        // Writes queued with async_write() are committed together once this
+        // many are waiting, or once the oldest of them has waited for
+        // async_write_max_latency, whichever comes first
+        size_t async_write_batch_size = 1000;
+        std::chrono::milliseconds async_write_max_latency{10};
+
+        // Write-behind mode for in-memory Realms: if set, a snapshot of the
+        // Realm is written to this path every write_behind_interval (when
+        // there have been changes), on flush_write_behind(), and when the last
+        // instance of the Realm is closed. Reads, writes and notifications
+        // all use the in-memory Realm, so at most the changes from the last
+        // interval are lost on a crash. When the in-memory Realm is first
+        // opened the persistent copy is loaded into it, and opening fails
+        // without touching the copy if it can't be loaded.
+        std::string write_behind_path;
+        std::chrono::milliseconds write_behind_interval{1000};
+
         // The identifier of the abstract execution context in which this Realm will be used.
         // If unset, the current thread's identifier will be used to identify the execution context.
         util::Optional<AbstractExecutionContextID> execution_context;
@@ -271,6 +391,9 @@ public:
     Config const& config() const { return m_config; }
     Schema const& schema() const { return m_schema; }
     uint64_t schema_version() const { return m_schema_version; }
+    // Changes whenever schema() does, including when only the table column
+    // indices in it are updated, for things which cache values derived from it
+    uint64_t schema_generation() const noexcept { return m_schema_generation; }
 
     // Returns `true` if this Realm is a Partially synchronized Realm.
     bool is_partial() const noexcept;
@@ -279,6 +402,20 @@ public:
     void commit_transaction();
     void cancel_transaction();
     bool is_in_transaction() const noexcept;
+
+    using AsyncWriteFunction = std::function<void(Realm&)>;
+    using AsyncWriteCompletion = std::function<void(std::exception_ptr)>;
+
+    // Queue `write` to be run inside a write transaction on a background
+    // thread which is shared by all Realm instances for this path. Writes are
+    // run in the order they were queued, and writes queued close together are
+    // committed in a single transaction (see Config::async_write_batch_size).
+    // `completion` is called on the background thread once the transaction
+    // containing the write has been committed, or with the error if the write
+    // or the commit failed. If a write throws, the other writes in its batch
+    // are run again in a new transaction, so writes should not have side
+    // effects outside of the Realm.
+    void async_write(AsyncWriteFunction write, AsyncWriteCompletion completion = nullptr);
     bool is_in_read_transaction() const { return !!m_group; }
 
     bool is_in_migration() const noexcept { return m_in_migration; }
@@ -293,8 +430,34 @@ public:
     // WARNING / FIXME: compact() should NOT be exposed publicly on Windows
     // because it's not crash safe! It may corrupt your database if something fails
     bool compact();
+
+    // Compact the file at config.path on the calling thread if it's past the
+    // config.compaction_* thresholds. This is what Config::background_compaction
+    // runs on its background thread, and can also be called directly when no
+    // Realm for the file is open. It never waits for the file to be closed,
+    // and returns FileInUse instead if it's open anywhere. Opening the file on
+    // another thread or in another process while it's being compacted blocks
+    // until it's done.
+    static CompactionResult compact_if_needed(Config const& config);
     void write_copy(StringData path, BinaryData encryption_key);
     OwnedBinaryData write_copy();
+    // Stream a copy of the Realm at the current read version to `sink` in
+    // chunks of at most `chunk_size` bytes, so that memory use does not grow
+    // with the size of the file. The copy is not encrypted. If `compress` is
+    // set each chunk is compressed, and the result has to be turned back into
+    // a Realm file with import_copy().
+    void write_copy(util::CopySink sink, bool compress, size_t chunk_size = 1024 * 1024);
+    // Create a Realm file at `path`, which must not already exist, from a copy
+    // streamed by write_copy() with or without compression
+    static void import_copy(util::CopySource const& source, std::string const& path);
+    // Write any changes not yet in the persistent copy of a write-behind
+    // Realm to it now. Does nothing if Config::write_behind_path is unset.
+    void flush_write_behind();
+    // Enforce Config::retention_policies now rather than waiting for the next
+    // background pass, and return the number of objects deleted. Must not be
+    // called in a write transaction; the deletions are committed in batches
+    // of Config::retention_batch_size.
+    size_t enforce_retention();
 
     void verify_thread() const;
     void verify_in_write() const;
@@ -337,6 +500,16 @@ public:
         return std::make_shared<make_shared_enabler>(std::move(config), std::move(coordinator));
     }
 
+    // Changes held outside of the Realm's tables during a write transaction,
+    // such as TimeSeries samples which haven't filled a chunk yet. They're
+    // written before the transaction is committed and dropped if it's cancelled.
+    class WriteBuffer {
+    public:
+        virtual ~WriteBuffer() = default;
+        virtual void flush() = 0;
+        virtual void discard() noexcept = 0;
+    };
+
     // Expose some internal functionality to other parts of the ObjectStore
     // without making it public to everyone
     class Internal {
@@ -346,6 +519,7 @@ public:
         friend class ThreadSafeReferenceBase;
         friend class GlobalNotifier;
         friend class TestHelper;
+        friend class TimeSeries;
 
         // ResultsNotifier and ListNotifier need access to the SharedGroup
         // to be able to call the handover functions, which are not very wrappable
@@ -357,6 +531,12 @@ public:
         static _impl::RealmCoordinator& get_coordinator(Realm& realm) { return *realm.m_coordinator; }
 
         static void begin_read(Realm&, VersionID);
+
+        // The Realm's WriteBuffers, keyed by whatever they buffer changes to
+        static std::shared_ptr<WriteBuffer>& get_write_buffer(Realm& realm, std::string const& key)
+        {
+            return realm.m_write_buffers[key];
+        }
     };
 
     static void open_with_config(const Config& config,
@@ -383,6 +563,7 @@ private:
     Schema m_schema;
     util::Optional<Schema> m_new_schema;
     uint64_t m_schema_transaction_version = -1;
+    uint64_t m_schema_generation = 0;
 
     // FIXME: this should be a Dynamic schema mode instead, but only once
     // that's actually fully working
@@ -391,6 +572,7 @@ private:
     std::shared_ptr<_impl::RealmCoordinator> m_coordinator;
     std::unique_ptr<sync::TableInfoCache> m_table_info_cache;
     std::unique_ptr<sync::PermissionsCache> m_permissions_cache;
+    std::unordered_map<std::string, std::shared_ptr<WriteBuffer>> m_write_buffers;
 
     // File format versions populated when a file format upgrade takes place during realm opening
     int upgrade_initial_version = 0, upgrade_final_version = 0;
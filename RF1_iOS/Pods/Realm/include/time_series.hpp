@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_TIME_SERIES_HPP
+#define REALM_OS_TIME_SERIES_HPP
+
+#include <realm/string_data.hpp>
+#include <realm/table_ref.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace realm {
+class ObjectSchema;
+class Realm;
+
+// A TimeSeries is a sequence of samples, each made up of an int64 time key and
+// a fixed set of int64 values, stored in chunks of consecutive samples rather
+// than as one object per sample.
+//
+// Each object in the backing table is one chunk. Its "time" property and a
+// property per value column hold that column's values for up to `chunk_size`
+// samples, delta and varint encoded (see impl/time_series_codec.hpp). The
+// "start" and "end" properties hold the first and last time key in the chunk
+// and are what's queried to find the chunks overlapping a time range, and
+// "count" is the number of samples in the chunk.
+//
+// "start" and "end" are indexed.
+//
+// The backing table is an ordinary object type created from object_schema(), so
+// it's part of the Realm's schema and migrations like any other type. Samples
+// must be appended in non-decreasing time order.
+//
+// The chunk being appended to is kept encoded in memory, shared by every
+// TimeSeries for the same type on a Realm instance, and its row is written only
+// when it fills up, when the time series is read, when flush() is called or when
+// the write transaction is committed. Don't modify the backing table directly in
+// a write transaction after appending to it without calling flush() first.
+class TimeSeries {
+public:
+    struct Aggregate {
+        size_t count = 0;
+        int64_t sum = 0;
+        // min and max are only meaningful if count is non-zero
+        int64_t min = 0;
+        int64_t max = 0;
+
+        double average() const noexcept { return count ? double(sum) / count : 0; }
+    };
+
+    // Get the schema for the object type backing a time series with the given
+    // value columns
+    static ObjectSchema object_schema(std::string name, std::vector<std::string> const& columns);
+
+    // Throws std::logic_error if the Realm's schema has no type named
+    // `object_type` or its properties aren't those from object_schema()
+    TimeSeries(std::shared_ptr<Realm> realm, StringData object_type, size_t chunk_size = 1024);
+
+    const std::shared_ptr<Realm>& get_realm() const { return m_realm; }
+    Table& get_table() const { return *m_table; }
+
+    size_t column_count() const noexcept { return m_value_cols.size(); }
+    // Returns npos if there's no value column with that name
+    size_t column_index(StringData name) const noexcept;
+
+    // The total number of samples
+    size_t size() const;
+
+    // Append one sample, with `values` holding one value per column. Must be
+    // called in a write transaction, and `time` must not be less than the time
+    // of the last sample.
+    void append(int64_t time, const int64_t* values);
+    // Append `count` samples. `times` must be sorted, and `columns[c][i]` is the
+    // value of column c for sample i.
+    void append(size_t count, const int64_t* times, const int64_t* const* columns);
+
+    // Write the samples appended in this write transaction which are still only
+    // held in memory to the backing table. Does nothing outside of a write
+    // transaction, as committing one flushes it.
+    void flush();
+
+    // Read the samples with begin <= time < end in time order. `columns` is
+    // resized to hold one vector per column.
+    void read(int64_t begin, int64_t end, std::vector<int64_t>& times,
+              std::vector<std::vector<int64_t>>& columns) const;
+
+    // Get the count, sum, min and max of a column over the samples with
+    // begin <= time < end
+    Aggregate aggregate(size_t column, int64_t begin, int64_t end) const;
+
+private:
+    class OpenChunk;
+
+    struct Chunk {
+        size_t row;
+        int64_t start;
+        int64_t end;
+        size_t count;
+    };
+
+    std::shared_ptr<Realm> m_realm;
+    TableRef m_table;
+    size_t m_chunk_size;
+    size_t m_start_col;
+    size_t m_end_col;
+    size_t m_count_col;
+    size_t m_time_col;
+    std::vector<size_t> m_value_cols;
+    std::shared_ptr<OpenChunk> m_open_chunk;
+
+    Chunk get_chunk(size_t row) const;
+    // The chunks containing samples with begin <= time < end, in time order
+    std::vector<Chunk> chunks_in_range(int64_t begin, int64_t end) const;
+    void flush_open_chunk() const;
+};
+
+} // namespace realm
+
+#endif // REALM_OS_TIME_SERIES_HPP
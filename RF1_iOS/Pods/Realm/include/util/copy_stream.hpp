@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2018 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_UTIL_COPY_STREAM_HPP
+#define REALM_OS_UTIL_COPY_STREAM_HPP
+
+#include <realm/binary_data.hpp>
+#include <realm/util/compression.hpp>
+
+#include <functional>
+#include <streambuf>
+#include <vector>
+
+namespace realm {
+namespace util {
+class File;
+
+// Receives each successive chunk of a streamed copy of a Realm
+using CopySink = std::function<void(BinaryData)>;
+// Reads up to `size` bytes of a streamed copy into `buffer`, returning the
+// number of bytes read, or zero at the end of the stream
+using CopySource = std::function<size_t(char* buffer, size_t size)>;
+
+// A std::streambuf which passes everything written to it on to a CopySink in
+// chunks of at most `chunk_size` bytes, so that a Group can be serialized
+// without holding the whole file in memory.
+//
+// Uncompressed output is a plain Realm file. Compressed output starts with a
+// header identifying it as such, followed by one frame per chunk:
+//     uint32 uncompressed size, uint32 stored size, stored bytes
+// with the chunk stored uncompressed if compressing it didn't make it smaller,
+// and ends with a frame with an uncompressed size of zero. All integers are
+// little-endian.
+class CopyStreamBuf : public std::streambuf {
+public:
+    CopyStreamBuf(CopySink sink, bool compress, size_t chunk_size);
+
+    // Pass on the final partial chunk and end the stream. Nothing can be
+    // written after this.
+    void finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+    int sync() override;
+
+private:
+    CopySink m_sink;
+    const bool m_compress;
+    bool m_started = false;
+    std::vector<char> m_buffer;
+    std::vector<char> m_compressed;
+    compression::CompressMemoryArena m_arena;
+
+    void write_chunk();
+    void write_frame_header(uint32_t uncompressed_size, uint32_t stored_size);
+};
+
+// Read a copy written through CopyStreamBuf, compressed or not, from `source`
+// and write the Realm file it contains to `out`. Throws std::runtime_error if
+// the stream is truncated or corrupt.
+void read_copy_stream(CopySource const& source, File& out);
+
+} // namespace util
+} // namespace realm
+
+#endif // REALM_OS_UTIL_COPY_STREAM_HPP
@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2016 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_GENERIC_EVENT_LOOP_SIGNAL_HPP
+#define REALM_OS_GENERIC_EVENT_LOOP_SIGNAL_HPP
+
+namespace realm {
+namespace util {
+// Used on platforms with no event loop to integrate with, such as the Linux
+// test build. notify() does nothing, so Realms there only see changes made by
+// other threads and processes when they're refreshed or notify() is called.
+template<typename Callback>
+class EventLoopSignal {
+public:
+    EventLoopSignal(Callback&&) { }
+    void notify() { }
+};
+} // namespace util
+} // namespace realm
+
+#endif // REALM_OS_GENERIC_EVENT_LOOP_SIGNAL_HPP
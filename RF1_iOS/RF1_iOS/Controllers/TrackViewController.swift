@@ -185,6 +185,7 @@ class TrackViewController: BaseViewController, BLEManagerDelegate, BLEDataManage
         
         initializeRunTimer()
         inRunState = true
+        bleDataManager?.resetSampleIndex()
         bleManager.turnOnNotifications()
         pauseButton.setTitle("Pause", for: .normal)
     }
@@ -297,7 +298,7 @@ class TrackViewController: BaseViewController, BLEManagerDelegate, BLEDataManage
     func didReceiveBLEData(data: Data) {
         
         bleDataManager.processNewData(updatedData: data)
-        timeSinceLastStep += PeripheralDevice.samplePeriod //This works in sleep mode while a timer does not!
+        timeSinceLastStep += PeripheralDevice.samplePeriod * Double(bleDataManager.samplesSinceLastData) //This works in sleep mode while a timer does not!
 //        dataLabel.text = "Fore: \(bleDataManager.forefootVoltage) Heel: \(bleDataManager.heelVoltage)"
 //        print("Fore: \(bleDataManager.forefootVoltage) Heel: \(bleDataManager.heelVoltage)")
     }
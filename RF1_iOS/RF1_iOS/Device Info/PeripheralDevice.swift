@@ -15,8 +15,11 @@ struct PeripheralDevice {
     
     static let fsrServiceUUID = CBUUID(string: "6c1b0001-4e01-8b6f-9a30-4ab6f2d2937c")
     static let fsrDataCharacteristicUUID = CBUUID(string: "6c1b0002-4e01-8b6f-9a30-4ab6f2d2937c")
+    static let fsrProbeCharacteristicUUID = CBUUID(string: "6c1b0003-4e01-8b6f-9a30-4ab6f2d2937c")
     
     static let numberOfSensors: Int = 2
     
     static let samplePeriod: Double = 0.05 //20 Hz on the hardware
+    
+    static let rtcTickPeriod: Double = 1.0 / 32768 //RTC2 on the hardware, used for the latency probe times
 }
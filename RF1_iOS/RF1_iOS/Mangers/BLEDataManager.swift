@@ -17,12 +17,16 @@ protocol BLEDataManagerDelegate {
 class BLEDataManager {
     
     private var fsrDataArray = [Int16]()
+    private var fsrDecoder = fsr_decoder_t() //Native decoder from fsr_decode, keeps the last sample index
+    private var decodedSkipped: [UInt16] = [0]
     
     private var delegateVC: BLEDataManagerDelegate?
     
     var heelVoltage: Int = 0 //Could make private if not printing out to label
     var forefootVoltage: Int = 0 //Could make private if not printing out to label
     
+    var samplesSinceLastData: Int = 1 //The device only streams densely around foot contact, so one notification can cover several samples
+    
     private var heelForceFifo: [Double] = []
     private var forefootForceFifo: [Double] = []
     private let forceFifoSize: Int = 4
@@ -54,6 +58,7 @@ class BLEDataManager {
         
         delegateVC = delegate
         initializeFsrDataArray()
+        fsr_decoder_init(&fsrDecoder, UInt8(PeripheralDevice.numberOfSensors), FSR_DECODE_FORMAT_SINGLE)
         
         if logRawData {
             
@@ -63,6 +68,12 @@ class BLEDataManager {
     }
     
     
+    func resetSampleIndex() { //Called when notifications are turned back on so the paused time is not counted as skipped samples
+        
+        fsr_decoder_reset(&fsrDecoder)
+    }
+    
+    
     private func initializeFsrDataArray() {
         
         for _ in 0..<PeripheralDevice.numberOfSensors {
@@ -75,6 +86,18 @@ class BLEDataManager {
         
         saveFsrData(dataToBeSaved: data)
         
+        //Samples the device skipped were below the contact threshold, so replay them as no-force samples
+        //Only the FIFO's worth of them can affect the step and footstrike detection
+        for _ in 0..<min(samplesSinceLastData - 1, forceFifoSize) {
+            processSample(heelVoltage: 0, forefootVoltage: 0)
+        }
+        
+        processSample(heelVoltage: heelVoltage, forefootVoltage: forefootVoltage)
+    }
+    
+    
+    private func processSample(heelVoltage: Int, forefootVoltage: Int) {
+        
         if heelForceFifo.count < forceFifoSize {
             
             heelForceFifo.append(calculateForce(forVoltage: heelVoltage))
@@ -178,15 +201,19 @@ class BLEDataManager {
 
     private func saveFsrData(dataToBeSaved data: Data) {
         
-        //1. Get a pointer (ptr) to the data value (size of Int16) in the Data buffer
-        //2. Advance the pointer if necessary
-        //3. Put the value ptr points to into the appropriate index of fsrDataArray
-        for i in 0...(fsrDataArray.count - 1) {
-            fsrDataArray[i] = data.withUnsafeBytes { (ptr: UnsafePointer<Int16>) in
-                ptr.advanced(by: i).pointee
+        //The decoder writes one value per sensor into fsrDataArray and how many samples the device skipped before this one
+        //Older firmware without the sample index notifies every sample
+        let samplesDecoded = data.withUnsafeBytes { (dataPtr: UnsafePointer<UInt8>) -> Int32 in
+            fsrDataArray.withUnsafeMutableBufferPointer { (mvoltPtr) -> Int32 in
+                decodedSkipped.withUnsafeMutableBufferPointer { (skippedPtr) -> Int32 in
+                    var output = fsr_decode_out_t(p_mvolt: mvoltPtr.baseAddress, p_indices: nil, p_skipped: skippedPtr.baseAddress, capacity: 1)
+                    return fsr_decode_packet(&fsrDecoder, dataPtr, data.count, &output)
+                }
             }
         }
         
+        samplesSinceLastData = (samplesDecoded == 1) ? Int(decodedSkipped[0]) + 1 : 1
+        
         heelVoltage = Int(fsrDataArray[0])
         forefootVoltage = Int(fsrDataArray[1])
         
@@ -241,15 +268,13 @@ class BLEDataManager {
         let realm = try! Realm()
         
         let oldData: Results<FSRData> = realm.objects(FSRData.self)
-        for fsrResult in oldData {
-            do {
+        do {
             
-                try realm.write {
-                    realm.delete(fsrResult)
-                }
-            } catch {
-                print("Error deleting \(error)")
+            try realm.write {
+                realm.delete(oldData)
             }
+        } catch {
+            print("Error deleting \(error)")
         }
     }
     
@@ -21,6 +21,7 @@ class BLEManager: NSObject, CBCentralManagerDelegate, CBPeripheralDelegate {
     private var centralManager: CBCentralManager!
     private var fsrPeripheral: CBPeripheral?
     private var fsrCharacteristic: CBCharacteristic?
+    private var fsrProbeCharacteristic: CBCharacteristic?
     
     private let timerScanInterval:TimeInterval = 5.0
     private var scanTimer = Timer()
@@ -29,6 +30,11 @@ class BLEManager: NSObject, CBCentralManagerDelegate, CBPeripheralDelegate {
     
     private var delegateVC: BLEManagerDelegate?
     
+    private let probeLatency: Bool = false //Measures the end-to-end latency while notifications are on and prints it when they are turned off
+    private let probeInterval: TimeInterval = 1.0
+    private var probeTimer = Timer()
+    private let latencyProbe = LatencyProbe()
+    
     override init() {
         
         super.init()
@@ -91,6 +97,8 @@ class BLEManager: NSObject, CBCentralManagerDelegate, CBPeripheralDelegate {
         if let characteristic = fsrCharacteristic {
             fsrPeripheral?.setNotifyValue(true, for: characteristic)
         }
+        
+        if probeLatency {startLatencyProbe()}
     }
     
     
@@ -99,6 +107,49 @@ class BLEManager: NSObject, CBCentralManagerDelegate, CBPeripheralDelegate {
         if let characteristic = fsrCharacteristic {
             fsrPeripheral?.setNotifyValue(false, for: characteristic)
         }
+        
+        if probeLatency {stopLatencyProbe()}
+    }
+    
+    
+    //MARK: - Latency Probe Methods
+    
+    private func startLatencyProbe() {
+        
+        guard let characteristic = fsrProbeCharacteristic else {return} //Older firmware without the probe
+        
+        fsrPeripheral?.setNotifyValue(true, for: characteristic)
+        latencyProbe.reset()
+        
+        probeTimer.invalidate()
+        probeTimer = Timer.scheduledTimer(
+            timeInterval: probeInterval,
+            target: self,
+            selector: #selector(BLEManager.sendLatencyProbe),
+            userInfo: nil,
+            repeats: true)
+    }
+    
+    
+    private func stopLatencyProbe() {
+        
+        guard probeTimer.isValid else {return}
+        
+        probeTimer.invalidate()
+        
+        if let characteristic = fsrProbeCharacteristic {
+            fsrPeripheral?.setNotifyValue(false, for: characteristic)
+        }
+        
+        print(latencyProbe.getSummary())
+    }
+    
+    
+    @objc func sendLatencyProbe() {
+        
+        if let characteristic = fsrProbeCharacteristic {
+            fsrPeripheral?.writeValue(latencyProbe.makeProbe(), for: characteristic, type: .withoutResponse)
+        }
     }
     
     
@@ -231,6 +282,15 @@ class BLEManager: NSObject, CBCentralManagerDelegate, CBPeripheralDelegate {
         
         if let foundCharacteristics = service.characteristics {
             
+            //The probe is found first since finding the data characteristic turns the notifications on
+            for characteristic in foundCharacteristics {
+                
+                if characteristic.uuid == PeripheralDevice.fsrProbeCharacteristicUUID {
+                    
+                    fsrProbeCharacteristic = characteristic
+                }
+            }
+            
             for characteristic in foundCharacteristics {
                 
                 if characteristic.uuid == PeripheralDevice.fsrDataCharacteristicUUID {
@@ -259,7 +319,15 @@ class BLEManager: NSObject, CBCentralManagerDelegate, CBPeripheralDelegate {
             
             if characteristic.uuid == PeripheralDevice.fsrDataCharacteristicUUID {
                 
+                let receiveTime = LatencyProbe.currentTime()
+                
                 delegateVC?.didReceiveBLEData(data: foundData)
+                
+                if probeLatency {latencyProbe.processDataNotification(foundData, receivedAt: receiveTime, processedAt: LatencyProbe.currentTime())}
+                
+            } else if characteristic.uuid == PeripheralDevice.fsrProbeCharacteristicUUID {
+                
+                latencyProbe.processEcho(foundData, receivedAt: LatencyProbe.currentTime())
             }
         }
     }
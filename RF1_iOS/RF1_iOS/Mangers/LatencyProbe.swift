@@ -0,0 +1,155 @@
+//
+//  LatencyProbe.swift
+//  RF1_iOS
+//
+//  Created by Keegan Jebb on 2018-07-02.
+//  Copyright © 2018 Keegan Jebb. All rights reserved.
+//
+
+import Foundation
+
+struct LatencyDistribution { //All times in ms
+    
+    var count: Int = 0
+    var min: Double = 0
+    var median: Double = 0
+    var percentile95: Double = 0
+    var max: Double = 0
+    
+    init(fromSeconds values: [Double]) {
+        
+        if values.isEmpty {return}
+        
+        let sortedValues = values.sorted()
+        
+        count = sortedValues.count
+        min = sortedValues.first! * 1000
+        median = sortedValues[(count - 1) / 2] * 1000
+        percentile95 = sortedValues[((count - 1) * 95) / 100] * 1000
+        max = sortedValues.last! * 1000
+    }
+    
+    
+    func getDescription() -> String {
+        
+        return String(format: "n=%d min=%.1f median=%.1f p95=%.1f max=%.1f ms", count, min, median, percentile95, max)
+    }
+}
+
+
+//Matches latency probe echoes from the device with the data notification of the sample they were tagged with
+//The device echoes a probe along with how long it held it and how old the sample was, both in RTC2 ticks
+//Half of the remaining round trip is taken as the one way link time, which puts the sample on the phone's clock
+//Times are when CoreBluetooth delivers the notification, so the OS part of the link is included in the notification latency
+class LatencyProbe {
+    
+    private var nextNonce: UInt16 = 0
+    private var probeSendTimes = [UInt16: Double]() //Keyed by nonce
+    private var estimatedSampleTimes = [UInt16: Double]() //Keyed by the sample index the echo was tagged with
+    
+    private var roundTripTimes = [Double]()
+    private var sampleToNotificationTimes = [Double]()
+    private var notificationToProcessedTimes = [Double]()
+    private var sampleToProcessedTimes = [Double]()
+    
+    private let maxOutstanding: Int = 16 //Probes or samples older than this many probes are given up on
+    private let maxResults: Int = 1000
+    
+    static let probeLength: Int = 6
+    static let echoLength: Int = 12
+    
+    
+    static func currentTime() -> Double { //Seconds, monotonic
+        
+        return ProcessInfo.processInfo.systemUptime
+    }
+    
+    
+    func makeProbe() -> Data { //Layout: UInt16 nonce, UInt32 phone timestamp in ms (little endian)
+        
+        let sendTime = LatencyProbe.currentTime()
+        
+        nextNonce = nextNonce &+ 1
+        
+        if probeSendTimes.count >= maxOutstanding {probeSendTimes.removeAll()} //Lost echoes
+        probeSendTimes[nextNonce] = sendTime
+        
+        var nonce = nextNonce.littleEndian
+        var timestamp = UInt32(truncatingIfNeeded: Int64(sendTime * 1000)).littleEndian
+        
+        var probe = Data(bytes: &nonce, count: MemoryLayout<UInt16>.size)
+        probe.append(Data(bytes: &timestamp, count: MemoryLayout<UInt32>.size))
+        
+        return probe
+    }
+    
+    
+    func processEcho(_ data: Data, receivedAt receiveTime: Double) { //Layout: probe, UInt16 sample index, UInt16 residency ticks, UInt16 sample age ticks
+        
+        if data.count < LatencyProbe.echoLength {return}
+        
+        let nonce = readUInt16(data, at: 0)
+        let sampleIndex = readUInt16(data, at: 6)
+        let residencyTime = Double(readUInt16(data, at: 8)) * PeripheralDevice.rtcTickPeriod
+        let sampleAge = Double(readUInt16(data, at: 10)) * PeripheralDevice.rtcTickPeriod
+        
+        guard let sendTime = probeSendTimes.removeValue(forKey: nonce) else {return} //Stale or unknown probe
+        
+        let roundTrip = receiveTime - sendTime
+        let oneWayTime = max(roundTrip - residencyTime, 0) / 2
+        
+        addResult(roundTrip - residencyTime, to: &roundTripTimes)
+        
+        if estimatedSampleTimes.count >= maxOutstanding {estimatedSampleTimes.removeAll()} //Data notifications that never arrived
+        estimatedSampleTimes[sampleIndex] = receiveTime - oneWayTime - sampleAge
+    }
+    
+    
+    func processDataNotification(_ data: Data, receivedAt receiveTime: Double, processedAt processedTime: Double) {
+        
+        let indexOffset = PeripheralDevice.numberOfSensors * MemoryLayout<Int16>.size
+        
+        if data.count < indexOffset + MemoryLayout<UInt16>.size {return}
+        
+        guard let sampleTime = estimatedSampleTimes.removeValue(forKey: readUInt16(data, at: indexOffset)) else {return} //Sample was not probed
+        
+        addResult(receiveTime - sampleTime, to: &sampleToNotificationTimes)
+        addResult(processedTime - receiveTime, to: &notificationToProcessedTimes)
+        addResult(processedTime - sampleTime, to: &sampleToProcessedTimes)
+    }
+    
+    
+    func getSummary() -> String {
+        
+        return  "Link round trip: \(LatencyDistribution(fromSeconds: roundTripTimes).getDescription())\n" +
+                "Sample to notification: \(LatencyDistribution(fromSeconds: sampleToNotificationTimes).getDescription())\n" +
+                "Notification to processed: \(LatencyDistribution(fromSeconds: notificationToProcessedTimes).getDescription())\n" +
+                "Sample to processed: \(LatencyDistribution(fromSeconds: sampleToProcessedTimes).getDescription())"
+    }
+    
+    
+    func reset() {
+        
+        probeSendTimes.removeAll()
+        estimatedSampleTimes.removeAll()
+        roundTripTimes.removeAll()
+        sampleToNotificationTimes.removeAll()
+        notificationToProcessedTimes.removeAll()
+        sampleToProcessedTimes.removeAll()
+    }
+    
+    
+    private func addResult(_ value: Double, to results: inout [Double]) {
+        
+        if results.count >= maxResults {results.remove(at: 0)}
+        results.append(value)
+    }
+    
+    
+    private func readUInt16(_ data: Data, at offset: Int) -> UInt16 { //Byte by byte since the probe fields are not aligned
+        
+        return UInt16(data[offset]) | (UInt16(data[offset + 1]) << 8)
+    }
+    
+    
+}
@@ -0,0 +1,9 @@
+//
+//  RF1_iOS-Bridging-Header.h
+//  RF1_iOS
+//
+//  Created by Keegan Jebb on 2018-07-08.
+//  Copyright © 2018 Keegan Jebb. All rights reserved.
+//
+
+#include "fsr_decode.h" //Shared FSR data decoder, found through HEADER_SEARCH_PATHS
@@ -0,0 +1,68 @@
+/*Decoder for the FSR data characteristic, shared by the iOS app and offline tools*/
+
+#ifndef FSR_DECODE_H__
+#define FSR_DECODE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Wire formats, all little endian. Samples in one batch have consecutive indices
+//SINGLE: int16 mV per sensor, uint16 sample index. Firmware older than the sample index sends the mV values only
+//BATCH:  uint16 first sample index, uint8 sample count, then int16 mV per sensor for each sample
+//DELTA:  uint16 first sample index, uint8 sample count, int16 mV per sensor for the first sample,
+//        then for each later sample one zigzag LEB128 varint per sensor holding the change from the previous sample
+typedef enum
+{
+    FSR_DECODE_FORMAT_SINGLE,
+    FSR_DECODE_FORMAT_BATCH,
+    FSR_DECODE_FORMAT_DELTA
+} fsr_decode_format_t;
+
+#define FSR_DECODE_MAX_SENSORS          (8)
+#define FSR_DECODE_MAX_BATCH            (255)   //Sample count is a uint8
+
+#define FSR_DECODE_ERROR_LENGTH         (-1)    //Packet is shorter or longer than its header says
+#define FSR_DECODE_ERROR_CAPACITY       (-2)    //Output arrays cannot hold every sample of the packet
+#define FSR_DECODE_ERROR_PARAM          (-3)    //Bad decoder or output structure
+
+//Streaming state. Keeps the last sample index so gaps between packets can be reported
+typedef struct
+{
+    uint8_t                 num_sensors;
+    fsr_decode_format_t     format;
+    uint16_t                last_index;
+    bool                    has_last_index;
+} fsr_decoder_t;
+
+//Caller-provided contiguous output. Any pointer other than p_mvolt may be NULL
+typedef struct
+{
+    int16_t *   p_mvolt;        //Channel-major: sample i of sensor c is at p_mvolt[c * capacity + i]
+    uint16_t *  p_indices;      //Sample index of each decoded sample
+    uint16_t *  p_skipped;      //Samples the device did not send before each decoded sample
+    size_t      capacity;       //Samples each array can hold
+} fsr_decode_out_t;
+
+void fsr_decoder_init(fsr_decoder_t * p_decoder, uint8_t num_sensors, fsr_decode_format_t format);
+
+void fsr_decoder_reset(fsr_decoder_t * p_decoder); //Forget the last index, e.g. after notifications were paused
+
+//Returns the number of samples written to p_out, or a negative FSR_DECODE_ERROR_ code
+int32_t fsr_decode_packet(fsr_decoder_t * p_decoder, uint8_t const * p_data, size_t length, fsr_decode_out_t const * p_out);
+
+//Encoders for the batched formats, for the firmware and for building test streams. p_mvolt is sample-major (sample i of sensor c at p_mvolt[i * num_sensors + c])
+//Return the number of bytes written, or 0 if p_buffer is too small
+size_t fsr_encode_batch(uint8_t num_sensors, uint16_t first_index, int16_t const * p_mvolt, uint8_t count, uint8_t * p_buffer, size_t buffer_size);
+
+size_t fsr_encode_delta(uint8_t num_sensors, uint16_t first_index, int16_t const * p_mvolt, uint8_t count, uint8_t * p_buffer, size_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //FSR_DECODE_H__
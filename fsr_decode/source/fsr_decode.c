@@ -0,0 +1,432 @@
+// fsr_decode.c
+
+#include <string.h>
+
+#include "fsr_decode.h"
+
+//The vector paths load the little endian wire data straight into lanes
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    #define FSR_DECODE_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+    #include <arm_neon.h>
+    #define FSR_DECODE_NEON
+#endif
+
+#define BATCH_HEADER_LEN (3) //uint16 first sample index, uint8 sample count
+#define VARINT_MAX_LEN (3) //A uint16 needs at most 3 LEB128 bytes
+
+static uint16_t uint16_read(uint8_t const * p_src)
+{
+    return (uint16_t)(p_src[0] | (p_src[1] << 8));
+}
+
+static size_t uint16_write(uint16_t value, uint8_t * p_dst)
+{
+    p_dst[0] = (uint8_t)(value & 0xFF);
+    p_dst[1] = (uint8_t)(value >> 8);
+    return sizeof(uint16_t);
+}
+
+//Maps small positive and negative changes to small unsigned values: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+static uint16_t zigzag_encode(int16_t value)
+{
+    return (uint16_t)(((uint16_t)value << 1) ^ (uint16_t)(value >> 15));
+}
+
+static int16_t zigzag_decode(uint16_t value)
+{
+    return (int16_t)((value >> 1) ^ (uint16_t)(0 - (value & 1)));
+}
+
+//Splits interleaved wire samples into one contiguous array per sensor
+static void samples_unpack(uint8_t const * p_src, size_t count, uint8_t num_sensors, int16_t * p_dst, size_t capacity)
+{
+    size_t i = 0;
+
+#if defined(FSR_DECODE_SSE2)
+    if (num_sensors == 2)
+    {
+        for (; (i + 4) <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((__m128i const *)(p_src + (i * 4))); //h0 f0 h1 f1 h2 f2 h3 f3
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));             //h0 h1 f0 f1 h2 f2 h3 f3
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));             //h0 h1 f0 f1 h2 h3 f2 f3
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));               //h0 h1 h2 h3 f0 f1 f2 f3
+            _mm_storel_epi64((__m128i *)(p_dst + i), v);
+            _mm_storel_epi64((__m128i *)(p_dst + capacity + i), _mm_srli_si128(v, 8));
+        }
+    }
+#elif defined(FSR_DECODE_NEON)
+    if (num_sensors == 2)
+    {
+        for (; (i + 8) <= count; i += 8)
+        {
+            int16x8x2_t v = vld2q_s16((int16_t const *)(p_src + (i * 4)));
+            vst1q_s16(p_dst + i, v.val[0]);
+            vst1q_s16(p_dst + capacity + i, v.val[1]);
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        for (uint8_t c = 0; c < num_sensors; c++)
+        {
+            p_dst[(c * capacity) + i] = (int16_t)uint16_read(&p_src[((i * num_sensors) + c) * sizeof(int16_t)]);
+        }
+    }
+}
+
+//In place running sum starting from start, with int16 wrap around like the encoder's subtraction
+static void prefix_sum(int16_t * p_values, size_t count, int16_t start)
+{
+    size_t  i = 0;
+    int16_t carry = start;
+
+#if defined(FSR_DECODE_SSE2)
+    __m128i v_carry = _mm_set1_epi16(carry);
+
+    for (; (i + 8) <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((__m128i const *)(p_values + i));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi16(v, v_carry);
+        _mm_storeu_si128((__m128i *)(p_values + i), v);
+
+        v_carry = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)); //Broadcast the last lane
+        v_carry = _mm_unpackhi_epi64(v_carry, v_carry);
+    }
+
+    carry = (int16_t)_mm_extract_epi16(v_carry, 0);
+#elif defined(FSR_DECODE_NEON)
+    int16x8_t v_zero  = vdupq_n_s16(0);
+    int16x8_t v_carry = vdupq_n_s16(carry);
+
+    for (; (i + 8) <= count; i += 8)
+    {
+        int16x8_t v = vld1q_s16(p_values + i);
+        v = vaddq_s16(v, vextq_s16(v_zero, v, 7));
+        v = vaddq_s16(v, vextq_s16(v_zero, v, 6));
+        v = vaddq_s16(v, vextq_s16(v_zero, v, 4));
+        v = vaddq_s16(v, v_carry);
+        vst1q_s16(p_values + i, v);
+
+        v_carry = vdupq_n_s16(vgetq_lane_s16(v, 7));
+    }
+
+    carry = vgetq_lane_s16(v_carry, 0);
+#endif
+
+    for (; i < count; i++)
+    {
+        carry = (int16_t)(carry + p_values[i]);
+        p_values[i] = carry;
+    }
+}
+
+//Decodes count zigzag varints. Runs of 16 one byte varints, the usual case for slowly changing FSR data, are done 16 at a time
+//Returns the number of bytes used, or 0 if the data ends early
+static size_t varints_decode(uint8_t const * p_src, size_t length, int16_t * p_dst, size_t count)
+{
+    size_t used = 0;
+    size_t n = 0;
+
+    while (n < count)
+    {
+#if defined(FSR_DECODE_SSE2)
+        if (((count - n) >= 16) && ((length - used) >= 16))
+        {
+            __m128i v_bytes = _mm_loadu_si128((__m128i const *)(p_src + used));
+
+            if (_mm_movemask_epi8(v_bytes) == 0) //No continuation bits
+            {
+                __m128i v_zero = _mm_setzero_si128();
+                __m128i v_one  = _mm_set1_epi16(1);
+                __m128i v_lo   = _mm_unpacklo_epi8(v_bytes, v_zero);
+                __m128i v_hi   = _mm_unpackhi_epi8(v_bytes, v_zero);
+
+                v_lo = _mm_xor_si128(_mm_srli_epi16(v_lo, 1), _mm_sub_epi16(v_zero, _mm_and_si128(v_lo, v_one)));
+                v_hi = _mm_xor_si128(_mm_srli_epi16(v_hi, 1), _mm_sub_epi16(v_zero, _mm_and_si128(v_hi, v_one)));
+
+                _mm_storeu_si128((__m128i *)(p_dst + n), v_lo);
+                _mm_storeu_si128((__m128i *)(p_dst + n + 8), v_hi);
+
+                used += 16;
+                n += 16;
+                continue;
+            }
+        }
+#elif defined(FSR_DECODE_NEON)
+        if (((count - n) >= 16) && ((length - used) >= 16))
+        {
+            uint8x16_t v_bytes = vld1q_u8(p_src + used);
+            uint64x2_t v_flags = vreinterpretq_u64_u8(vshrq_n_u8(v_bytes, 7));
+
+            if ((vgetq_lane_u64(v_flags, 0) | vgetq_lane_u64(v_flags, 1)) == 0) //No continuation bits
+            {
+                uint16x8_t v_one = vdupq_n_u16(1);
+                uint16x8_t v_lo  = vmovl_u8(vget_low_u8(v_bytes));
+                uint16x8_t v_hi  = vmovl_u8(vget_high_u8(v_bytes));
+
+                v_lo = veorq_u16(vshrq_n_u16(v_lo, 1), vreinterpretq_u16_s16(vnegq_s16(vreinterpretq_s16_u16(vandq_u16(v_lo, v_one)))));
+                v_hi = veorq_u16(vshrq_n_u16(v_hi, 1), vreinterpretq_u16_s16(vnegq_s16(vreinterpretq_s16_u16(vandq_u16(v_hi, v_one)))));
+
+                vst1q_s16(p_dst + n, vreinterpretq_s16_u16(v_lo));
+                vst1q_s16(p_dst + n + 8, vreinterpretq_s16_u16(v_hi));
+
+                used += 16;
+                n += 16;
+                continue;
+            }
+        }
+#endif
+
+        uint16_t value = 0;
+        uint8_t  shift = 0;
+        uint8_t  byte;
+
+        do
+        {
+            if ((used >= length) || (shift >= (VARINT_MAX_LEN * 7)))
+            {
+                return 0;
+            }
+
+            byte = p_src[used++];
+            value |= (uint16_t)((byte & 0x7F) << shift);
+            shift += 7;
+        } while (byte & 0x80);
+
+        p_dst[n++] = zigzag_decode(value);
+    }
+
+    return used;
+}
+
+//Fills the index and gap outputs for count consecutive samples and moves the stream position on
+static void indices_update(fsr_decoder_t * p_decoder, uint16_t first_index, size_t count, fsr_decode_out_t const * p_out)
+{
+    uint16_t skipped = 0;
+
+    if (p_decoder->has_last_index)
+    {
+        uint16_t step = (uint16_t)(first_index - p_decoder->last_index);
+        skipped = (step > 1) ? (uint16_t)(step - 1) : 0; //A repeated index is treated as the next sample. The index wraps at 65536
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (p_out->p_indices != NULL)
+        {
+            p_out->p_indices[i] = (uint16_t)(first_index + i);
+        }
+
+        if (p_out->p_skipped != NULL)
+        {
+            p_out->p_skipped[i] = (i == 0) ? skipped : 0;
+        }
+    }
+
+    p_decoder->last_index = (uint16_t)(first_index + count - 1);
+    p_decoder->has_last_index = true;
+}
+
+static int32_t single_decode(fsr_decoder_t * p_decoder, uint8_t const * p_data, size_t length, fsr_decode_out_t const * p_out)
+{
+    size_t   samples_len = p_decoder->num_sensors * sizeof(int16_t);
+    uint16_t index;
+
+    if (length == samples_len)
+    {
+        index = (uint16_t)(p_decoder->last_index + 1); //No index on the wire, every sample was sent
+    }
+    else if (length == (samples_len + sizeof(uint16_t)))
+    {
+        index = uint16_read(&p_data[samples_len]);
+    }
+    else
+    {
+        return FSR_DECODE_ERROR_LENGTH;
+    }
+
+    samples_unpack(p_data, 1, p_decoder->num_sensors, p_out->p_mvolt, p_out->capacity);
+    indices_update(p_decoder, index, 1, p_out);
+
+    return 1;
+}
+
+static int32_t batch_decode(fsr_decoder_t * p_decoder, uint8_t const * p_data, size_t length, fsr_decode_out_t const * p_out)
+{
+    uint16_t first_index = uint16_read(&p_data[0]);
+    uint8_t  count = p_data[2];
+
+    if (length != (BATCH_HEADER_LEN + (count * p_decoder->num_sensors * sizeof(int16_t))))
+    {
+        return FSR_DECODE_ERROR_LENGTH;
+    }
+
+    if (count > p_out->capacity)
+    {
+        return FSR_DECODE_ERROR_CAPACITY;
+    }
+
+    samples_unpack(&p_data[BATCH_HEADER_LEN], count, p_decoder->num_sensors, p_out->p_mvolt, p_out->capacity);
+    indices_update(p_decoder, first_index, count, p_out);
+
+    return count;
+}
+
+static int32_t delta_decode(fsr_decoder_t * p_decoder, uint8_t const * p_data, size_t length, fsr_decode_out_t const * p_out)
+{
+    int16_t  deltas[(FSR_DECODE_MAX_BATCH - 1) * FSR_DECODE_MAX_SENSORS]; //Interleaved like the wire
+    uint8_t  num_sensors = p_decoder->num_sensors;
+    size_t   first_len = num_sensors * sizeof(int16_t);
+    uint16_t first_index = uint16_read(&p_data[0]);
+    uint8_t  count = p_data[2];
+
+    if ((count == 0) || (length < (BATCH_HEADER_LEN + first_len)))
+    {
+        return FSR_DECODE_ERROR_LENGTH;
+    }
+
+    if (count > p_out->capacity)
+    {
+        return FSR_DECODE_ERROR_CAPACITY;
+    }
+
+    size_t num_deltas = (size_t)(count - 1) * num_sensors;
+    size_t deltas_len = length - BATCH_HEADER_LEN - first_len;
+
+    if ((num_deltas > 0) && (varints_decode(&p_data[BATCH_HEADER_LEN + first_len], deltas_len, deltas, num_deltas) != deltas_len))
+    {
+        return FSR_DECODE_ERROR_LENGTH;
+    }
+    else if ((num_deltas == 0) && (deltas_len != 0))
+    {
+        return FSR_DECODE_ERROR_LENGTH;
+    }
+
+    //Sample 0 is raw, the later samples of each sensor are the deltas added up from it
+    samples_unpack(&p_data[BATCH_HEADER_LEN], 1, num_sensors, p_out->p_mvolt, p_out->capacity);
+
+    for (uint8_t c = 0; c < num_sensors; c++)
+    {
+        int16_t * p_channel = p_out->p_mvolt + (c * p_out->capacity);
+
+        for (size_t i = 1; i < count; i++)
+        {
+            p_channel[i] = deltas[((i - 1) * num_sensors) + c];
+        }
+
+        prefix_sum(p_channel + 1, count - 1, p_channel[0]);
+    }
+
+    indices_update(p_decoder, first_index, count, p_out);
+
+    return count;
+}
+
+void fsr_decoder_init(fsr_decoder_t * p_decoder, uint8_t num_sensors, fsr_decode_format_t format)
+{
+    p_decoder->num_sensors = num_sensors;
+    p_decoder->format = format;
+    fsr_decoder_reset(p_decoder);
+}
+
+void fsr_decoder_reset(fsr_decoder_t * p_decoder)
+{
+    p_decoder->last_index = 0;
+    p_decoder->has_last_index = false;
+}
+
+int32_t fsr_decode_packet(fsr_decoder_t * p_decoder, uint8_t const * p_data, size_t length, fsr_decode_out_t const * p_out)
+{
+    if ((p_decoder == NULL) || (p_data == NULL) || (p_out == NULL) || (p_out->p_mvolt == NULL) ||
+        (p_decoder->num_sensors == 0) || (p_decoder->num_sensors > FSR_DECODE_MAX_SENSORS))
+    {
+        return FSR_DECODE_ERROR_PARAM;
+    }
+
+    if (p_out->capacity == 0)
+    {
+        return FSR_DECODE_ERROR_CAPACITY;
+    }
+
+    switch (p_decoder->format)
+    {
+        case FSR_DECODE_FORMAT_SINGLE:
+            return single_decode(p_decoder, p_data, length, p_out);
+
+        case FSR_DECODE_FORMAT_BATCH:
+        case FSR_DECODE_FORMAT_DELTA:
+            if (length < BATCH_HEADER_LEN)
+            {
+                return FSR_DECODE_ERROR_LENGTH;
+            }
+            return (p_decoder->format == FSR_DECODE_FORMAT_BATCH) ? batch_decode(p_decoder, p_data, length, p_out)
+                                                                  : delta_decode(p_decoder, p_data, length, p_out);
+
+        default:
+            return FSR_DECODE_ERROR_PARAM;
+    }
+}
+
+size_t fsr_encode_batch(uint8_t num_sensors, uint16_t first_index, int16_t const * p_mvolt, uint8_t count, uint8_t * p_buffer, size_t buffer_size)
+{
+    size_t total = (size_t)count * num_sensors;
+    size_t len = 0;
+
+    if (buffer_size < (BATCH_HEADER_LEN + (total * sizeof(int16_t))))
+    {
+        return 0;
+    }
+
+    len += uint16_write(first_index, &p_buffer[len]);
+    p_buffer[len++] = count;
+
+    for (size_t i = 0; i < total; i++)
+    {
+        len += uint16_write((uint16_t)p_mvolt[i], &p_buffer[len]);
+    }
+
+    return len;
+}
+
+size_t fsr_encode_delta(uint8_t num_sensors, uint16_t first_index, int16_t const * p_mvolt, uint8_t count, uint8_t * p_buffer, size_t buffer_size)
+{
+    size_t len = 0;
+
+    if ((count == 0) || (buffer_size < (BATCH_HEADER_LEN + (num_sensors * sizeof(int16_t)))))
+    {
+        return 0;
+    }
+
+    len += uint16_write(first_index, &p_buffer[len]);
+    p_buffer[len++] = count;
+
+    for (uint8_t c = 0; c < num_sensors; c++)
+    {
+        len += uint16_write((uint16_t)p_mvolt[c], &p_buffer[len]);
+    }
+
+    for (size_t i = num_sensors; i < ((size_t)count * num_sensors); i++)
+    {
+        uint16_t value = zigzag_encode((int16_t)(p_mvolt[i] - p_mvolt[i - num_sensors]));
+
+        do
+        {
+            if (len >= buffer_size)
+            {
+                return 0;
+            }
+
+            p_buffer[len++] = (uint8_t)((value & 0x7F) | ((value > 0x7F) ? 0x80 : 0));
+            value >>= 7;
+        } while (value != 0);
+    }
+
+    return len;
+}
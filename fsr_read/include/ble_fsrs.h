@@ -14,16 +14,44 @@
                                              0x6F, 0x8B, 0x01, 0x4E, 0x00, 0x00, 0x1B, 0x6C}
 #define FSRS_UUID_SERVICE                    (0x0001)
 #define FSRS_UUID_DATA_CHAR                  (0x0002)
+#define FSRS_UUID_PROBE_CHAR                 (0x0003)
+
+//Data characteristic layout: one int16 mV value per sensor followed by the uint16 sample index
+#define FSRS_DATA_LEN(num_sensors)           ((num_sensors)*sizeof(int16_t) + sizeof(uint16_t))
+#define FSRS_DATA_MAX_LEN                    (20) //Default ATT MTU (23) minus the notification header
+
+//Latency probe characteristic layout (little endian)
+//Write:  uint16 nonce, uint32 phone timestamp
+//Notify: the written value followed by uint16 sample index, uint16 residency ticks, uint16 sample age ticks
+#define FSRS_PROBE_WRITE_LEN                 (6)
+#define FSRS_PROBE_ECHO_LEN                  (12)
 
 
 //Forward declaration of the service type ble_fsrs_t
 typedef struct ble_fsrs_s ble_fsrs_t;
 
+typedef struct
+{
+    uint16_t    nonce;              //Chosen by the phone, echoed unchanged
+    uint32_t    phone_timestamp;    //Phone clock when the probe was written, echoed unchanged
+} ble_fsrs_probe_t;
+
+typedef struct
+{
+    ble_fsrs_probe_t    probe;
+    uint16_t            sample_index;       //Index of the first sample taken after the probe arrived
+    uint16_t            residency_ticks;    //RTC2 ticks from the probe write to the echo
+    uint16_t            sample_age_ticks;   //RTC2 ticks from the end of that sample's conversion to the echo
+} ble_fsrs_probe_echo_t;
+
 typedef void (*ble_fsrs_data_subscr_handler_t) (ble_fsrs_t * p_fsrs, bool is_data_subscr);
 
+typedef void (*ble_fsrs_probe_write_handler_t) (ble_fsrs_t * p_fsrs, ble_fsrs_probe_t const * p_probe);
+
 typedef struct
 {
     ble_fsrs_data_subscr_handler_t      data_subscr_handler;
+    ble_fsrs_probe_write_handler_t      probe_write_handler;
     fsr_data_t *                        p_fsr_data_init;
 } ble_fsrs_init_t;
 
@@ -31,9 +59,11 @@ struct ble_fsrs_s
 {
     uint16_t                            service_handle;
     ble_gatts_char_handles_t            data_char_handles;
+    ble_gatts_char_handles_t            probe_char_handles;
     uint8_t                             uuid_type;
     uint16_t                            conn_handle;
     ble_fsrs_data_subscr_handler_t      data_subscr_handler;
+    ble_fsrs_probe_write_handler_t      probe_write_handler;
 };
 
 uint32_t ble_fsrs_init(ble_fsrs_t * p_fsrs, const ble_fsrs_init_t * p_fsrs_init);
@@ -42,4 +72,6 @@ void ble_fsrs_on_ble_evt(ble_fsrs_t * p_fsrs, ble_evt_t * p_ble_evt);
 
 uint32_t ble_fsrs_data_notify(ble_fsrs_t * p_fsrs, fsr_data_t * p_fsr_data);
 
+uint32_t ble_fsrs_probe_notify(ble_fsrs_t * p_fsrs, ble_fsrs_probe_echo_t const * p_echo);
+
 #endif //BLE_FSRS_H__
@@ -47,6 +47,8 @@
 
 #include <stdint.h>
 
+#define COUNTER_MASK (0x00FFFFFF) //The RTC counter is 24 bits, mask tick differences with this to handle the wrap
+
 /**@brief   Function for initializing the RTC driver instance. */
 void counter_init(void);
 
@@ -4,7 +4,7 @@
 
 #include <stdint.h>
 
-typedef void (*fsr_adc_evt_handler_t) (int16_t * p_voltage_results); //Calculated in mV
+typedef void (*fsr_adc_evt_handler_t) (int16_t * p_voltage_results, uint16_t sample_index, uint32_t sample_ticks); //Calculated in mV. Ticks are the RTC2 counter at the end of the conversion
 
 typedef struct
 {
@@ -18,8 +18,6 @@ void fsr_adc_sample_begin(void);
 
 void fsr_adc_sample_end(void);
 
-void check_saadc_done_sample(void);
-
-void check_saadc_calibration(void);
+void fsr_adc_sample_force(void); //The next sample is passed to the handler even if contact gating would skip it
 
 #endif //FSR_ADC_H__
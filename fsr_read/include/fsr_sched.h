@@ -0,0 +1,76 @@
+#ifndef FSR_SCHED_H__
+#define FSR_SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fsr_config.h"
+
+//Work handed from interrupt context to the main loop
+typedef enum
+{
+    FSR_EVT_SAMPLE_READY,       //SAADC finished a sample of every channel
+    FSR_EVT_CALIBRATION_DUE,    //SAADC was stopped so the offset calibration can run
+    FSR_EVT_TX_COMPLETE,        //SoftDevice freed notification buffers
+    FSR_EVT_CONTROL_WRITE,      //The phone turned data notifications on or off
+    FSR_EVT_PROBE_WRITE,        //The phone wrote a latency probe
+    FSR_EVT_SYNTH_TICK,         //Time for the next synthetic sample (FSR_SYNTH_ENABLED)
+    FSR_EVT_COUNT
+} fsr_evt_type_t;
+
+typedef struct
+{
+    fsr_evt_type_t type;
+    union
+    {
+        struct
+        {
+            int16_t     mvolt[NUM_FSR_SENSORS];
+            uint16_t    sample_index;
+            uint32_t    ticks;              //RTC2 counter when the conversion finished
+            uint8_t     contact_mask;       //Channels in contact as of this sample
+        } sample;                           //FSR_EVT_SAMPLE_READY
+
+        struct
+        {
+            uint8_t     count;
+        } tx_complete;                      //FSR_EVT_TX_COMPLETE
+
+        struct
+        {
+            bool        is_data_subscr;
+        } control_write;                    //FSR_EVT_CONTROL_WRITE
+
+        struct
+        {
+            uint16_t    nonce;
+            uint32_t    phone_timestamp;
+            uint32_t    ticks;              //RTC2 counter when the write arrived
+        } probe_write;                      //FSR_EVT_PROBE_WRITE
+    } params;
+} fsr_evt_t;
+
+typedef void (*fsr_evt_handler_t) (fsr_evt_t * p_evt);
+
+//Queue and handler timing instrumentation. Times are RTC2 ticks (32768 Hz)
+typedef struct
+{
+    uint16_t    queue_depth;                        //Events currently waiting
+    uint16_t    max_queue_depth;                    //Deepest the queue has been
+    uint32_t    dropped_count;                      //Events lost because the queue was full
+    uint32_t    evt_count[FSR_EVT_COUNT];           //Events handled per type
+    uint32_t    max_handler_ticks[FSR_EVT_COUNT];   //Longest handler run per type
+    uint32_t    overrun_count[FSR_EVT_COUNT];       //Handler runs longer than SCHED_HANDLER_BUDGET_TICKS
+} fsr_sched_stats_t;
+
+void fsr_sched_init(void);
+
+void fsr_sched_handler_set(fsr_evt_type_t type, fsr_evt_handler_t handler);
+
+uint32_t fsr_sched_event_put(fsr_evt_t const * p_evt); //Safe to call from interrupt context
+
+void fsr_sched_execute(void);
+
+void fsr_sched_stats_get(fsr_sched_stats_t * p_stats);
+
+#endif //FSR_SCHED_H__
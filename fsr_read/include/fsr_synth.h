@@ -0,0 +1,34 @@
+#ifndef FSR_SYNTH_H__
+#define FSR_SYNTH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fsr_adc.h"
+
+//Deterministic data that replaces the SAADC samples for throughput tests (FSR_SYNTH_ENABLED in fsr_config.h)
+typedef enum
+{
+    FSR_SYNTH_PATTERN_RAMP,     //Sawtooth over the full mV range, the second channel half a period behind
+    FSR_SYNTH_PATTERN_STRIKE,   //Repeated heel strike stride template
+    FSR_SYNTH_PATTERN_COUNTER   //Channel 0 is the sample index and channel 1 its complement, so the phone can check every packet
+} fsr_synth_pattern_t;
+
+typedef struct
+{
+    fsr_synth_pattern_t     pattern;
+    uint32_t                sample_period_ticks;    //app_timer ticks between samples. 0 leaves the pacing to the caller through fsr_synth_sample_next()
+    fsr_adc_evt_handler_t   evt_handler;            //Same handler the ADC uses, so the samples go through the real notification path
+} fsr_synth_init_t;
+
+void fsr_synth_init(fsr_synth_init_t * p_synth_init);
+
+void fsr_synth_sample_begin(void);
+
+void fsr_synth_sample_end(void);
+
+bool fsr_synth_is_running(void);
+
+void fsr_synth_sample_next(void); //Generates one sample and passes it to the handler right away
+
+#endif //FSR_SYNTH_H__
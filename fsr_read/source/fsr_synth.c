@@ -0,0 +1,137 @@
+// fsr_synth.c
+
+#include "fsr_synth.h"
+#include "fsr_config.h"
+#include "fsr_sched.h"
+#include "counter.h"
+
+#include "app_timer.h"
+#include "app_error.h"
+
+#define SYNTH_MAX_MV (3300)                 //VDD, the top of the SAADC range
+#define SYNTH_RAMP_STEP_MV (165)            //21 samples per ramp, 0 to SYNTH_MAX_MV inclusive
+
+//One heel strike stride at 20 Hz (1 s), heel first then the forefoot rolls through
+static const int16_t m_strike_template[][NUM_FSR_SENSORS] =
+{
+    {   0,    0}, {   0,    0}, {   0,    0}, {   0,    0}, {   0,    0},
+    {1250,    0}, {2650,  150}, {3050,  600}, {2950, 1650}, {2400, 2700},
+    {1500, 3050}, { 600, 3100}, {   0, 2900}, {   0, 1850}, {   0,  550},
+    {   0,    0}, {   0,    0}, {   0,    0}, {   0,    0}, {   0,    0}
+};
+
+#define STRIKE_TEMPLATE_LEN (sizeof(m_strike_template) / sizeof(m_strike_template[0]))
+
+APP_TIMER_DEF(m_synth_timer);
+
+static fsr_synth_pattern_t      m_pattern;
+static uint32_t                 m_sample_period_ticks;
+static fsr_adc_evt_handler_t    m_synth_callback;
+static uint16_t                 m_sample_index = 0;
+static bool                     m_running = false;
+
+//Runs in the RTC1 interrupt, the sample itself is made in main context like a real one
+static void synth_timer_handler(void * p_context)
+{
+    fsr_evt_t tick_evt = { .type = FSR_EVT_SYNTH_TICK };
+
+    fsr_sched_event_put(&tick_evt); //If the queue is full the tick is dropped and counted in the scheduler stats
+}
+
+static void synth_tick_handler(fsr_evt_t * p_evt)
+{
+    if (m_running)
+    {
+        fsr_synth_sample_next();
+    }
+}
+
+//Fills one mV value per sensor for the given sample
+static void synth_pattern_fill(uint16_t sample_index, int16_t * p_mvolt)
+{
+    switch (m_pattern)
+    {
+        case FSR_SYNTH_PATTERN_RAMP:
+        {
+            uint16_t steps = (SYNTH_MAX_MV / SYNTH_RAMP_STEP_MV) + 1;
+
+            for (uint8_t i = 0; i < NUM_FSR_SENSORS; i++)
+            {
+                uint16_t step = (sample_index + (i * steps / 2)) % steps;
+                p_mvolt[i] = (int16_t)(step * SYNTH_RAMP_STEP_MV);
+            }
+        } break;
+
+        case FSR_SYNTH_PATTERN_STRIKE:
+        {
+            for (uint8_t i = 0; i < NUM_FSR_SENSORS; i++)
+            {
+                p_mvolt[i] = m_strike_template[sample_index % STRIKE_TEMPLATE_LEN][i];
+            }
+        } break;
+
+        case FSR_SYNTH_PATTERN_COUNTER:
+        default:
+        {
+            for (uint8_t i = 0; i < NUM_FSR_SENSORS; i++)
+            {
+                p_mvolt[i] = (int16_t)((i % 2) ? ~sample_index : sample_index);
+            }
+        } break;
+    }
+}
+
+void fsr_synth_init(fsr_synth_init_t * p_params)
+{
+    m_pattern = p_params->pattern;
+    m_sample_period_ticks = p_params->sample_period_ticks;
+    m_synth_callback = p_params->evt_handler;
+
+    fsr_sched_handler_set(FSR_EVT_SYNTH_TICK, synth_tick_handler);
+
+    if (m_sample_period_ticks > 0)
+    {
+        uint32_t err_code = app_timer_create(&m_synth_timer, APP_TIMER_MODE_REPEATED, synth_timer_handler);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+//Start generating when enabled via CCCD. Every run starts from the beginning of the pattern
+void fsr_synth_sample_begin(void)
+{
+    m_sample_index = 0;
+    m_running = true;
+
+    if (m_sample_period_ticks > 0)
+    {
+        uint32_t err_code = app_timer_start(m_synth_timer, m_sample_period_ticks, NULL);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+//Stop generating when disabled via CCCD
+void fsr_synth_sample_end(void)
+{
+    m_running = false;
+
+    if (m_sample_period_ticks > 0)
+    {
+        uint32_t err_code = app_timer_stop(m_synth_timer);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+bool fsr_synth_is_running(void)
+{
+    return m_running;
+}
+
+void fsr_synth_sample_next(void)
+{
+    int16_t mvolt[NUM_FSR_SENSORS];
+
+    m_sample_index++;
+    synth_pattern_fill(m_sample_index, mvolt);
+
+    m_synth_callback(mvolt, m_sample_index, counter_get());
+}
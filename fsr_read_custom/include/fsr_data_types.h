@@ -7,6 +7,7 @@ typedef struct
 {
     int16_t *   p_fsr_data_array;
     uint16_t    fsr_data_array_size;
+    uint16_t    sample_index; //Wrapping count of ADC samples, lets the phone account for samples that were not notified
 } fsr_data_t;
 
 #endif //FSR_DATA_TYPES_H__
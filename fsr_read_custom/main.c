@@ -53,7 +53,7 @@
 #include <string.h>
 #include <stdbool.h>
 
-#include "fsr_adc.h"
+#include "fsr_sched.h"
 
 #include "app_error.h"
 #include "fsr_ble.h"
@@ -102,13 +102,12 @@ static void power_manage(void)
  */
 int main(void)
 {
+    fsr_sched_init();
     fsr_ble_init();
     for (;;)
     {
-        //Check if ADC is done a sample and send a notification. Notification will finish before returning
-        check_saadc_done_sample();
-        //Check if the ADC needs calibration. Calibration will finish before returning
-        check_saadc_calibration();
+        //Run the events queued from interrupt context (samples, calibration, TX complete, control writes) until the queue is empty
+        fsr_sched_execute();
 
 #ifdef USE_LOG
         if (!NRF_LOG_PROCESS())
@@ -15,4 +15,18 @@
 
 #define POWER_PIN_PERIOD_DIFF (1) //Number of ms power is turned on before sampling
 
+#define CONTACT_THRESHOLD_MV (413) //Below this the phone treats the FSR as unloaded (~no force)
+#define CONTACT_HYSTERESIS_MV (50) //A channel must drop this far below the threshold before its contact is released
+#define CONTACT_HOLD_SAMPLES (5) //Samples still streamed after release so the phone sees the foot come up (>= phone force FIFO size)
+#define HEARTBEAT_PERIOD_SAMPLES (20) //While idle, only one sample in this many is notified
+// 20 samples is 1 Hz at 20 Hz sampling
+
+#define SCHED_QUEUE_SIZE (16) //Events that can wait for the main loop, about 0.8 s of samples at 20 Hz
+#define SCHED_HANDLER_BUDGET_TICKS (164) //RTC2 ticks (32768 Hz) a handler may run before it is counted as an overrun (~5 ms)
+
+#define FSR_SYNTH_ENABLED (0) //1 streams generated data instead of the SAADC samples, for throughput and packet loss tests
+#define FSR_SYNTH_PATTERN (FSR_SYNTH_PATTERN_COUNTER) //See fsr_synth_pattern_t
+#define FSR_SYNTH_PERIOD_MS (0) //Time between generated samples. 0 sends as fast as the SoftDevice frees notification buffers
+#define FSR_SYNTH_BURST_MAX (8) //Most samples generated per TX complete when FSR_SYNTH_PERIOD_MS is 0
+
 #endif
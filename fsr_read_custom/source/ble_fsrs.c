@@ -6,6 +6,45 @@
 #include "sdk_common.h"
 #include "ble_srv_common.h"
 
+/**@brief Function for packing fsr data into the characteristic value layout.
+ *
+ * @param[in]  p_fsr_data  FSR data to be packed.
+ * @param[out] p_encoded   Buffer of at least FSRS_DATA_MAX_LEN bytes.
+ *
+ * @return Number of bytes written.
+ */
+static uint16_t fsr_data_encode(fsr_data_t const * p_fsr_data, uint8_t * p_encoded)
+{
+    uint16_t samples_len = (p_fsr_data->fsr_data_array_size)*(sizeof(int16_t));
+
+    memcpy(p_encoded, p_fsr_data->p_fsr_data_array, samples_len);
+    uint16_encode(p_fsr_data->sample_index, &p_encoded[samples_len]);
+
+    return FSRS_DATA_LEN(p_fsr_data->fsr_data_array_size);
+}
+
+
+/**@brief Function for packing a latency probe echo into the characteristic value layout.
+ *
+ * @param[in]  p_echo     Probe echo to be packed.
+ * @param[out] p_encoded  Buffer of at least FSRS_PROBE_ECHO_LEN bytes.
+ *
+ * @return Number of bytes written.
+ */
+static uint16_t probe_echo_encode(ble_fsrs_probe_echo_t const * p_echo, uint8_t * p_encoded)
+{
+    uint16_t len = 0;
+
+    len += uint16_encode(p_echo->probe.nonce, &p_encoded[len]);
+    len += uint32_encode(p_echo->probe.phone_timestamp, &p_encoded[len]);
+    len += uint16_encode(p_echo->sample_index, &p_encoded[len]);
+    len += uint16_encode(p_echo->residency_ticks, &p_encoded[len]);
+    len += uint16_encode(p_echo->sample_age_ticks, &p_encoded[len]);
+
+    return len;
+}
+
+
 /**@brief Function for handling the @ref BLE_GAP_EVT_CONNECTED event from the S110 SoftDevice.
  *
  * @param[in] p_fsrs     FSR Service structure.
@@ -46,6 +85,19 @@ static void on_write(ble_fsrs_t * p_fsrs, ble_evt_t * p_ble_evt)
     {
         p_fsrs->data_subscr_handler(p_fsrs, *(p_evt_write->data));
     }
+    else if (
+             (p_evt_write->handle == p_fsrs->probe_char_handles.value_handle) &&
+             (p_evt_write->len == FSRS_PROBE_WRITE_LEN) &&
+             (p_fsrs->probe_write_handler != NULL)
+            )
+    {
+        ble_fsrs_probe_t probe;
+
+        probe.nonce           = uint16_decode(&p_evt_write->data[0]);
+        probe.phone_timestamp = uint32_decode(&p_evt_write->data[2]);
+
+        p_fsrs->probe_write_handler(p_fsrs, &probe);
+    }
 }
 
 
@@ -63,6 +115,8 @@ static uint32_t data_char_add(ble_fsrs_t * p_fsrs, const ble_fsrs_init_t * p_fsr
     ble_gatts_attr_t    attr_char_value;
     ble_uuid_t          ble_uuid;
     ble_gatts_attr_md_t attr_md;
+    uint8_t             init_value[FSRS_DATA_MAX_LEN];
+    uint16_t            init_len;
 
     memset(&cccd_md, 0, sizeof(cccd_md));
 
@@ -94,14 +148,16 @@ static uint32_t data_char_add(ble_fsrs_t * p_fsrs, const ble_fsrs_init_t * p_fsr
     attr_md.wr_auth = 0;
     attr_md.vlen    = 0;
 
+    init_len = fsr_data_encode(p_fsrs_init->p_fsr_data_init, init_value);
+
     memset(&attr_char_value, 0, sizeof(attr_char_value));
 
     attr_char_value.p_uuid    = &ble_uuid;
     attr_char_value.p_attr_md = &attr_md;
-    attr_char_value.init_len  = (p_fsrs_init->p_fsr_data_init->fsr_data_array_size)*(sizeof(int16_t));
+    attr_char_value.init_len  = init_len;
     attr_char_value.init_offs = 0;
-    attr_char_value.max_len   = (p_fsrs_init->p_fsr_data_init->fsr_data_array_size)*(sizeof(int16_t));
-    attr_char_value.p_value   = (uint8_t*)(p_fsrs_init->p_fsr_data_init->p_fsr_data_array);
+    attr_char_value.max_len   = init_len;
+    attr_char_value.p_value   = init_value;
 
     return sd_ble_gatts_characteristic_add(p_fsrs->service_handle,
                                            &char_md,
@@ -110,6 +166,70 @@ static uint32_t data_char_add(ble_fsrs_t * p_fsrs, const ble_fsrs_init_t * p_fsr
 }
 
 
+/**@brief Function for adding the latency probe characteristic.
+ *
+ * @details The phone writes a probe without response and the echo comes back as a notification.
+ *
+ * @param[in] p_fsrs  FSR Service structure.
+ *
+ * @return NRF_SUCCESS on success, otherwise an error code.
+ */
+static uint32_t probe_char_add(ble_fsrs_t * p_fsrs)
+{
+    ble_gatts_char_md_t char_md;
+    ble_gatts_attr_md_t cccd_md;
+    ble_gatts_attr_t    attr_char_value;
+    ble_uuid_t          ble_uuid;
+    ble_gatts_attr_md_t attr_md;
+    uint8_t             init_value[FSRS_PROBE_ECHO_LEN];
+
+    memset(&cccd_md, 0, sizeof(cccd_md));
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.write_perm);
+    cccd_md.vloc = BLE_GATTS_VLOC_STACK;
+
+    memset(&char_md, 0, sizeof(char_md));
+
+    char_md.char_props.write         = 1;
+    char_md.char_props.write_wo_resp = 1;
+    char_md.char_props.notify        = 1;
+    char_md.p_char_user_desc         = NULL;
+    char_md.p_char_pf                = NULL;
+    char_md.p_user_desc_md           = NULL;
+    char_md.p_cccd_md                = &cccd_md;
+    char_md.p_sccd_md                = NULL;
+
+    ble_uuid.type = p_fsrs->uuid_type;
+    ble_uuid.uuid = FSRS_UUID_PROBE_CHAR;
+
+    memset(&attr_md, 0, sizeof(attr_md));
+
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.write_perm);
+
+    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
+    attr_md.rd_auth = 0;
+    attr_md.wr_auth = 0;
+    attr_md.vlen    = 1; //Written with the short probe, notified with the longer echo
+
+    memset(init_value, 0, sizeof(init_value));
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+
+    attr_char_value.p_uuid    = &ble_uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.init_len  = FSRS_PROBE_ECHO_LEN;
+    attr_char_value.init_offs = 0;
+    attr_char_value.max_len   = FSRS_PROBE_ECHO_LEN;
+    attr_char_value.p_value   = init_value;
+
+    return sd_ble_gatts_characteristic_add(p_fsrs->service_handle,
+                                           &char_md,
+                                           &attr_char_value,
+                                           &p_fsrs->probe_char_handles);
+}
+
+
 void ble_fsrs_on_ble_evt(ble_fsrs_t * p_fsrs, ble_evt_t * p_ble_evt)
 {
     if ((p_fsrs == NULL) || (p_ble_evt == NULL))
@@ -150,6 +270,7 @@ uint32_t ble_fsrs_init(ble_fsrs_t * p_fsrs, const ble_fsrs_init_t * p_fsrs_init)
     // Initialize the service structure.
     p_fsrs->conn_handle             = BLE_CONN_HANDLE_INVALID;
     p_fsrs->data_subscr_handler     = p_fsrs_init->data_subscr_handler;
+    p_fsrs->probe_write_handler     = p_fsrs_init->probe_write_handler;
 
     // Add a custom base UUID.
     err_code = sd_ble_uuid_vs_add(&base_uuid, &p_fsrs->uuid_type);
@@ -164,23 +285,44 @@ uint32_t ble_fsrs_init(ble_fsrs_t * p_fsrs, const ble_fsrs_init_t * p_fsrs_init)
                                         &p_fsrs->service_handle);
     VERIFY_SUCCESS(err_code);
 
-    // Add Characteristic.
+    // Add Characteristics.
     err_code = data_char_add(p_fsrs, p_fsrs_init);
     VERIFY_SUCCESS(err_code);
 
+    err_code = probe_char_add(p_fsrs);
+    VERIFY_SUCCESS(err_code);
+
     return NRF_SUCCESS;
 }
 
-//Notifies the mV ADC data (one value per sensor)
+//Notifies the mV ADC data (one value per sensor) and the sample index
 uint32_t ble_fsrs_data_notify(ble_fsrs_t * p_fsrs, fsr_data_t * p_fsr_data)
 {
     ble_gatts_hvx_params_t hvx_params;
-    uint16_t               length = (p_fsr_data->fsr_data_array_size)*(sizeof(int16_t));
+    uint8_t                encoded[FSRS_DATA_MAX_LEN];
+    uint16_t               length = fsr_data_encode(p_fsr_data, encoded);
 
     memset(&hvx_params, 0, sizeof(hvx_params));
 
     hvx_params.handle = p_fsrs->data_char_handles.value_handle;
-    hvx_params.p_data = (uint8_t *)(p_fsr_data->p_fsr_data_array);
+    hvx_params.p_data = encoded;
+    hvx_params.p_len  = &length;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+
+    return sd_ble_gatts_hvx(p_fsrs->conn_handle, &hvx_params);
+}
+
+//Notifies the echo of a latency probe, tagged with the sample it was matched to
+uint32_t ble_fsrs_probe_notify(ble_fsrs_t * p_fsrs, ble_fsrs_probe_echo_t const * p_echo)
+{
+    ble_gatts_hvx_params_t hvx_params;
+    uint8_t                encoded[FSRS_PROBE_ECHO_LEN];
+    uint16_t               length = probe_echo_encode(p_echo, encoded);
+
+    memset(&hvx_params, 0, sizeof(hvx_params));
+
+    hvx_params.handle = p_fsrs->probe_char_handles.value_handle;
+    hvx_params.p_data = encoded;
     hvx_params.p_len  = &length;
     hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
 
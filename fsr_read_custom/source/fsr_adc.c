@@ -4,12 +4,15 @@
 
 #include "fsr_adc.h"
 #include "fsr_config.h"
+#include "fsr_sched.h"
+#include "counter.h"
 
 #include "nrf_drv_saadc.h"
 #include "nrf_drv_ppi.h"
 #include "nrf_drv_timer.h"
 #include "nrf_drv_gpiote.h"
 #include "nrf_delay.h"
+#include "app_util_platform.h"
 
 #include "sdk_config.h"
 
@@ -17,7 +20,6 @@
 
 #ifdef ADC_PRINT_HELP
     #include "nrf_log.h"
-    #include "counter.h"
 #endif
 
 #define SAMPLES_IN_BUFFER NUM_FSR_SENSORS
@@ -25,15 +27,20 @@
 
 #define PERIODIC_POWER
 
+//Inverse of the mV conversion in saadc_callback(), used to program the channel limits in raw ADC counts
+#define MV_TO_ADC_RESULT(mv) ((int16_t)(((mv)*1024*0.25)/825))
+
 static const nrf_drv_timer_t    m_timer = NRF_DRV_TIMER_INSTANCE(1);
 static nrf_saadc_value_t        m_buffer_pool[2][SAMPLES_IN_BUFFER]; // nrf_saadc_value_t is int16_t
 static uint32_t                 m_adc_evt_counter = (SAADC_CALIBRATION_INTERVAL - 1);
-static bool                     m_saadc_calibrate = false;
-static bool                     m_done_sample = false;
 static nrf_ppi_channel_t        m_ppi_channel_saadc_sample;
 static uint32_t                 m_sample_period;
-static int16_t                  m_adc_results_mvolt[SAMPLES_IN_BUFFER]; //Stores the mV values that will be notified
 static fsr_adc_evt_handler_t    m_adc_callback;
+static uint16_t                 m_sample_index = 0; //Wrapping count of completed samples, sent with every notification
+static volatile uint8_t         m_contact_mask = 0; //Bit per channel, set while the channel is above the contact threshold. Updated in the SAADC interrupt and reset from main context by fsr_adc_sample_begin, samples carry their own copy
+static uint8_t                  m_contact_hold = 0; //Samples left to stream after the last contact was released
+static uint16_t                 m_heartbeat_count = 0; //Samples since the last notification while idle
+static bool                     m_sample_forced = false; //Set by fsr_adc_sample_force(), cleared by the next sample
 
 // If using periodic power source, the timer event turns on power to the circuit
 static void timer_handler_SAADC(nrf_timer_event_t event_type, void * p_context)
@@ -51,6 +58,83 @@ static void timer_handler_SAADC(nrf_timer_event_t event_type, void * p_context)
 
 }
 
+//Arms the channel limit for the next crossing: LIMITH while the channel is idle, LIMITL while it is in contact
+static void contact_limits_set(uint8_t channel, bool in_contact)
+{
+    if (in_contact)
+    {
+        nrf_drv_saadc_limits_set(channel,
+                                 MV_TO_ADC_RESULT(CONTACT_THRESHOLD_MV - CONTACT_HYSTERESIS_MV),
+                                 NRF_DRV_SAADC_LIMITH_DISABLED);
+    }
+    else
+    {
+        nrf_drv_saadc_limits_set(channel,
+                                 NRF_DRV_SAADC_LIMITL_DISABLED,
+                                 MV_TO_ADC_RESULT(CONTACT_THRESHOLD_MV));
+    }
+}
+
+//Puts every channel back in the idle state. The first sample after a reset is always notified
+static void contact_detection_reset(void)
+{
+    m_contact_mask = 0;
+    m_contact_hold = 0;
+    m_heartbeat_count = HEARTBEAT_PERIOD_SAMPLES - 1;
+
+    for (uint8_t i = 0; i < SAMPLES_IN_BUFFER; i++)
+    {
+        contact_limits_set(i, false);
+    }
+}
+
+//Contact state as of the sample that just finished. The driver reports DONE before the limit events raised by the same
+//sample, so those are still pending in the SAADC and are applied to a copy of the mask here. The driver clears them afterwards
+static uint8_t contact_mask_for_sample(void)
+{
+    uint8_t contact_mask = m_contact_mask;
+
+    for (uint8_t i = 0; i < SAMPLES_IN_BUFFER; i++)
+    {
+        if (nrf_saadc_event_check(nrf_saadc_event_limit_get(i, NRF_SAADC_LIMIT_HIGH)))
+        {
+            contact_mask |= (1 << i);
+        }
+        else if (nrf_saadc_event_check(nrf_saadc_event_limit_get(i, NRF_SAADC_LIMIT_LOW)))
+        {
+            contact_mask &= ~(1 << i);
+        }
+    }
+
+    return contact_mask;
+}
+
+//Decides if a sample is notified: densely during and just after contact, at the heartbeat rate otherwise
+static bool contact_sample_is_streamed(uint8_t contact_mask)
+{
+    if (contact_mask != 0)
+    {
+        m_contact_hold = CONTACT_HOLD_SAMPLES;
+        m_heartbeat_count = 0;
+        return true;
+    }
+
+    if (m_contact_hold > 0)
+    {
+        m_contact_hold--;
+        return true;
+    }
+
+    m_heartbeat_count++;
+    if (m_heartbeat_count >= HEARTBEAT_PERIOD_SAMPLES)
+    {
+        m_heartbeat_count = 0;
+        return true;
+    }
+
+    return false;
+}
+
 //Sets both buffers up for sample conversion when the ADC is restarted
 static void convert_buffers(void)
 {
@@ -61,6 +145,14 @@ static void convert_buffers(void)
     APP_ERROR_CHECK(err_code);
 }
 
+//Restarts the conversions of a stopped SAADC without calibrating, used when the calibration event cannot be queued.
+//Calibration is due again after another SAADC_CALIBRATION_INTERVAL samples
+static void calibration_skip(void)
+{
+    m_adc_evt_counter = 0;
+    convert_buffers();
+}
+
 //Handler for SAADC events: full sample buffer or calibration complete
 static void saadc_callback(nrf_drv_saadc_evt_t const * p_event)
 {
@@ -81,15 +173,22 @@ static void saadc_callback(nrf_drv_saadc_evt_t const * p_event)
 #endif
 
         m_adc_evt_counter++;
+        m_sample_index++;
 
 #ifdef ADC_PRINT_HELP
     NRF_LOG_INFO("Sample %d\r\n", m_adc_evt_counter);
 #endif
 
+        fsr_evt_t sample_evt;
+        sample_evt.type = FSR_EVT_SAMPLE_READY;
+        sample_evt.params.sample.sample_index = m_sample_index;
+        sample_evt.params.sample.ticks = counter_get();
+        sample_evt.params.sample.contact_mask = contact_mask_for_sample();
+
         for (uint8_t i = 0; i < SAMPLES_IN_BUFFER; i++)
         {
             float f_value = ((float)(p_event->data.done.p_buffer[i]))*0.825/(0.25*1024);
-            m_adc_results_mvolt[i] = (int16_t)(f_value*1000);
+            sample_evt.params.sample.mvolt[i] = (int16_t)(f_value*1000);
              //1000 is the V to mV conversion
              //Formula according to spec: RESULT = (V(p)-V(n))*GAIN/Reference*2^(Resolution-Mode)
              // V(p) = (RESULT * Reference) / (GAIN*2^(Resolution-Mode))
@@ -103,7 +202,7 @@ static void saadc_callback(nrf_drv_saadc_evt_t const * p_event)
    NRF_LOG_INFO("mV Calculated\r\n");
 #endif
 
-        m_done_sample = true;
+        fsr_sched_event_put(&sample_evt); //If the queue is full the sample is dropped and counted in the scheduler stats
 
         if(m_adc_evt_counter == SAADC_CALIBRATION_INTERVAL) //Evaluate if offset calibration should be performed. Configure the SAADC_CALIBRATION_INTERVAL constant to change the calibration frequency
         {
@@ -118,7 +217,11 @@ static void saadc_callback(nrf_drv_saadc_evt_t const * p_event)
     NRF_LOG_INFO("Abort End\r\n");
 #endif
 
-            m_saadc_calibrate = true; //Set flag to trigger calibration in main context when SAADC is stopped
+            fsr_evt_t calibration_evt = { .type = FSR_EVT_CALIBRATION_DUE };
+            if (fsr_sched_event_put(&calibration_evt) != NRF_SUCCESS) //Calibration runs in main context once the SAADC is stopped
+            {
+                calibration_skip(); //Nothing would restart the stopped SAADC
+            }
         }
         else
         {
@@ -150,18 +253,83 @@ static void saadc_callback(nrf_drv_saadc_evt_t const * p_event)
         m_adc_evt_counter = 0;
     }
 
+    else if (p_event->type == NRF_DRV_SAADC_EVT_LIMIT) //A channel crossed the contact threshold. Handled in the same interrupt as the sample, before main() sees it
+    {
+        uint8_t channel_mask = (1 << p_event->data.limit.channel);
+        bool    in_contact   = (p_event->data.limit.limit_type == NRF_SAADC_LIMIT_HIGH);
+
+        if (in_contact)
+        {
+            m_contact_mask |= channel_mask;
+        }
+        else
+        {
+            m_contact_mask &= ~channel_mask;
+        }
+
+        contact_limits_set(p_event->data.limit.channel, in_contact);
+    }
+
 #ifdef ADC_PRINT_HELP
     NRF_LOG_INFO("Callback End\r\n");
 #endif
 
 }
 
+//Notifies a finished sample if it is in a contact window or due as a heartbeat. Runs from the scheduler in main context
+static void sample_ready_handler(fsr_evt_t * p_evt)
+{
+    bool is_streamed = contact_sample_is_streamed(p_evt->params.sample.contact_mask); //Always evaluated so a forced sample does not disturb the hold and heartbeat counts
+
+    if (is_streamed || m_sample_forced)
+    {
+        m_sample_forced = false;
+
+#ifdef ADC_PRINT_HELP
+    NRF_LOG_INFO("Notify Start\r\n");
+#endif
+
+        m_adc_callback(p_evt->params.sample.mvolt, p_evt->params.sample.sample_index, p_evt->params.sample.ticks);
+
+#ifdef ADC_PRINT_HELP
+    NRF_LOG_INFO("Notify Done\r\n");
+#endif
+
+    }
+}
+
+//Triggers the offset calibration. If the SAADC is still busy the event is queued again instead of spinning, so other events get a turn
+static void calibration_due_handler(fsr_evt_t * p_evt)
+{
+
+#ifdef ADC_PRINT_HELP
+    NRF_LOG_INFO("Calibrate Start\r\n");
+#endif
+
+    if (nrf_drv_saadc_calibrate_offset() != NRF_SUCCESS)
+    {
+        if (fsr_sched_event_put(p_evt) != NRF_SUCCESS)
+        {
+            calibration_skip(); //Nothing would restart the stopped SAADC
+        }
+        return;
+    }
+
+#ifdef ADC_PRINT_HELP
+    NRF_LOG_INFO("Calibrate Done\r\n");
+#endif
+
+}
+
 //Initialize the Timer, PPI, SAADC driver, SAADC channels and RAM buffers
 void fsr_adc_init(fsr_adc_init_t * p_params)
 {
     m_sample_period = p_params->sample_period_ms;
     m_adc_callback = p_params->evt_handler;
 
+    fsr_sched_handler_set(FSR_EVT_SAMPLE_READY, sample_ready_handler);
+    fsr_sched_handler_set(FSR_EVT_CALIBRATION_DUE, calibration_due_handler);
+
     ret_code_t err_code;
     err_code = nrf_drv_ppi_init();
     APP_ERROR_CHECK(err_code);
@@ -236,6 +404,8 @@ void fsr_adc_init(fsr_adc_init_t * p_params)
     err_code = nrf_drv_saadc_channel_init(1, &channel1_config);
     APP_ERROR_CHECK(err_code);
 
+    contact_detection_reset();
+
     convert_buffers();
 }
 
@@ -243,6 +413,12 @@ void fsr_adc_init(fsr_adc_init_t * p_params)
 void fsr_adc_sample_begin(void)
 {
     ret_code_t err_code;
+
+    //A conversion started before sampling was last stopped can still complete, so keep its interrupt from interleaving with the reset
+    CRITICAL_REGION_ENTER();
+    contact_detection_reset();
+    CRITICAL_REGION_EXIT();
+    m_sample_forced = false;
     nrf_drv_timer_enable(&m_timer);
     err_code = nrf_drv_ppi_channel_enable(m_ppi_channel_saadc_sample);
     APP_ERROR_CHECK(err_code);
@@ -263,42 +439,8 @@ void fsr_adc_sample_end(void)
 
 }
 
-//When flag set to true, notify the new adc result. Function is called from main() loop
-void check_saadc_done_sample(void)
+//Used by the latency probe so its echo always has a notified sample to be matched with
+void fsr_adc_sample_force(void)
 {
-    if (m_done_sample == true)
-    {
-
-#ifdef ADC_PRINT_HELP
-    NRF_LOG_INFO("Notify Start\r\n");
-#endif
-
-        m_adc_callback(m_adc_results_mvolt);
-
-#ifdef ADC_PRINT_HELP
-    NRF_LOG_INFO("Notify Done\r\n");
-#endif
-
-        m_done_sample = false;
-    }
-}
-
-//When flag set to true, perform a calibration. Function is called from main() loop
-void check_saadc_calibration(void)
-{
-    if (m_saadc_calibrate == true)
-    {
-
-#ifdef ADC_PRINT_HELP
-    NRF_LOG_INFO("Calibrate Start\r\n");
-#endif
-
-        while(nrf_drv_saadc_calibrate_offset() != NRF_SUCCESS); //Trigger calibration task
-
- #ifdef ADC_PRINT_HELP
-     NRF_LOG_INFO("Calibrate Done\r\n");
- #endif
-        m_saadc_calibrate = false;
-
-    }
+    m_sample_forced = true;
 }
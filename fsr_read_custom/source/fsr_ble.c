@@ -7,6 +7,9 @@
 #include "fsr_ble.h"
 #include "fsr_adc.h"
 #include "fsr_config.h"
+#include "fsr_sched.h"
+#include "fsr_synth.h"
+#include "counter.h"
 
 #include "nordic_common.h"
 #include "nrf.h"
@@ -27,7 +30,6 @@
     #define NRF_LOG_MODULE_NAME "FSR APP"
     #include "nrf_log.h"
     #include "nrf_log_ctrl.h"
-    #include "counter.h"
 #endif
 
 #define IS_SRVC_CHANGED_CHARACT_PRESENT 0                                           /**< Include the service_changed characteristic. If not enabled, the server's database cannot be changed for the lifetime of the device. */
@@ -57,6 +59,8 @@
 #define NEXT_CONN_PARAMS_UPDATE_DELAY   APP_TIMER_TICKS(30000, APP_TIMER_PRESCALER) /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
 #define MAX_CONN_PARAMS_UPDATE_COUNT    3                                           /**< Number of attempts before giving up the connection parameter negotiation. */
 
+#define PROBE_TICKS_MAX                 (0xFFFF)                                    /**< Probe tick fields are 16 bits (2 s at 32768 Hz), longer times are clamped. */
+
 //From PCA10040
 #define NRF_CLOCK_LFCLKSRC      {.source        = NRF_CLOCK_LF_SRC_XTAL,            \
                                  .rc_ctiv       = 0,                                \
@@ -66,7 +70,18 @@
 static uint16_t                         m_conn_handle = BLE_CONN_HANDLE_INVALID;    /**< Handle of the current connection. */
 static ble_fsrs_t                       m_fsrs;                                      /**< Structure to identify the Nordic UART Service. */
 
-static void adc_complete_handler(int16_t * p_voltage_result);
+static int16_t                          m_pending_data[NUM_FSR_SENSORS];             /**< Latest sample waiting for the SoftDevice to free a buffer. Newer samples replace it so they never go out ahead of it. */
+static uint16_t                         m_pending_sample_index;
+static uint32_t                         m_pending_sample_ticks;
+static bool                             m_notify_pending = false;
+static volatile bool                    m_is_data_subscr = false;                    /**< Follows the CCCD and the connection in SoftDevice interrupt context, ahead of the queued control events. */
+
+static ble_fsrs_probe_t                 m_probe;                                     /**< Latency probe waiting for the next sample. */
+static uint32_t                         m_probe_ticks;                               /**< RTC2 counter when the probe was written. */
+static bool                             m_probe_pending = false;
+
+static void adc_complete_handler(int16_t * p_voltage_result, uint16_t sample_index, uint32_t sample_ticks);
+static void sample_notify(int16_t * p_voltage_result, uint16_t sample_index, uint32_t sample_ticks);
 
 static fsr_adc_init_t m_adc_init =
 {
@@ -74,6 +89,10 @@ static fsr_adc_init_t m_adc_init =
     .evt_handler      = adc_complete_handler
 };
 
+#if (FSR_SYNTH_ENABLED == 1)
+static void synth_burst(void);
+#endif
+
 /**@brief Function for the GAP initialization.
  *
  * @details This function will set up all the necessary GAP (Generic Access Profile) parameters of
@@ -103,18 +122,122 @@ static void gap_params_init(void)
     APP_ERROR_CHECK(err_code);
 }
 
-// Called when the CCCD is written to. Either starts ADC sampling and notifications or stops the ADC
+// Called when the CCCD is written to. Runs in SoftDevice interrupt context so the start/stop is queued for the main loop
 void data_subscr_handler(ble_fsrs_t * p_fsrs, bool is_data_subscr)
 {
-    if (is_data_subscr)
+    m_is_data_subscr = is_data_subscr;
+
+    fsr_evt_t control_evt;
+    control_evt.type = FSR_EVT_CONTROL_WRITE;
+    control_evt.params.control_write.is_data_subscr = is_data_subscr;
+
+    uint32_t err_code = fsr_sched_event_put(&control_evt);
+    APP_ERROR_CHECK(err_code); //Losing a start/stop would leave the ADC in the wrong state
+}
+
+// Either starts ADC sampling and notifications or stops the ADC
+static void control_write_handler(fsr_evt_t * p_evt)
+{
+    if (p_evt->params.control_write.is_data_subscr)
     {
+#if (FSR_SYNTH_ENABLED == 1)
+        fsr_synth_sample_begin();
+        synth_burst();
+#else
         fsr_adc_sample_begin();
+#endif
     }
     else
     {
+        m_notify_pending = false;
+        m_probe_pending = false;
+#if (FSR_SYNTH_ENABLED == 1)
+        fsr_synth_sample_end();
+#else
         fsr_adc_sample_end();
+#endif
+    }
+}
+
+// The SoftDevice has free buffers again, so retry the sample that did not fit
+static void tx_complete_handler(fsr_evt_t * p_evt)
+{
+    int16_t pending_data[NUM_FSR_SENSORS];
+
+    if (m_notify_pending)
+    {
+        m_notify_pending = false;
+        memcpy(pending_data, m_pending_data, sizeof(pending_data));
+        sample_notify(pending_data, m_pending_sample_index, m_pending_sample_ticks);
+    }
+
+#if (FSR_SYNTH_ENABLED == 1)
+    synth_burst();
+#endif
+}
+
+#if (FSR_SYNTH_ENABLED == 1)
+// Without a sample period the generator is paced by the flow control: samples are made until the SoftDevice is out of buffers.
+// The sample that did not fit is kept as pending and goes out on the next TX complete, so nothing is lost
+static void synth_burst(void)
+{
+    if (FSR_SYNTH_PERIOD_MS != 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; (i < FSR_SYNTH_BURST_MAX) && !m_notify_pending && fsr_synth_is_running(); i++)
+    {
+        fsr_synth_sample_next();
     }
 }
+#endif
+
+// Called when the phone writes a latency probe. Runs in SoftDevice interrupt context, so only the arrival time is taken here
+void probe_write_handler(ble_fsrs_t * p_fsrs, ble_fsrs_probe_t const * p_probe)
+{
+    fsr_evt_t probe_evt;
+    probe_evt.type = FSR_EVT_PROBE_WRITE;
+    probe_evt.params.probe_write.nonce = p_probe->nonce;
+    probe_evt.params.probe_write.phone_timestamp = p_probe->phone_timestamp;
+    probe_evt.params.probe_write.ticks = counter_get();
+
+    fsr_sched_event_put(&probe_evt); //A dropped probe times out on the phone
+}
+
+// Holds the probe until the next sample, which is forced through the contact gating so the echo and the data can be matched
+static void probe_handler(fsr_evt_t * p_evt)
+{
+    m_probe.nonce = p_evt->params.probe_write.nonce;
+    m_probe.phone_timestamp = p_evt->params.probe_write.phone_timestamp;
+    m_probe_ticks = p_evt->params.probe_write.ticks;
+    m_probe_pending = true; //A newer probe replaces one still waiting
+
+    fsr_adc_sample_force();
+}
+
+// RTC2 ticks from start_ticks until now, clamped to the 16 bit probe fields
+static uint16_t probe_ticks_since(uint32_t start_ticks)
+{
+    uint32_t ticks = (counter_get() - start_ticks) & COUNTER_MASK;
+
+    return (uint16_t)MIN(ticks, PROBE_TICKS_MAX);
+}
+
+// Echoes the pending probe tagged with the sample that is about to be notified
+static void probe_echo_send(uint16_t sample_index, uint32_t sample_ticks)
+{
+    ble_fsrs_probe_echo_t echo;
+
+    echo.probe = m_probe;
+    echo.sample_index = sample_index;
+    echo.residency_ticks = probe_ticks_since(m_probe_ticks);
+    echo.sample_age_ticks = probe_ticks_since(sample_ticks);
+
+    m_probe_pending = false;
+
+    ble_fsrs_probe_notify(&m_fsrs, &echo); //A failed echo times out on the phone
+}
 
 /**@brief Function for initializing services that will be used by the application.
  */
@@ -127,11 +250,13 @@ static void services_init(void)
     fsr_data_t init_data =
     {
         .p_fsr_data_array = init_data_array,
-        .fsr_data_array_size = NUM_FSR_SENSORS
+        .fsr_data_array_size = NUM_FSR_SENSORS,
+        .sample_index = 0
     };
 
     memset(&fsrs_init, 0, sizeof(fsrs_init));
     fsrs_init.data_subscr_handler = data_subscr_handler;
+    fsrs_init.probe_write_handler = probe_write_handler;
     fsrs_init.p_fsr_data_init = &init_data;
 
     err_code = ble_fsrs_init(&m_fsrs, &fsrs_init);
@@ -245,9 +370,25 @@ static void on_ble_evt(ble_evt_t * p_ble_evt)
             break; // BLE_GAP_EVT_CONNECTED
 
         case BLE_GAP_EVT_DISCONNECTED:
+        {
             m_conn_handle = BLE_CONN_HANDLE_INVALID;
-            fsr_adc_sample_end();
-            break; // BLE_GAP_EVT_DISCONNECTED
+            m_is_data_subscr = false;
+
+            // Same as the phone turning notifications off
+            fsr_evt_t control_evt;
+            control_evt.type = FSR_EVT_CONTROL_WRITE;
+            control_evt.params.control_write.is_data_subscr = false;
+            err_code = fsr_sched_event_put(&control_evt);
+            APP_ERROR_CHECK(err_code);
+        } break; // BLE_GAP_EVT_DISCONNECTED
+
+        case BLE_EVT_TX_COMPLETE:
+        {
+            fsr_evt_t tx_evt;
+            tx_evt.type = FSR_EVT_TX_COMPLETE;
+            tx_evt.params.tx_complete.count = p_ble_evt->evt.common_evt.params.tx_complete.count;
+            fsr_sched_event_put(&tx_evt); //A lost TX complete only delays the retry until the next one
+        } break; // BLE_EVT_TX_COMPLETE
 
         case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
             // Pairing not supported
@@ -377,27 +518,77 @@ static void ble_stack_init(void)
     APP_ERROR_CHECK(err_code);
 }
 
-// Prints out and notifies the calculated mV ACD values (one value per enabled ADC pin)
-static void adc_complete_handler(int16_t * p_voltage_result)
+// Keeps a sample to be notified on the next TX complete event, replacing any older one still waiting
+static void sample_pending_set(int16_t * p_voltage_result, uint16_t sample_index, uint32_t sample_ticks)
+{
+    memcpy(m_pending_data, p_voltage_result, sizeof(m_pending_data));
+    m_pending_sample_index = sample_index;
+    m_pending_sample_ticks = sample_ticks;
+    m_notify_pending = true;
+}
+
+// Notifies a sample, or keeps it as pending if the SoftDevice is out of buffers
+static void sample_notify(int16_t * p_voltage_result, uint16_t sample_index, uint32_t sample_ticks)
 {
     uint32_t err_code;
     fsr_data_t fsr_data =
     {
         .p_fsr_data_array = p_voltage_result,
-        .fsr_data_array_size = NUM_FSR_SENSORS
+        .fsr_data_array_size = NUM_FSR_SENSORS,
+        .sample_index = sample_index
     };
 
+    // The echo goes out first so it never arrives after the data it refers to
+    if (m_probe_pending)
+    {
+        probe_echo_send(sample_index, sample_ticks);
+    }
+
+    err_code = ble_fsrs_data_notify(&m_fsrs, &fsr_data);
+    switch (err_code)
+    {
+        case BLE_ERROR_NO_TX_PACKETS:
+            sample_pending_set(p_voltage_result, sample_index, sample_ticks);
+            break;
+
+        case NRF_ERROR_INVALID_STATE:
+        case BLE_ERROR_GATTS_SYS_ATTR_MISSING:
+            // The phone turned notifications off or disconnected, and the stop is still queued behind this sample.
+            // Samples are only taken while notifications are on, so any other cause is a bug
+            if (m_is_data_subscr)
+            {
+                APP_ERROR_CHECK(err_code);
+            }
+            m_notify_pending = false;
+            break;
+
+        default:
+            APP_ERROR_CHECK(err_code);
+            break;
+    }
+}
+
+// Prints out and notifies the calculated mV ACD values (one value per enabled ADC pin)
+static void adc_complete_handler(int16_t * p_voltage_result, uint16_t sample_index, uint32_t sample_ticks)
+{
     #ifdef ADC_PRINT
-    for (uint8_t i = 0; i < fsr_data.fsr_data_array_size; i++)
+    for (uint8_t i = 0; i < NUM_FSR_SENSORS; i++)
     {
-        int16_t test = fsr_data.p_fsr_data_array[i];
+        int16_t test = p_voltage_result[i];
         NRF_LOG_RAW_INFO("%d ", test);
     }
     NRF_LOG_RAW_INFO("\r\n");
     #endif
 
-    err_code = ble_fsrs_data_notify(&m_fsrs, &fsr_data);
-    APP_ERROR_CHECK(err_code);
+    // An older sample is still waiting for a buffer. Sending this one first would deliver them out of order,
+    // so it replaces the older one and goes out on the next TX complete event instead
+    if (m_notify_pending)
+    {
+        sample_pending_set(p_voltage_result, sample_index, sample_ticks);
+        return;
+    }
+
+    sample_notify(p_voltage_result, sample_index, sample_ticks);
 }
 
 /**@brief Function for initializing the Advertising functionality.
@@ -439,11 +630,13 @@ void fsr_ble_init(void)
 {
     uint32_t err_code;
 
+    // RTC2 times the scheduler handlers (and the log when timestamps are enabled)
+    counter_init();
+    counter_start();
+
 #ifdef ADC_PRINT
 
 #if NRF_LOG_USES_TIMESTAMP==1
-    counter_init();
-    counter_start();
     err_code = NRF_LOG_INIT(counter_get);
     APP_ERROR_CHECK(err_code);
 #else
@@ -463,6 +656,20 @@ void fsr_ble_init(void)
 
     fsr_adc_init(&m_adc_init);
 
+#if (FSR_SYNTH_ENABLED == 1)
+    fsr_synth_init_t synth_init =
+    {
+        .pattern             = FSR_SYNTH_PATTERN,
+        .sample_period_ticks = APP_TIMER_TICKS(FSR_SYNTH_PERIOD_MS, APP_TIMER_PRESCALER),
+        .evt_handler         = adc_complete_handler
+    };
+    fsr_synth_init(&synth_init);
+#endif
+
+    fsr_sched_handler_set(FSR_EVT_CONTROL_WRITE, control_write_handler);
+    fsr_sched_handler_set(FSR_EVT_TX_COMPLETE, tx_complete_handler);
+    fsr_sched_handler_set(FSR_EVT_PROBE_WRITE, probe_handler);
+
     advertising_init();
     conn_params_init();
     err_code = ble_advertising_start(BLE_ADV_MODE_FAST);
@@ -0,0 +1,103 @@
+// fsr_sched.c
+
+#include <string.h>
+
+#include "fsr_sched.h"
+#include "counter.h"
+
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "app_error.h"
+
+static fsr_evt_handler_t    m_handlers[FSR_EVT_COUNT];
+static fsr_sched_stats_t    m_stats;
+
+//Runs one queued event in main context and records how long its handler took
+static void sched_dispatch(void * p_event_data, uint16_t event_size)
+{
+    fsr_evt_t * p_evt = (fsr_evt_t *)p_event_data;
+
+    CRITICAL_REGION_ENTER();
+    m_stats.queue_depth--;
+    CRITICAL_REGION_EXIT();
+
+    if ((event_size != sizeof(fsr_evt_t)) || (p_evt->type >= FSR_EVT_COUNT) || (m_handlers[p_evt->type] == NULL))
+    {
+        return;
+    }
+
+    uint32_t start_ticks = counter_get();
+
+    m_handlers[p_evt->type](p_evt);
+
+    uint32_t handler_ticks = (counter_get() - start_ticks) & COUNTER_MASK;
+
+    m_stats.evt_count[p_evt->type]++;
+
+    if (handler_ticks > m_stats.max_handler_ticks[p_evt->type])
+    {
+        m_stats.max_handler_ticks[p_evt->type] = handler_ticks;
+    }
+
+    if (handler_ticks > SCHED_HANDLER_BUDGET_TICKS)
+    {
+        m_stats.overrun_count[p_evt->type]++;
+    }
+}
+
+void fsr_sched_init(void)
+{
+    memset(m_handlers, 0, sizeof(m_handlers));
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    APP_SCHED_INIT(sizeof(fsr_evt_t), SCHED_QUEUE_SIZE);
+}
+
+void fsr_sched_handler_set(fsr_evt_type_t type, fsr_evt_handler_t handler)
+{
+    if (type < FSR_EVT_COUNT)
+    {
+        m_handlers[type] = handler;
+    }
+}
+
+//Copies the event into the queue. The depth is counted before the put so the main loop can never see it go negative
+uint32_t fsr_sched_event_put(fsr_evt_t const * p_evt)
+{
+    uint32_t err_code;
+
+    CRITICAL_REGION_ENTER();
+
+    m_stats.queue_depth++;
+    err_code = app_sched_event_put(p_evt, sizeof(fsr_evt_t), sched_dispatch);
+
+    if (err_code == NRF_SUCCESS)
+    {
+        if (m_stats.queue_depth > m_stats.max_queue_depth)
+        {
+            m_stats.max_queue_depth = m_stats.queue_depth;
+        }
+    }
+    else
+    {
+        m_stats.queue_depth--;
+        m_stats.dropped_count++;
+    }
+
+    CRITICAL_REGION_EXIT();
+
+    return err_code;
+}
+
+//Called from the main() loop. Returns when the queue is empty
+void fsr_sched_execute(void)
+{
+    app_sched_execute();
+}
+
+void fsr_sched_stats_get(fsr_sched_stats_t * p_stats)
+{
+    CRITICAL_REGION_ENTER();
+    *p_stats = m_stats;
+    CRITICAL_REGION_EXIT();
+}